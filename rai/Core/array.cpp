@@ -64,6 +64,129 @@ const char* arrayElemsep=", ";
 const char* arrayLinesep=",\n ";
 const char* arrayBrackets="[]";
 
+//===========================================================================
+//
+// array memory: every buffer carries a small header, telling whether it is pooled (and in
+// which size class) or a plain malloc of the requested size
+//
+
+namespace {
+
+struct ArrayBlock {
+  uint32_t sizeClass; ///< size class index, or 'unpooled'
+  uint32_t magic;
+  ArrayBlock* next;   ///< next block in a free list
+};
+static_assert(sizeof(ArrayBlock)==16, "the header has to preserve malloc's alignment");
+
+const uint32_t arrayBlockMagic=0x41727221, unpooled=uint32_t(-1);
+const uint minClassBits=6, numClasses=15; //size classes 64B, 128B, ..., 1MB
+
+uint32_t sizeClassOf(size_t bytes) {
+  uint32_t c=0;
+  while(c<numClasses && (size_t(1)<<(minClassBits+c))<bytes) c++;
+  return c<numClasses ? c : unpooled;
+}
+
+size_t classBytes(uint32_t c) { return size_t(1)<<(minClassBits+c); }
+
+// trivially destructible on purpose: arrays of static storage duration may be freed after the
+// thread_local storage of the main thread is gone; the free lists are emptied when the outermost
+// guard goes out of scope, so there is nothing to clean up at thread exit
+struct ArrayPool {
+  uint depth=0;                      ///< number of alive ArrayArena guards
+  ArrayBlock* head[numClasses]= {};  ///< free lists
+  uint64_t cached=0, hits=0, misses=0;
+
+  void release() {
+    for(ArrayBlock*& h:head) while(h) { ArrayBlock* b=h; h=b->next; ::free(b); }
+    cached=0;
+  }
+};
+
+thread_local ArrayPool arrayPool;
+static_assert(std::is_trivially_destructible<ArrayPool>::value, "");
+
+ArrayBlock* header(void* p) {
+  ArrayBlock* b = (ArrayBlock*)p - 1;
+  CHECK_EQ(b->magic, arrayBlockMagic, "this is not array memory");
+  return b;
+}
+
+}
+
+void* arrayMalloc(size_t bytes) {
+  ArrayPool& P = arrayPool;
+  ArrayBlock* b=0;
+  uint32_t c = P.depth ? sizeClassOf(bytes) : unpooled;
+  if(c!=unpooled) {
+    if(P.head[c]) { //recycle
+      b = P.head[c];
+      P.head[c] = b->next;
+      P.cached -= classBytes(c);
+      P.hits++;
+      return b+1;
+    }
+    P.misses++;
+    bytes = classBytes(c);
+  }
+  b = (ArrayBlock*)malloc(sizeof(ArrayBlock)+bytes);
+  if(!b) HALT("memory allocation failed! Wanted size = " <<bytes <<"bytes");
+  b->sizeClass = c;
+  b->magic = arrayBlockMagic;
+  b->next = 0;
+  return b+1;
+}
+
+void* arrayRealloc(void* p, size_t bytes) {
+  if(!p) return arrayMalloc(bytes);
+  ArrayBlock* b = header(p);
+  if(b->sizeClass==unpooled) {
+    b = (ArrayBlock*)realloc(b, sizeof(ArrayBlock)+bytes);
+    if(!b) HALT("memory allocation failed! Wanted size = " <<bytes <<"bytes");
+    return b+1;
+  }
+  size_t capacity = classBytes(b->sizeClass);
+  if(bytes<=capacity && (bytes>capacity/2 || !b->sizeClass)) return p; //still the right size class
+  void* q = arrayMalloc(bytes);
+  memmove(q, p, bytes<capacity ? bytes : capacity);
+  arrayFree(p);
+  return q;
+}
+
+void arrayFree(void* p) {
+  if(!p) return;
+  ArrayBlock* b = header(p);
+  ArrayPool& P = arrayPool;
+  if(b->sizeClass!=unpooled && P.depth && P.cached+classBytes(b->sizeClass)<=ArrayArena::maxCachedBytes) {
+    b->next = P.head[b->sizeClass];
+    P.head[b->sizeClass] = b;
+    P.cached += classBytes(b->sizeClass);
+    return;
+  }
+  ::free(b);
+}
+
+uint64_t ArrayArena::maxCachedBytes = 1ull<<26;
+
+ArrayArena::ArrayArena() { arrayPool.depth++; }
+
+ArrayArena::~ArrayArena() {
+  ArrayPool& P = arrayPool;
+  P.depth--;
+  if(!P.depth) P.release();
+}
+
+bool ArrayArena::active() { return arrayPool.depth>0; }
+
+void ArrayArena::release() { arrayPool.release(); }
+
+uint64_t ArrayArena::cachedBytes() { return arrayPool.cached; }
+
+uint64_t ArrayArena::hits() { return arrayPool.hits; }
+
+uint64_t ArrayArena::misses() { return arrayPool.misses; }
+
 //===========================================================================
 }
 
@@ -135,6 +258,12 @@ template<> SparseMatrix& Array<double>::sparse() {
     } else {
       nd=2;
     }
+  } else if(isCSRMatrix(*this)) { //the non-zeros stay where they are, only the index changes
+    intA elems = dynamic_cast<CSRMatrix*>(special)->getElems();
+    delete special;
+    special = 0;
+    s = new SparseMatrix(*this);
+    s->elems = elems;
   } else {
     s = dynamic_cast<SparseMatrix*>(special);
     CHECK(s, "");
@@ -178,6 +307,41 @@ template<> const RowShifted& Array<double>::rowShifted() const{
   return *r;
 }
 
+/// make compressed sparse row: from dense or SparseMatrix
+template<> CSRMatrix& Array<double>::csr() {
+  CSRMatrix* s;
+  if(!special) {
+    s = new CSRMatrix(*this);
+    if(N) {
+      CHECK_EQ(nd, 2, "");
+      arr copy;
+      copy.swap(*this);
+      s->setFromDense(copy);
+    } else {
+      s->resize(nd==2?d0:0, nd==2?d1:0);
+    }
+  } else if(isSparseMatrix(*this)) {
+    arr values;
+    values.swap(*this);
+    intA elems = dynamic_cast<SparseMatrix*>(special)->elems;
+    delete special;
+    special = 0;
+    s = new CSRMatrix(*this);
+    s->setFromTriplets(values.d0, values.d1, elems, values);
+  } else {
+    s = dynamic_cast<CSRMatrix*>(special);
+    CHECK(s, "");
+  }
+  return *s;
+}
+
+template<> const CSRMatrix& Array<double>::csr() const {
+  CHECK(isCSRMatrix(*this), "");
+  CSRMatrix* s = dynamic_cast<CSRMatrix*>(special);
+  CHECK(s, "");
+  return *s;
+}
+
 /// attach jacobian
 template<> Array<double>& Array<double>::J() {
   if(!jac){
@@ -205,7 +369,9 @@ template<> Array<double> Array<double>::J_reset() {
   template<> SparseMatrix& Array<type>::sparse() { NIY; return *(new SparseMatrix(NoArr)); } \
   template<> const SparseMatrix& Array<type>::sparse() const{ NIY; return *(new SparseMatrix(NoArr)); } \
   template<> RowShifted& Array<type>::rowShifted() { NIY; return *(new RowShifted(NoArr)); } \
-  template<> const RowShifted& Array<type>::rowShifted() const{ NIY; return *(new RowShifted(NoArr)); }
+  template<> const RowShifted& Array<type>::rowShifted() const{ NIY; return *(new RowShifted(NoArr)); } \
+  template<> CSRMatrix& Array<type>::csr() { NIY; return *(new CSRMatrix(NoArr)); } \
+  template<> const CSRMatrix& Array<type>::csr() const{ NIY; return *(new CSRMatrix(NoArr)); }
 NONSENSE(float)
 NONSENSE(uint)
 NONSENSE(int)
@@ -1220,6 +1386,10 @@ void sparseProduct(arr& y, arr& A, const arr& x) {
     op_innerProduct(y, A, x);
     return;
   }
+  if(isCSRMatrix(A) && !x.special) {
+    y = A.csr().A_x(x);
+    return;
+  }
 #if 0
   NIY; //replace by Eigen
 #else
@@ -1335,7 +1505,8 @@ arr finiteDifferenceJacobian(const fct& f, const arr& _x, arr& Janalytic) {
   y = f(x);
   Janalytic = y.J_reset();
   if(isRowShifted(Janalytic)
-      || isSparseMatrix(Janalytic)) {
+      || isSparseMatrix(Janalytic)
+      || isCSRMatrix(Janalytic)) {
     Janalytic = unpack(Janalytic);
   }
 
@@ -1607,6 +1778,11 @@ arr lapack_Ainv_b_sym(const arr& A, const arr& b) {
   if(isSparseMatrix(A)) {
     return eigen_Ainv_b(A, b);
   }
+  if(isCSRMatrix(A)) {
+    arr S = A;
+    S.sparse();
+    return eigen_Ainv_b(S, b);
+  }
   arr x;
   if(b.nd==2) { //b is a matrix (unusual) repeat for each col:
     RAI_MSG("TODO: directly call lapack with the matrix!")
@@ -1776,6 +1952,12 @@ void lapack_mldivide(arr& X, const arr& A, const arr& B) {
     X = eigen_Ainv_b(A, B);
     return;
   }
+  if(isCSRMatrix(A)) {
+    arr S = A;
+    S.sparse();
+    X = eigen_Ainv_b(S, B);
+    return;
+  }
 
   CHECK_EQ(A.nd, 2, "A in Ax=b must be a NxN matrix.");
   CHECK_EQ(A.d0, A.d1, "A in Ax=b must be square matrix.");
@@ -2139,9 +2321,11 @@ void rai::RowShifted::computeColPatches(bool assumeMonotonic) {
   }
 }
 
-arr rai::RowShifted::At_A() {
+arr rai::RowShifted::At_A(const arr& rowWeights) {
   //TODO use blas DSYRK instead?
   CHECK_EQ(rowLen.N, rowShift.N, "");
+  const double* w = !!rowWeights ? rowWeights.p : 0;
+  if(w) CHECK_EQ(rowWeights.N, Z.d0, "");
   arr R;
   rai::RowShifted& R_ = R.rowShifted();
   R_.resize(Z.d1, Z.d1, rowSize);
@@ -2151,13 +2335,15 @@ arr rai::RowShifted::At_A() {
   R_.symmetric=true;
   if(!rowSize) return R; //Z is identically zero, all rows fully packed -> return zero R
   for(uint i=0; i<Z.d0; i++) {
+    double wi = w ? w[i] : 1.;
+    if(wi==0.) continue;
     uint rs=rowShift.p[i];
     uint rl=rowLen.p[i];
     double* Zi = Z.p+i*rowSize;
     for(uint j=0; j<rl/*rowSize*/; j++) {
       uint real_j=j+rs;
       if(real_j>=Z.d1) break;
-      double Zij=Zi[j];
+      double Zij=wi*Zi[j];
       if(Zij!=0.) {
         double* Rp=R.p + real_j*R_.rowSize;
         double* Jp=Zi+j;
@@ -2701,7 +2887,7 @@ void SparseMatrix::add(const SparseMatrix& a, uint lo0, uint lo1, double coeff){
   Z.resizeMEM(Nold+a.Z.N, true);
   memmove(Z.p+Nold, a.Z.p, Z.sizeT*a.Z.N);
   elems.append(a.elems);
-  if(coeff){
+  if(coeff!=1.){
     for(double* x=&Z.elem(Nold); x!=Z.p+Z.N; x++) (*x) *= coeff;
   }
   if(lo0){
@@ -2751,7 +2937,7 @@ void SparseMatrix::add(const arr& B, uint lo0, uint lo1, double coeff){
       *(e++) = j;
     }
   }
-  if(coeff){
+  if(coeff!=1.){
     for(double* x=&Z.elem(Nold); x!=Z.p+Z.N; x++) (*x) *= coeff;
   }
   if(lo0){
@@ -2833,6 +3019,466 @@ void operator /= (rai::RowShifted& x, const rai::RowShifted& y) { NIY; }
 void operator /= (rai::RowShifted& x, double y) { x.memRef() /= y; }
 //void operator %= (rai::RowShifted& x, const rai::RowShifted& y){ NIY; }
 
+//===========================================================================
+//
+// CSRMatrix
+//
+
+namespace rai {
+
+CSRMatrix::CSRMatrix(arr& _Z) : Z(_Z) {
+  CHECK(!isSpecial(_Z), "only once yet");
+  type = CSRMatrixST;
+  Z.special = this;
+}
+
+CSRMatrix::CSRMatrix(arr& _Z, const CSRMatrix& s) : CSRMatrix(_Z) {
+  rowPtr = s.rowPtr;
+  colIdx = s.colIdx;
+}
+
+double* CSRMatrix::find(uint i, uint j) {
+  uint* c = std::lower_bound(colIdx.p+rowPtr.p[i], colIdx.p+rowPtr.p[i+1], j);
+  if(c==colIdx.p+rowPtr.p[i+1] || *c!=j) return nullptr;
+  return Z.p + (c-colIdx.p);
+}
+
+double CSRMatrix::elem(uint i, uint j) const {
+  double* x = ((CSRMatrix*)this)->find(i, j);
+  return x ? *x : 0.;
+}
+
+CSRMatrix& CSRMatrix::resize(uint d0, uint d1) {
+  Z.nd=2; Z.d0=d0; Z.d1=d1;
+  Z.resizeMEM(0, false);
+  rowPtr.resize(d0+1).setZero();
+  colIdx.clear();
+  return *this;
+}
+
+void CSRMatrix::setFromTriplets(uint d0, uint d1, const intA& elems, const arr& values, uintA& slots) {
+  CHECK(&values!=&Z, "can't initialize from yourself");
+  uint n = values.N;
+  CHECK_EQ(elems.N, 2*n, "");
+  //counting sort by column, then stable counting sort by row: row-major order with sorted columns
+  uintA colStart(d1+1), byCol(n), order(n);
+  colStart.setZero();
+  for(uint k=0; k<n; k++) colStart.p[elems.p[2*k+1]+1]++;
+  for(uint j=0; j<d1; j++) colStart.p[j+1] += colStart.p[j];
+  for(uint k=0; k<n; k++) byCol.p[colStart.p[elems.p[2*k+1]]++] = k;
+  rowPtr.resize(d0+1).setZero();
+  for(uint k=0; k<n; k++) rowPtr.p[elems.p[2*k]+1]++;
+  for(uint i=0; i<d0; i++) rowPtr.p[i+1] += rowPtr.p[i];
+  uintA next = rowPtr;
+  for(uint k:byCol) order.p[next.p[elems.p[2*k]]++] = k;
+  //copy, summing up duplicates
+  Z.nd=2; Z.d0=d0; Z.d1=d1;
+  Z.resizeMEM(n, false);
+  colIdx.resize(n);
+  if(!!slots) slots.resize(n);
+  uint m=0;
+  for(uint i=0; i<d0; i++) {
+    uint start=m;
+    for(uint l=rowPtr.p[i]; l<rowPtr.p[i+1]; l++) {
+      uint k = order.p[l];
+      uint j = elems.p[2*k+1];
+      if(m>start && colIdx.p[m-1]==j) {
+        Z.p[m-1] += values.p[k];
+        if(!!slots) slots.p[k] = m-1;
+        continue;
+      }
+      colIdx.p[m] = j;
+      Z.p[m] = values.p[k];
+      if(!!slots) slots.p[k] = m;
+      m++;
+    }
+    rowPtr.p[i] = start;
+  }
+  rowPtr.p[d0] = m;
+  if(m<n) { colIdx.resizeCopy(m); Z.resizeMEM(m, true); }
+}
+
+void CSRMatrix::setPattern(uint d0, uint d1, const uintA& _rowPtr, const uintA& _colIdx) {
+  CHECK_EQ(_rowPtr.N, d0+1, "");
+  CHECK_EQ(_rowPtr.last(), _colIdx.N, "");
+  Z.nd=2; Z.d0=d0; Z.d1=d1;
+  rowPtr = _rowPtr;
+  colIdx = _colIdx;
+  Z.resizeMEM(colIdx.N, false);
+  Z.setZero();
+}
+
+void CSRMatrix::setFromSparse(const SparseMatrix& S) {
+  setFromTriplets(S.Z.d0, S.Z.d1, S.elems, S.Z);
+}
+
+void CSRMatrix::setFromDense(const arr& X) {
+  CHECK_EQ(X.nd, 2, "");
+  CHECK(&Z!=&X, "can't initialize from yourself");
+  uint n=0;
+  for(const double& a:X) if(a) n++;
+  Z.nd=2; Z.d0=X.d0; Z.d1=X.d1;
+  Z.resizeMEM(n, false);
+  rowPtr.resize(X.d0+1);
+  colIdx.resize(n);
+  n=0;
+  for(uint i=0; i<X.d0; i++) {
+    rowPtr.p[i]=n;
+    for(uint j=0; j<X.d1; j++) {
+      double a = X.p[i*X.d1+j];
+      if(a) { colIdx.p[n]=j; Z.p[n]=a; n++; }
+    }
+  }
+  rowPtr.p[X.d0]=n;
+}
+
+void CSRMatrix::setScaledRows(const CSRMatrix& A, const intA& rows, const arr& scale) {
+  CHECK(&A!=this, "");
+  CHECK_EQ(rows.N, scale.N, "");
+  uint n=0;
+  for(int r:rows) if(r>=0) n += A.rowPtr.p[r+1]-A.rowPtr.p[r];
+  Z.nd=2; Z.d0=rows.N; Z.d1=A.Z.d1;
+  Z.resizeMEM(n, false);
+  rowPtr.resize(rows.N+1);
+  colIdx.resize(n);
+  n=0;
+  for(uint i=0; i<rows.N; i++) {
+    rowPtr.p[i]=n;
+    int r=rows.p[i];
+    if(r<0) continue;
+    double s=scale.p[i];
+    for(uint k=A.rowPtr.p[r]; k<A.rowPtr.p[r+1]; k++) { colIdx.p[n]=A.colIdx.p[k]; Z.p[n]=s*A.Z.p[k]; n++; }
+  }
+  rowPtr.p[rows.N]=n;
+}
+
+arr CSRMatrix::A_x(const arr& x) const {
+  CHECK_EQ(x.N, Z.d1, "");
+  arr y(Z.d0);
+  for(uint i=0; i<Z.d0; i++) {
+    double s=0.;
+    for(uint k=rowPtr.p[i]; k<rowPtr.p[i+1]; k++) s += Z.p[k]*x.p[colIdx.p[k]];
+    y.p[i]=s;
+  }
+  return y;
+}
+
+arr CSRMatrix::At_x(const arr& x) const {
+  CHECK_EQ(x.N, Z.d0, "");
+  arr y = zeros(Z.d1);
+  for(uint i=0; i<Z.d0; i++) {
+    double xi=x.p[i];
+    if(!xi) continue;
+    for(uint k=rowPtr.p[i]; k<rowPtr.p[i+1]; k++) y.p[colIdx.p[k]] += Z.p[k]*xi;
+  }
+  return y;
+}
+
+arr CSRMatrix::At() const {
+  arr X;
+  CSRMatrix& T = X.csr();
+  X.nd=2; X.d0=Z.d1; X.d1=Z.d0;
+  X.resizeMEM(Z.N, false);
+  T.colIdx.resize(Z.N);
+  T.rowPtr.resize(Z.d1+1).setZero();
+  for(uint k=0; k<Z.N; k++) T.rowPtr.p[colIdx.p[k]+1]++;
+  for(uint j=0; j<Z.d1; j++) T.rowPtr.p[j+1] += T.rowPtr.p[j];
+  uintA next = T.rowPtr;
+  for(uint i=0; i<Z.d0; i++) for(uint k=rowPtr.p[i]; k<rowPtr.p[i+1]; k++) {
+      uint l = next.p[colIdx.p[k]]++;
+      T.colIdx.p[l] = i;
+      X.p[l] = Z.p[k];
+    }
+  return X;
+}
+
+arr CSRMatrix::At_A(const arr& rowWeights) const {
+  //row j of A^T W A is sum_r A(r,j) W(r) A(r,:), where the rows r are those of column j: the rows of A^T
+  const double* wr = !!rowWeights ? rowWeights.p : 0;
+  if(wr) CHECK_EQ(rowWeights.N, Z.d0, "");
+  arr At = this->At();
+  const CSRMatrix& T = At.csr();
+  uint n=Z.d1;
+  arr X;
+  CSRMatrix& S = X.csr();
+  X.nd=2; X.d0=X.d1=n;
+  S.rowPtr.resize(n+1);
+  arr w = zeros(n);
+  intA mark(n);
+  mark = -1;
+  uintA nz;
+  for(uint j=0; j<n; j++) {
+    nz.clear();
+    mark.p[j]=j; nz.append(j); //the diagonal is always stored
+    for(uint l=T.rowPtr.p[j]; l<T.rowPtr.p[j+1]; l++) {
+      uint r = T.colIdx.p[l];
+      double a = At.p[l];
+      if(wr) a *= wr[r];
+      for(uint k=rowPtr.p[r]; k<rowPtr.p[r+1]; k++) {
+        uint c = colIdx.p[k];
+        if(mark.p[c]!=(int)j) { mark.p[c]=j; nz.append(c); }
+        w.p[c] += a*Z.p[k];
+      }
+    }
+    std::sort(nz.p, nz.p+nz.N);
+    S.rowPtr.p[j] = S.colIdx.N;
+    for(uint c:nz) { S.colIdx.append(c); X.resizeMEM(X.N+1, true); X.p[X.N-1]=w.p[c]; w.p[c]=0.; }
+  }
+  S.rowPtr.p[n] = S.colIdx.N;
+  return X;
+}
+
+void CSRMatrix::rowWiseMult(const arr& a) {
+  CHECK_EQ(a.N, Z.d0, "");
+  for(uint i=0; i<Z.d0; i++) for(uint k=rowPtr.p[i]; k<rowPtr.p[i+1]; k++) Z.p[k] *= a.p[i];
+}
+
+void CSRMatrix::addDiag(double a) {
+  uint n = Z.d0<Z.d1 ? Z.d0 : Z.d1;
+  for(uint i=0; i<n; i++) {
+    double* x = find(i, i);
+    CHECK(x, "diagonal entry (" <<i <<',' <<i <<") is not stored");
+    *x += a;
+  }
+}
+
+arr CSRMatrix::unsparse() const {
+  arr x = zeros(Z.d0, Z.d1);
+  for(uint i=0; i<Z.d0; i++) for(uint k=rowPtr.p[i]; k<rowPtr.p[i+1]; k++) x.p[i*Z.d1+colIdx.p[k]] = Z.p[k];
+  return x;
+}
+
+intA CSRMatrix::getElems() const {
+  intA elems(Z.N, 2);
+  for(uint i=0; i<Z.d0; i++) for(uint k=rowPtr.p[i]; k<rowPtr.p[i+1]; k++) {
+      elems.p[2*k] = i;
+      elems.p[2*k+1] = colIdx.p[k];
+    }
+  return elems;
+}
+
+void CSRMatrix::checkConsistency() const {
+  CHECK_EQ(this, Z.special, "");
+  CHECK_EQ(rowPtr.N, Z.d0+1, "");
+  CHECK_EQ(colIdx.N, Z.N, "");
+  CHECK_EQ(rowPtr.first(), 0, "");
+  CHECK_EQ(rowPtr.last(), Z.N, "");
+  for(uint i=0; i<Z.d0; i++) {
+    CHECK_LE(rowPtr(i), rowPtr(i+1), "");
+    for(uint k=rowPtr(i); k<rowPtr(i+1); k++) {
+      CHECK_LE(colIdx(k)+1, Z.d1, "");
+      if(k>rowPtr(i)) CHECK_LE(colIdx(k-1)+1, colIdx(k), "columns are not sorted or not unique");
+    }
+  }
+}
+
+//===========================================================================
+
+namespace {
+//breadth-first search from root; returns the number of levels, and in 'last' a node of minimal degree in the deepest level
+uint rcm_levels(const CSRMatrix& A, uint root, const uintA& degree, uintA& stamp, uint s, uintA& queue, uint& last) {
+  uint begin=0, end=0, depth=0;
+  queue.p[end++]=root;  stamp.p[root]=s;
+  while(begin<end) {
+    uint levelEnd=end;
+    last=queue.p[begin];
+    for(uint q=begin; q<levelEnd; q++) if(degree.p[queue.p[q]]<degree.p[last]) last=queue.p[q];
+    for(uint q=begin; q<levelEnd; q++) {
+      uint i=queue.p[q];
+      for(uint k=A.rowPtr.p[i]; k<A.rowPtr.p[i+1]; k++) {
+        uint j=A.colIdx.p[k];
+        if(stamp.p[j]!=s) { stamp.p[j]=s; queue.p[end++]=j; }
+      }
+    }
+    begin=levelEnd;
+    depth++;
+  }
+  return depth;
+}
+}
+
+uintA reverseCuthillMcKee(const CSRMatrix& A) {
+  uint n=A.Z.d0;
+  CHECK_EQ(A.Z.d1, n, "needs a square matrix");
+  uintA degree(n), stamp(n), queue(n), perm(n);
+  for(uint i=0; i<n; i++) degree.p[i] = A.rowPtr.p[i+1]-A.rowPtr.p[i];
+  stamp.setZero();
+  boolA done(n);
+  done.setZero();
+  uint s=0, m=0;
+  for(uint start=0; start<n; start++) if(!done.p[start]) {
+    //find a pseudo-peripheral root of this connected component
+    uint root=start, last, next;
+    uint depth = rcm_levels(A, root, degree, stamp, ++s, queue, last);
+    for(uint it=0; it<10; it++) {
+      uint d = rcm_levels(A, last, degree, stamp, ++s, queue, next);
+      if(d<=depth) break;
+      root=last;  depth=d;  last=next;
+    }
+    //Cuthill-McKee: breadth-first, visiting neighbors by increasing degree
+    uint begin=m;
+    perm.p[m++]=root;  done.p[root]=true;
+    for(; begin<m; begin++) {
+      uint i=perm.p[begin], m0=m;
+      for(uint k=A.rowPtr.p[i]; k<A.rowPtr.p[i+1]; k++) {
+        uint j=A.colIdx.p[k];
+        if(!done.p[j]) { done.p[j]=true; perm.p[m++]=j; }
+      }
+      std::sort(perm.p+m0, perm.p+m, [&degree](uint a, uint b) { return degree.p[a]<degree.p[b]; });
+    }
+  }
+  CHECK_EQ(m, n, "");
+  std::reverse(perm.p, perm.p+n);
+  return perm;
+}
+
+bool SparseCholesky::hasPattern(const CSRMatrix& A) const {
+  if(!analyses) return false;
+  if(A.rowPtr.N!=rowPtr.N || A.colIdx.N!=colIdx.N) return false;
+  if(memcmp(A.rowPtr.p, rowPtr.p, rowPtr.N*sizeof(uint))) return false;
+  if(memcmp(A.colIdx.p, colIdx.p, colIdx.N*sizeof(uint))) return false;
+  return true;
+}
+
+uint SparseCholesky::symbolic(const CSRMatrix& A, const uintA& _perm) {
+  uint n=A.Z.d0;
+  perm = _perm;
+  uintA pinv(n);
+  for(uint k=0; k<n; k++) pinv.p[perm.p[k]]=k;
+
+  //upper triangle of C = P A P^T by columns: column k of C is row perm(k) of A (A is symmetric)
+  Cp.resize(n+1);
+  Cp.p[0]=0;
+  for(uint k=0; k<n; k++) {
+    uint a=perm.p[k], c=0;
+    for(uint q=A.rowPtr.p[a]; q<A.rowPtr.p[a+1]; q++) if(pinv.p[A.colIdx.p[q]]<=k) c++;
+    Cp.p[k+1] = Cp.p[k]+c;
+  }
+  Ci.resize(Cp.p[n]);
+  Cmap.resize(Cp.p[n]);
+  for(uint k=0, c=0; k<n; k++) {
+    uint a=perm.p[k];
+    for(uint q=A.rowPtr.p[a]; q<A.rowPtr.p[a+1]; q++) {
+      uint i=pinv.p[A.colIdx.p[q]];
+      if(i<=k) { Ci.p[c]=i;  Cmap.p[c]=q;  c++; }
+    }
+  }
+
+  //elimination tree
+  intA parent(n), ancestor(n);
+  for(uint k=0; k<n; k++) {
+    parent.p[k]=-1;  ancestor.p[k]=-1;
+    for(uint q=Cp.p[k]; q<Cp.p[k+1]; q++) {
+      for(int i=Ci.p[q], inext; i!=-1 && i<(int)k; i=inext) {
+        inext = ancestor.p[i];
+        ancestor.p[i] = k;
+        if(inext==-1) parent.p[i] = k;
+      }
+    }
+  }
+
+  //pattern of each row of L: the nodes reached from C's column k in the elimination tree
+  uintA stamp(n), stack(n), path(n), colCount(n);
+  stamp.setZero();
+  colCount = 1;
+  Rp.resize(n+1);
+  Rp.p[0]=0;
+  Ri.clear();
+  for(uint k=0; k<n; k++) {
+    uint top=n;
+    stamp.p[k]=k+1;
+    for(uint q=Cp.p[k]; q<Cp.p[k+1]; q++) {
+      uint len=0;
+      for(uint i=Ci.p[q]; stamp.p[i]!=k+1; i=parent.p[i]) { path.p[len++]=i;  stamp.p[i]=k+1; }
+      while(len>0) stack.p[--top] = path.p[--len];
+    }
+    for(uint t=top; t<n; t++) { Ri.append(stack.p[t]);  colCount.p[stack.p[t]]++; }
+    Rp.p[k+1]=Ri.N;
+  }
+
+  //pattern of L by columns, in the order the entries are computed
+  Lp.resize(n+1);
+  Lp.p[0]=0;
+  for(uint k=0; k<n; k++) Lp.p[k+1] = Lp.p[k]+colCount.p[k];
+  Li.resize(Lp.p[n]);
+  uintA c(n);
+  for(uint k=0; k<n; k++) c.p[k]=Lp.p[k];
+  for(uint k=0; k<n; k++) {
+    for(uint t=Rp.p[k]; t<Rp.p[k+1]; t++) Li.p[c.p[Ri.p[t]]++] = k;
+    Li.p[c.p[k]++] = k;
+  }
+  Lx.resize(Li.N).setZero();
+  valid=false;
+  return Li.N;
+}
+
+void SparseCholesky::analyze(const CSRMatrix& A) {
+  uint n=A.Z.d0;
+  CHECK_EQ(A.Z.d1, n, "needs a square matrix");
+  //choose the ordering with less fill: reverse Cuthill-McKee or the given one (e.g. already banded KOMO problems)
+  uintA natural;
+  natural.setStraightPerm(n);
+  uint nnzNatural = symbolic(A, natural);
+  uint nnzRCM = symbolic(A, reverseCuthillMcKee(A));
+  if(nnzNatural<=nnzRCM) symbolic(A, natural);
+  rowPtr = A.rowPtr;
+  colIdx = A.colIdx;
+  analyses++;
+}
+
+bool SparseCholesky::factor(const arr& A) {
+  CHECK(isCSRMatrix(A), "");
+  const CSRMatrix& S = A.csr();
+  if(!hasPattern(S)) analyze(S);
+
+  //up-looking: row k of L is the solution of L[0:k,0:k] l = C[0:k,k]
+  valid=false; //Lx is overwritten in place, and only a complete factorization is usable
+  uint n=A.d0;
+  arr x(n);
+  x.setZero();
+  uintA c(n);
+  for(uint k=0; k<n; k++) c.p[k]=Lp.p[k];
+  for(uint k=0; k<n; k++) {
+    for(uint q=Cp.p[k]; q<Cp.p[k+1]; q++) x.p[Ci.p[q]] = A.p[Cmap.p[q]];
+    double d = x.p[k];
+    x.p[k] = 0.;
+    for(uint t=Rp.p[k]; t<Rp.p[k+1]; t++) {
+      uint i=Ri.p[t];
+      double lki = x.p[i]/Lx.p[Lp.p[i]];
+      x.p[i] = 0.;
+      for(uint p=Lp.p[i]+1; p<c.p[i]; p++) x.p[Li.p[p]] -= Lx.p[p]*lki;
+      d -= lki*lki;
+      Lx.p[c.p[i]++] = lki;
+    }
+    if(!(d>0.)) return false;
+    Lx.p[c.p[k]++] = sqrt(d);
+  }
+  factorizations++;
+  valid=true;
+  return true;
+}
+
+arr SparseCholesky::solve(const arr& b) const {
+  uint n=perm.N;
+  CHECK(valid, "no valid factorization -- the last factor() failed or was not called");
+  CHECK_EQ(b.N, n, "");
+  arr y(n);
+  for(uint k=0; k<n; k++) y.p[k] = b.p[perm.p[k]];
+  for(uint j=0; j<n; j++) { //L y = P b
+    y.p[j] /= Lx.p[Lp.p[j]];
+    for(uint p=Lp.p[j]+1; p<Lp.p[j+1]; p++) y.p[Li.p[p]] -= Lx.p[p]*y.p[j];
+  }
+  for(uint j=n; j--;) { //L^T y = y
+    for(uint p=Lp.p[j]+1; p<Lp.p[j+1]; p++) y.p[j] -= Lx.p[p]*y.p[Li.p[p]];
+    y.p[j] /= Lx.p[Lp.p[j]];
+  }
+  arr x(n);
+  for(uint k=0; k<n; k++) x.p[perm.p[k]] = y.p[k];
+  return x;
+}
+
+} //namespace rai
+
 //===========================================================================
 //
 // generic special
@@ -2842,19 +3488,36 @@ arr rai::unpack(const arr& X) {
   if(!isSpecial(X)) HALT("this is not special");
   if(isRowShifted(X)) return dynamic_cast<rai::RowShifted*>(X.special)->unpack();
   if(isSparseMatrix(X)) return dynamic_cast<rai::SparseMatrix*>(X.special)->unsparse();
+  if(isCSRMatrix(X)) return X.csr().unsparse();
   HALT("should not be here");
   return arr();
 }
 
-arr rai::comp_At_A(const arr& A) {
+arr rai::comp_At_A(const arr& A, const arr& rowWeights) {
   if(!isSpecial(A)) {
+    if(!!rowWeights) { //A^T W A = B^T B with the rows of non-zero weight, scaled by sqrt(weight)
+      CHECK_EQ(rowWeights.N, A.d0, "");
+      uint n=0;
+      for(double w:rowWeights) { CHECK_GE(w, 0., "dense weighted At_A requires non-negative weights"); if(w>0.) n++; }
+      if(!n) return zeros(A.d1, A.d1);
+      arr B(n, A.d1);
+      for(uint i=0, k=0; i<A.d0; i++) {
+        double w = rowWeights.p[i];
+        if(w>0.) { w=::sqrt(w); for(uint j=0; j<A.d1; j++) B.p[k*A.d1+j] = w*A.p[i*A.d1+j]; k++; }
+      }
+      return comp_At_A(B);
+    }
     arr X;
     if(rai::useLapack) blas_At_A(X, A);
     else X = ~A * A;
     return X;
   }
-  if(isRowShifted(A)) return dynamic_cast<rai::RowShifted*>(A.special)->At_A();
-  if(isSparseMatrix(A)) return dynamic_cast<rai::SparseMatrix*>(A.special)->At_A();
+  if(isRowShifted(A)) return dynamic_cast<rai::RowShifted*>(A.special)->At_A(rowWeights);
+  if(isSparseMatrix(A)) {
+    if(!!rowWeights) { arr C; C.csr().setFromSparse(A.sparse()); return C.csr().At_A(rowWeights); }
+    return dynamic_cast<rai::SparseMatrix*>(A.special)->At_A();
+  }
+  if(isCSRMatrix(A)) return A.csr().At_A(rowWeights);
   return NoArr;
 }
 
@@ -2874,18 +3537,21 @@ arr rai::comp_At_x(const arr& A, const arr& x) {
   if(!isSpecial(A)) { arr y; op_innerProduct(y, ~A, x); return y; }
   if(isRowShifted(A)) return ((rai::RowShifted*)A.special)->At_x(x);
   if(isSparseMatrix(A)) return ((rai::SparseMatrix*)A.special)->At_x(x);
+  if(isCSRMatrix(A)) return A.csr().At_x(x);
   return NoArr;
 }
 
 arr rai::comp_At(const arr& A) {
   if(!isSpecial(A)) { return ~A; }
   if(isRowShifted(A)) return ((rai::RowShifted*)A.special)->At();
+  if(isCSRMatrix(A)) return A.csr().At();
   return NoArr;
 }
 
 arr rai::comp_A_x(const arr& A, const arr& x) {
   if(!isSpecial(A)) { arr y; op_innerProduct(y, A, x); return y; }
   if(isRowShifted(A)) return ((rai::RowShifted*)A.special)->A_x(x);
+  if(isCSRMatrix(A)) return A.csr().A_x(x);
   return NoArr;
 }
 
@@ -35,6 +35,7 @@ namespace rai {
 struct FileToken;
 struct SparseVector;
 struct SparseMatrix;
+struct CSRMatrix;
 struct RowShifted;
 
 // OLD, TODO: hide -> array.cpp
@@ -43,6 +44,30 @@ extern const bool lapackSupported;
 extern int64_t globalMemoryTotal, globalMemoryBound;
 extern bool globalMemoryStrict;
 
+// memory of memMove-arrays (bool, int, float, double, ...) is allocated with these
+void* arrayMalloc(size_t bytes);
+void* arrayRealloc(void* p, size_t bytes);
+void arrayFree(void* p);
+
+/// scoped guard: while alive, small array buffers of this thread are allocated in size classes
+/// and recycled via per-thread free lists, instead of hitting malloc/free each time (e.g. for
+/// the many temporaries within one KOMO evaluation); buffers may outlive the guard, but nothing
+/// is cached without a guard, and the free lists are released when the outermost guard exits
+struct ArrayArena {
+  static uint64_t maxCachedBytes; ///< bound on the bytes kept in the free lists of each thread
+
+  ArrayArena();
+  ~ArrayArena();
+  ArrayArena(const ArrayArena&) = delete;
+  ArrayArena& operator=(const ArrayArena&) = delete;
+
+  static bool active();            ///< is a guard alive in this thread?
+  static void release();           ///< free all buffers cached by this thread (also done when the outermost guard exits)
+  static uint64_t cachedBytes();   ///< bytes currently cached by this thread
+  static uint64_t hits();          ///< pooled allocations of this thread served from the cache
+  static uint64_t misses();        ///< pooled allocations of this thread that needed a malloc
+};
+
 // default write formatting
 extern const char* arrayElemsep;
 extern const char* arrayLinesep;
@@ -297,6 +322,8 @@ template<class T> struct Array : /*std::vector<T>,*/ Serializable {
   const SparseVector& sparseVec() const;
   RowShifted& rowShifted();
   const RowShifted& rowShifted() const;
+  CSRMatrix& csr();
+  const CSRMatrix& csr() const;
   bool isSparse() const;
   void setNoArr();
 
@@ -926,7 +953,7 @@ arr eigen_Ainv_b(const arr& A, const arr& b);
 /// @{
 
 struct SpecialArray {
-  enum Type { ST_none, ST_NoArr, ST_EmptyShape, hasCarrayST, sparseVectorST, sparseMatrixST, diagST, RowShiftedST, CpointerST };
+  enum Type { ST_none, ST_NoArr, ST_EmptyShape, hasCarrayST, sparseVectorST, sparseMatrixST, diagST, RowShiftedST, CpointerST, CSRMatrixST };
   Type type;
   SpecialArray(Type _type=ST_none) : type(_type) {}
   SpecialArray(const SpecialArray&) = delete; //non-copyable
@@ -942,6 +969,7 @@ template<class T> bool isEmptyShape(const Array<T>& X)   { return X.special && X
 template<class T> bool isRowShifted(const Array<T>& X)   { return X.special && X.special->type==SpecialArray::RowShiftedST; }
 template<class T> bool isSparseMatrix(const Array<T>& X) { return X.special && X.special->type==SpecialArray::sparseMatrixST; }
 template<class T> bool isSparseVector(const Array<T>& X) { return X.special && X.special->type==SpecialArray::sparseVectorST; }
+template<class T> bool isCSRMatrix(const Array<T>& X)    { return X.special && X.special->type==SpecialArray::CSRMatrixST; }
 template<class T> bool Array<T>::isSparse() const { return special && (special->type==SpecialArray::sparseMatrixST || special->type==SpecialArray::sparseVectorST); }
 
 struct RowShifted : SpecialArray {
@@ -977,7 +1005,7 @@ struct RowShifted : SpecialArray {
   }
 
   //computations
-  arr At_A();
+  arr At_A(const arr& rowWeights=NoArr); ///< A^T diag(rowWeights) A, skipping the rows of zero weight
   arr A_At();
   arr At_x(const arr& x);
   arr A_x(const arr& x);
@@ -1046,8 +1074,63 @@ struct SparseMatrix : SpecialArray {
   void checkConsistency() const;
 };
 
+/// compressed sparse row (CSR) matrix: Z stores the non-zeros row by row, with sorted column indices
+/// within each row; the compressed column (CSC) form of a matrix is the CSR of its transpose, see At()
+struct CSRMatrix : SpecialArray {
+  arr& Z;        ///< references the array itself, which linearly stores the non-zeros
+  uintA rowPtr;  ///< the non-zeros of row i are Z.p[rowPtr(i)], .., Z.p[rowPtr(i+1)-1]
+  uintA colIdx;  ///< for every non-zero (in memory order), the column index
+
+  CSRMatrix(arr& _Z);
+  CSRMatrix(arr& _Z, const CSRMatrix& s);
+  //access
+  double* find(uint i, uint j); ///< pointer to the stored entry, or nullptr
+  double elem(uint i, uint j) const;
+  //construction
+  CSRMatrix& resize(uint d0, uint d1); ///< empty matrix
+  void setFromTriplets(uint d0, uint d1, const intA& elems, const arr& values, uintA& slots=NoUintA); ///< elems as in SparseMatrix; duplicates are summed; optionally returns the index of each triplet's entry
+  void setPattern(uint d0, uint d1, const uintA& _rowPtr, const uintA& _colIdx); ///< zero matrix with given pattern
+  void setFromSparse(const SparseMatrix& S);
+  void setFromDense(const arr& X);
+  void setScaledRows(const CSRMatrix& A, const intA& rows, const arr& scale); ///< row i is scale(i)*A[rows(i)], or empty for rows(i)=-1
+  //computations
+  arr A_x(const arr& x) const;
+  arr At_x(const arr& x) const;
+  arr At() const;   ///< the transpose as CSR (=the CSC of this), in O(nnz)
+  arr At_A(const arr& rowWeights=NoArr) const; ///< A^T diag(rowWeights) A; always stores the full diagonal (e.g. for damping), the pattern does not depend on the weights
+  void rowWiseMult(const arr& a);
+  void addDiag(double a); ///< requires the diagonal to be stored
+  arr unsparse() const;
+  intA getElems() const; ///< the (row,col) index tuples, as in SparseMatrix
+  void checkConsistency() const;
+};
+
+/// sparse Cholesky factorization P A P^T = L L^T of a symmetric positive definite CSRMatrix A,
+/// with a fill-reducing (reverse Cuthill-McKee) ordering P; the symbolic analysis (ordering,
+/// elimination tree, pattern of L) is kept and only redone when the sparsity pattern of A changes,
+/// so that repeated factorizations of same-pattern matrices (e.g. in Newton iterations) only do numerics
+struct SparseCholesky {
+  uintA perm;    ///< the ordering: row/column k of the factored matrix is row/column perm(k) of A
+  uintA Lp, Li;  ///< pattern of L in compressed column format; the diagonal is the first entry of each column
+  arr Lx;        ///< the values of L
+  uint analyses=0, factorizations=0;
+  bool valid=false; ///< does Lx hold the factor of the last factored matrix? (false after a failed factor or a new analysis)
+
+  //the analyzed pattern of A, and derived symbolic data
+  uintA rowPtr, colIdx;  //the pattern of A
+  uintA Cp, Ci, Cmap;    //upper triangle of P A P^T in compressed column format, and the index of each entry in A
+  uintA Rp, Ri;          //for each row of L, the off-diagonal columns in topological order
+
+  bool factor(const arr& A); ///< analyzes if necessary; returns false if A is not positive definite
+  arr solve(const arr& b) const; ///< A^{-1} b; requires that the last call of factor succeeded
+  void analyze(const CSRMatrix& A);
+  bool hasPattern(const CSRMatrix& A) const; ///< is the analysis valid for the pattern of A?
+  uint symbolic(const CSRMatrix& A, const uintA& _perm); ///< sets the symbolic data for a given ordering; returns nnz(L)
+};
+uintA reverseCuthillMcKee(const CSRMatrix& A); ///< bandwidth-reducing ordering of a symmetric pattern
+
 arr unpack(const arr& X);
-arr comp_At_A(const arr& A);
+arr comp_At_A(const arr& A, const arr& rowWeights=NoArr); ///< A^T diag(rowWeights) A, without scaled copies of A (weighted SparseMatrix -> CSRMatrix result)
 arr comp_A_At(const arr& A);
 arr comp_At_x(const arr& A, const arr& x);
 arr comp_At(const arr& A);
@@ -10,6 +10,7 @@
 
 #include "array.h"
 #include "util.h"
+#include "simd.h"
 
 #include <cmath>
 #include <algorithm>
@@ -473,9 +474,9 @@ template<class T> void rai::Array<T>::resizeMEM(uint n, bool copy, int Mforce) {
     if(Mnew) {
       if(memMove==1){
         if(p){
-          p=(T*)realloc(p, Mnew*sizeT);
+          p=(T*)rai::arrayRealloc(p, Mnew*sizeT);
         } else {
-          p=(T*)malloc(Mnew*sizeT);
+          p=(T*)rai::arrayMalloc(Mnew*sizeT);
           //memset(p, 0, Mnew*sizeT);
         }
         if(!p) { HALT("memory allocation failed! Wanted size = " <<Mnew*sizeT <<"bytes"); }
@@ -490,7 +491,7 @@ template<class T> void rai::Array<T>::resizeMEM(uint n, bool copy, int Mforce) {
     } else {
       if(p) {
         if(memMove==1){
-          free(p);
+          rai::arrayFree(p);
         }else{
           delete[] p;
         }
@@ -512,7 +513,7 @@ template<class T> void rai::Array<T>::freeMEM() {
   if(M) {
     rai::globalMemoryTotal -= M*sizeT;
     if(memMove==1){
-      free(p);
+      rai::arrayFree(p);
     }else{
       delete[] p;
     }
@@ -1367,6 +1368,9 @@ template<class T> rai::Array<T>& rai::Array<T>::operator=(const rai::Array<T>& a
     } else if(isSparseMatrix(a)) {
       CHECK(typeid(T) == typeid(double), "");
       special = new SparseMatrix(*((arr*)this), *dynamic_cast<SparseMatrix*>(a.special));
+    } else if(isCSRMatrix(a)) {
+      CHECK(typeid(T) == typeid(double), "");
+      special = new CSRMatrix(*((arr*)this), *dynamic_cast<CSRMatrix*>(a.special));
     } else if(isNoArr(a)){
       setNoArr();
     } else NIY;
@@ -2039,6 +2043,9 @@ template<class T> void rai::Array<T>::write(std::ostream& os, const char* ELEMSE
   } else if(isSparseMatrix(*this)) {
     intA& elems = dynamic_cast<SparseMatrix*>(special)->elems;
     for(uint i=0; i<N; i++) os <<'(' <<elems[i] <<") " <<elem(i) <<endl;
+  } else if(isCSRMatrix(*this)) {
+    CSRMatrix* s = dynamic_cast<CSRMatrix*>(special);
+    for(uint i=0; i<d0; i++) for(uint k=s->rowPtr(i); k<s->rowPtr(i+1); k++) os <<'(' <<i <<' ' <<s->colIdx(k) <<") " <<elem(k) <<endl;
   } else {
     if(BRACKETS[0]) os <<BRACKETS[0];
     if(dimTag || nd>3) { os <<' '; writeDim(os); if(nd==2) os <<'\n'; else os <<' '; }
@@ -2616,9 +2623,7 @@ T metricDistance(const rai::Array<T>& g, const rai::Array<T>& v, const rai::Arra
 
 /// \f$\sum_i x_i\f$
 template<class T> T sum(const rai::Array<T>& v) {
-  T t(0);
-  for(uint i=v.N; i--; t+=v.p[i]) {};
-  return t;
+  return rai::simd::sum(v.p, v.N);
 }
 
 /// \f$\max_i x_i\f$
@@ -2747,9 +2752,7 @@ template<class T> T sumOfPos(const rai::Array<T>& v) {
 
 /// \f$\sum_i x_i^2\f$
 template<class T> T sumOfSqr(const rai::Array<T>& v) {
-  T t(0);
-  for(uint i=v.N; i--; t+=v.p[i]*v.p[i]) {};
-  return t;
+  return rai::simd::sumOfSqr(v.p, v.N);
 }
 
 /// \f$\sqrt{\sum_i x_i^2}\f$
@@ -2803,11 +2806,7 @@ template<class T> T absMin(const rai::Array<T>& x) {
 
 /// get absolute maximum (using fabs)
 template<class T> T absMax(const rai::Array<T>& x) {
-  if(!x.N) return (T)0;
-  uint i;
-  T t((T)std::fabs((double)x.p[0]));
-  for(i=1; i<x.N; i++) if(std::fabs((double)x.p[i])>t) t=(T)std::fabs((double)x.p[i]);
-  return t;
+  return rai::simd::absMax(x.p, x.N);
 }
 
 /// get absolute min (using fabs)
@@ -3152,7 +3151,7 @@ T scalarProduct(const rai::Array<T>& v, const rai::Array<T>& w) {
   if(!v.special && !w.special) {
     CHECK_EQ(v.N, w.N,
              "scalar product on different array dimensions (" <<v.N <<", " <<w.N <<")");
-    for(uint i=v.N; i--; t+=v.p[i]*w.p[i]);
+    t = rai::simd::dot(v.p, w.p, v.N);
   } else {
     if(isSparseVector(v) && isSparseVector(w)) {
       rai::SparseVector* sv = dynamic_cast<rai::SparseVector*>(v.special);
@@ -3911,29 +3910,26 @@ template<class T> Array<T>& operator<<(Array<T>& x, const Array<T>& y) { x.appen
 
 
 //core for matrix-matrix (elem-wise) update
-#define UpdateOperator_MM( op )        \
+#define UpdateOperator_MM( op, kernel )        \
     if(isNoArr(x)){ return x; } \
     if(isSparseMatrix(x) && isSparseMatrix(y)){ x.sparse() op y.sparse(); return x; }  \
     if(isRowShifted(x) && isRowShifted(y)){ x.rowShifted() op y.rowShifted(); return x; }  \
     CHECK(!isSpecial(x), "");  \
     CHECK(!isSpecial(y), "");  \
     CHECK_EQ(x.N, y.N, "update operator on different array dimensions (" <<x.N <<", " <<y.N <<")"); \
-    T *xp=x.p, *xstop=xp+x.N;              \
-    const T *yp=y.p;              \
-    for(; xp!=xstop; xp++, yp++) *xp op *yp;
+    rai::simd::kernel(x.p, y.p, x.N);
 
 //core for matrix-scalar update
-#define UpdateOperator_MS( op ) \
+#define UpdateOperator_MS( op, kernel ) \
   if(isNoArr(x)){ return x; } \
   if(isSparseMatrix(x)){ x.sparse() op y; return x; }  \
   if(isRowShifted(x)){ x.rowShifted() op y; return x; }  \
   CHECK(!isSpecial(x), "");  \
-  T *xp=x.p, *xstop=xp+x.N;              \
-  for(; xp!=xstop; xp++) *xp op y;
+  rai::simd::kernel(x.p, y, x.N);
 
 
 template<class T> Array<T>& operator+=(Array<T>& x, const Array<T>& y){
-  UpdateOperator_MM(+=);
+  UpdateOperator_MM(+=, add);
   if(y.jac){
     if(x.jac) *x.jac += *y.jac;
     else x.J() = *y.jac;
@@ -3941,11 +3937,11 @@ template<class T> Array<T>& operator+=(Array<T>& x, const Array<T>& y){
   return x;
 }
 template<class T> Array<T>& operator+=(Array<T>& x, T y){
-  UpdateOperator_MS(+=);
+  UpdateOperator_MS(+=, add);
   return x;
 }
   template<class T> Array<T>& operator+=(Array<T>&& x, const Array<T>& y){
-    UpdateOperator_MM(+=);
+    UpdateOperator_MM(+=, add);
     if(y.jac){
       if(x.jac) *x.jac += *y.jac;
       else x.J() = *y.jac;
@@ -3953,12 +3949,12 @@ template<class T> Array<T>& operator+=(Array<T>& x, T y){
     return x;
   }
   template<class T> Array<T>& operator+=(Array<T>&& x, T y){
-    UpdateOperator_MS(+=);
+    UpdateOperator_MS(+=, add);
     return x;
   }
 
 template<class T> Array<T>& operator-=(Array<T>& x, const Array<T>& y){
-  UpdateOperator_MM(-=);
+  UpdateOperator_MM(-=, sub);
   if(y.jac){
     if(x.jac) *x.jac -= *y.jac;
     else x.J() = -(*y.jac);
@@ -3966,11 +3962,11 @@ template<class T> Array<T>& operator-=(Array<T>& x, const Array<T>& y){
   return x;
 }
 template<class T> Array<T>& operator-=(Array<T>& x, T y){
-  UpdateOperator_MS(-=);
+  UpdateOperator_MS(-=, sub);
   return x;
 }
   template<class T> Array<T>& operator-=(Array<T>&& x, const Array<T>& y){
-    UpdateOperator_MM(-=);
+    UpdateOperator_MM(-=, sub);
     if(y.jac){
       if(x.jac) *x.jac -= *y.jac;
       else x.J() = -(*y.jac);
@@ -3978,7 +3974,7 @@ template<class T> Array<T>& operator-=(Array<T>& x, T y){
     return x;
   }
   template<class T> Array<T>& operator-=(Array<T>&& x, T y){
-    UpdateOperator_MS(-=);
+    UpdateOperator_MS(-=, sub);
     return x;
   }
 
@@ -3990,12 +3986,12 @@ template<class T> Array<T>& operator*=(Array<T>& x, const Array<T>& y){
     else if(!x.jac && y.jac) x.J() = x % (*y.jac);
     else NIY;
   }
-  UpdateOperator_MM(*=);
+  UpdateOperator_MM(*=, mul);
   return x;
 }
 template<class T> Array<T>& operator*=(Array<T>& x, T y){
   if(x.jac) *x.jac *= y;
-  UpdateOperator_MS(*=);
+  UpdateOperator_MS(*=, mul);
   return x;
 }
   template<class T> Array<T>& operator*=(Array<T>&& x, const Array<T>& y){
@@ -4005,36 +4001,36 @@ template<class T> Array<T>& operator*=(Array<T>& x, T y){
       else if(!x.jac && y.jac) x.J() = x.noJ() % (*y.jac);
       else NIY;
     }
-    UpdateOperator_MM(*=);
+    UpdateOperator_MM(*=, mul);
     return x;
   }
   template<class T> Array<T>& operator*=(Array<T>&& x, T y){
     if(x.jac) *x.jac *= y;
-    UpdateOperator_MS(*=);
+    UpdateOperator_MS(*=, mul);
     return x;
   }
 
 template<class T> Array<T>& operator/=(Array<T>& x, const Array<T>& y){
-  UpdateOperator_MM(/=);
+  UpdateOperator_MM(/=, div);
   if(x.jac || y.jac){
     NIY;
   }
   return x;
 }
 template<class T> Array<T>& operator/=(Array<T>& x, T y){
-  UpdateOperator_MS(/=);
+  UpdateOperator_MS(/=, div);
   if(x.jac) *x.jac /= y;
   return x;
 }
   template<class T> Array<T>& operator/=(Array<T>&& x, const Array<T>& y){
-    UpdateOperator_MM(/=);
+    UpdateOperator_MM(/=, div);
     if(x.jac || y.jac){
       NIY;
     }
     return x;
   }
   template<class T> Array<T>& operator/=(Array<T>&& x, T y){
-    UpdateOperator_MS(/=);
+    UpdateOperator_MS(/=, div);
     if(x.jac) *x.jac /= y;
     return x;
   }
@@ -4145,6 +4141,17 @@ inline double sign(double x) {  return (x > 0) - (x < 0); }
     return x;         \
   }
 
+//same, but with a (vectorized) kernel from simd.h
+#define UnaryFunction_kernel( func )         \
+  template<class T>           \
+  rai::Array<T> func (const rai::Array<T>& y){    \
+    rai::Array<T> x;           \
+    x.resizeAs(y);         \
+    rai::simd::func(x.p, y.p, x.N);  \
+    CHECK(!y.jac, "AutoDiff NIY"); \
+    return x;         \
+  }
+
 // trigonometric functions
 UnaryFunction(acos)
 UnaryFunction(asin)
@@ -4167,18 +4174,19 @@ UnaryFunction(log)
 UnaryFunction(log10)
 
 //roots
-UnaryFunction(sqrt)
+UnaryFunction_kernel(sqrt)
 UnaryFunction(cbrt)
 
 // nearest integer and absolute value
 UnaryFunction(ceil)
-UnaryFunction(fabs)
+UnaryFunction_kernel(fabs)
 UnaryFunction(floor)
 UnaryFunction(sigm)
 
 UnaryFunction(sign)
 
 #undef UnaryFunction
+#undef UnaryFunction_kernel
 
 //---------- binary functions
 
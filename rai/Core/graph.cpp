@@ -11,6 +11,7 @@
 #include "array.ipp"
 
 #include <map>
+#include <unordered_map>
 
 #ifdef RAI_JSON
 #  include <jsoncpp/json/json.h>
@@ -68,6 +69,77 @@ inline Node* readTypeIntoNode(Graph& container, const char* key, std::istream& i
   return nullptr;
 }
 
+//===========================================================================
+//
+//  hashed node index (see Graph::useHashIndex)
+//
+
+struct GraphHashIndex {
+  struct Entry { std::string key; Node* firstParent; };
+  std::unordered_map<std::string, NodeL> keys;   ///< non-empty key -> nodes
+  std::unordered_map<Node*, NodeL> firstParents; ///< first parent -> nodes
+  std::unordered_map<Node*, Entry> entries;      ///< indexed node -> under which key/first parent it is indexed
+  uint N=0;                                      ///< the first N nodes of the graph are indexed
+
+  void clear() { keys.clear(); firstParents.clear(); entries.clear(); N=0; }
+
+  void ensure(const Graph& G) {
+    if(N>G.N) clear();
+    for(; N<G.N; N++) add(G.elem(N));
+  }
+
+  void add(Node* n) {
+    Entry& e = entries[n];
+    e.key = std::string(n->key.p, n->key.N);
+    e.firstParent = n->parents.N ? n->parents.first() : nullptr;
+    if(e.key.size()) keys[e.key].append(n);
+    if(e.firstParent) firstParents[e.firstParent].append(n);
+  }
+
+  bool remove(Node* n) {
+    auto it = entries.find(n);
+    if(it==entries.end()) return false;
+    if(it->second.key.size()) keys[it->second.key].removeValue(n);
+    if(it->second.firstParent) firstParents[it->second.firstParent].removeValue(n);
+    entries.erase(it);
+    return true;
+  }
+
+  /// call after n's parents changed
+  void reparent(Node* n) {
+    auto it = entries.find(n);
+    if(it==entries.end()) return; //not indexed yet
+    Node* p = n->parents.N ? n->parents.first() : nullptr;
+    if(p==it->second.firstParent) return;
+    if(it->second.firstParent) firstParents[it->second.firstParent].removeValue(n);
+    if(p) firstParents[p].append(n);
+    it->second.firstParent = p;
+  }
+
+  /// nodes indexed under key; nullptr if the index is stale (a node was renamed)
+  const NodeL* find(const char* key) {
+    static const NodeL none;
+    auto it = keys.find(key);
+    if(it==keys.end()) return &none;
+    for(Node* n:it->second) if(n->key!=key) return nullptr;
+    return &it->second;
+  }
+};
+
+/// hashed lookup of the nodes with given key -- nullptr if the graph has no hash index or key is empty
+static const NodeL* findInHashIndex(const Graph& G, const char* key) {
+  if(!G.hashIndex || !key || !key[0]) return nullptr;
+  G.hashIndex->ensure(G);
+  const NodeL* nodes = G.hashIndex->find(key);
+  if(!nodes) { //stale -> rebuild
+    G.hashIndex->clear();
+    G.hashIndex->ensure(G);
+    nodes = G.hashIndex->find(key);
+    CHECK(nodes, "");
+  }
+  return nodes;
+}
+
 //===========================================================================
 //
 //  Node methods
@@ -82,6 +154,7 @@ Node::Node(const std::type_info& _type, Graph& _container, const char* _key, con
 }
 
 Node::~Node() {
+  if(container.hashIndex && container.hashIndex->remove(this)) container.hashIndex->N--;
   if(container.isDoubleLinked) while(children.N) children.last()->removeParent(this);
   if(numChildren) LOG(-2) <<"It is not allowed to delete nodes that still have children";
   while(parents.N) removeParent(parents.last());
@@ -101,6 +174,7 @@ void Node::addParent(Node* p, bool prepend) {
     parents.prepend(p);
   p->numChildren++;
   if(container.isDoubleLinked) p->children.append(this);
+  if(container.hashIndex && parents.first()==p) container.hashIndex->reparent(this);
 }
 
 void Node::removeParent(Node* p) {
@@ -108,6 +182,7 @@ void Node::removeParent(Node* p) {
   CHECK(p->numChildren, "");
   p->numChildren--;
   if(container.isDoubleLinked) p->children.removeValue(this);
+  if(container.hashIndex) container.hashIndex->reparent(this);
 }
 
 void Node::swapParent(uint i, Node* p) {
@@ -117,6 +192,7 @@ void Node::swapParent(uint i, Node* p) {
   parents(i) = p;
   parents(i)->numChildren++;
   if(container.isDoubleLinked) parents(i)->children.append(this);
+  if(container.hashIndex && !i) container.hashIndex->reparent(this);
 }
 
 bool Node::matches(const char* _key) {
@@ -242,7 +318,7 @@ NodeInitializer::NodeInitializer(const char* key, const char* stringValue) {
 //  Graph methods
 //
 
-Graph::Graph() : isNodeOfGraph(nullptr), pi(nullptr), ri(nullptr) {
+Graph::Graph() : isNodeOfGraph(nullptr), pi(nullptr), ri(nullptr), hashIndex(nullptr) {
 }
 
 Graph::Graph(const char* filename, bool parseInfo): Graph() {
@@ -277,6 +353,7 @@ Graph::Graph(const Graph& G) : Graph() {
 
 Graph::~Graph() {
   clear();
+  useHashIndex(false);
 }
 
 bool Graph::operator!() const {
@@ -286,6 +363,7 @@ bool Graph::operator!() const {
 void Graph::clear() {
   if(ri) { delete ri; ri=nullptr; }
   if(pi) { delete pi; pi=nullptr; }
+  resetHashIndex();
   DEBUG(checkConsistency();)
   if(!isNodeOfGraph) { //this is not a subgraph; save to delete connections in batch -> faster
     NodeL all = getAllNodesRecursively();
@@ -339,8 +417,19 @@ void Graph::appendDict(const std::map<std::string, std::string>& dict) {
   }
 }
 
+void Graph::useHashIndex(bool on) {
+  if(on && !hashIndex) hashIndex = new GraphHashIndex;
+  if(!on && hashIndex) { delete hashIndex; hashIndex=nullptr; }
+}
+
+void Graph::resetHashIndex() {
+  if(hashIndex) hashIndex->clear();
+}
+
 Node* Graph::findNode(const char* key, bool recurseUp, bool recurseDown) const {
-  for(Node* n: (*this)) if(n->matches(key)) return n;
+  const NodeL* hashed = findInHashIndex(*this, key);
+  if(hashed) { if(hashed->N) return hashed->first(); }
+  else for(Node* n: (*this)) if(n->matches(key)) return n;
   Node* ret=nullptr;
   if(recurseUp && isNodeOfGraph) ret = isNodeOfGraph->container.findNode(key, true, false);
   if(ret) return ret;
@@ -352,7 +441,9 @@ Node* Graph::findNode(const char* key, bool recurseUp, bool recurseDown) const {
 }
 
 Node* Graph::findNodeOfType(const std::type_info& type, const char* key, bool recurseUp, bool recurseDown) const {
-  for(Node* n: (*this)) if(n->type==type && (!key || n->matches(key))) return n;
+  const NodeL* hashed = findInHashIndex(*this, key);
+  if(hashed) { for(Node* n: *hashed) if(n->type==type) return n; }
+  else for(Node* n: (*this)) if(n->type==type && (!key || n->matches(key))) return n;
   Node* ret=nullptr;
   if(recurseUp && isNodeOfGraph) ret = isNodeOfGraph->container.findNodeOfType(type, key, true, false);
   if(ret) return ret;
@@ -365,7 +456,9 @@ Node* Graph::findNodeOfType(const std::type_info& type, const char* key, bool re
 
 NodeL Graph::findNodes(const char* key, bool recurseUp, bool recurseDown) const {
   NodeL ret;
-  for(Node* n: (*this)) if(n->matches(key)) ret.append(n);
+  const NodeL* hashed = findInHashIndex(*this, key);
+  if(hashed) ret = *hashed;
+  else for(Node* n: (*this)) if(n->matches(key)) ret.append(n);
   if(recurseUp && isNodeOfGraph) ret.append(isNodeOfGraph->container.findNodes(key, true, false));
   if(recurseDown) for(Node* n: (*this)) if(n->isGraph()) ret.append(n->graph().findNodes(key, false, true));
   return ret;
@@ -373,7 +466,9 @@ NodeL Graph::findNodes(const char* key, bool recurseUp, bool recurseDown) const
 
 NodeL Graph::findNodesOfType(const std::type_info& type, const char* key, bool recurseUp, bool recurseDown) const {
   NodeL ret;
-  for(Node* n: (*this)) if(n->type==type && (!key || n->matches(key))) ret.append(n);
+  const NodeL* hashed = findInHashIndex(*this, key);
+  if(hashed) { for(Node* n: *hashed) if(n->type==type) ret.append(n); }
+  else for(Node* n: (*this)) if(n->type==type && (!key || n->matches(key))) ret.append(n);
   if(recurseUp && isNodeOfGraph) ret.append(isNodeOfGraph->container.findNodesOfType(type, key, true, false));
   if(recurseDown) for(Node* n: (*this)) if(n->isGraph()) ret.append(n->graph().findNodesOfType(type, key, false, true));
   return ret;
@@ -385,6 +480,18 @@ NodeL Graph::findGraphNodesWithTag(const char* tag) const {
   return ret;
 }
 
+NodeL Graph::findNodesWithFirstParent(Node* parent) const {
+  if(hashIndex) {
+    hashIndex->ensure(*this);
+    auto it = hashIndex->firstParents.find(parent);
+    if(it==hashIndex->firstParents.end()) return NodeL();
+    return it->second;
+  }
+  NodeL ret;
+  for(Node* n: (*this)) if(n->parents.N && n->parents.first()==parent) ret.append(n);
+  return ret;
+}
+
 //Node* Graph::getNode(const char *key) const {
 //  for(Node *n: (*this)) if(n->matches(key)) return n;
 //  if(isNodeOfGraph) return isNodeOfGraph->container.getNode(key);
@@ -616,6 +723,7 @@ void Graph::read(std::istream& is, bool parseInfo) {
       if(namePrefix.N) { //prepend a naming prefix to all nodes just read
         for(uint i=Nbefore; i<N; i++) elem(i)->key.prepend(namePrefix);
         namePrefix.clear();
+        resetHashIndex();
       }
       n->get<FileToken>().cd_start();
       delete n; n=nullptr;
@@ -1136,6 +1244,7 @@ void Graph::sortByDotOrder() {
   permuteInv(perm);
   it_COUNT=0;
   for(Node *it: list()) it->index=it_COUNT++;
+  resetHashIndex();
 }
 
 ParseInfo& Graph::getParseInfo(Node* n) {
@@ -96,6 +96,7 @@ struct Graph : NodeL {
 
   ArrayG<ParseInfo>* pi;     ///< optional annotation of nodes: when detailed file parsing is enabled
   ArrayG<RenderingInfo>* ri; ///< optional annotation of nodes: dot style commands
+  struct GraphHashIndex* hashIndex; ///< optional hashed index (key -> nodes, first parent -> nodes) used by the find methods, see useHashIndex
 
   //-- constructors
   Graph();                                               ///< empty graph
@@ -132,6 +133,12 @@ struct Graph : NodeL {
   Node* findNodeOfType(const std::type_info& type, const char* key, bool recurseUp=false, bool recurseDown=false) const;
   NodeL findNodesOfType(const std::type_info& type, const char* key, bool recurseUp=false, bool recurseDown=false) const;
   NodeL findGraphNodesWithTag(const char* tag) const;
+  NodeL findNodesWithFirstParent(Node* parent) const; ///< all nodes whose parents(0) is 'parent' (with hash index: in order of attachment, otherwise in graph order)
+
+  //-- optional hashed index for the find methods: built lazily on the first lookup, kept in sync on node creation, deletion and reparenting;
+  //   when enabled, nodes must not be renamed (key changed) directly -- call resetHashIndex() afterwards
+  void useHashIndex(bool on=true);
+  void resetHashIndex(); ///< forces a rebuild on the next lookup
 
   //-- get nodes
   Node* operator[](const char* key) const { return findNode(key); } ///< returns nullptr if not found
@@ -0,0 +1,223 @@
+/*  ------------------------------------------------------------------
+    Copyright (c) 2011-2020 Marc Toussaint
+    email: toussaint@tu-berlin.de
+
+    This code is distributed under the MIT License.
+    Please see <root-path>/LICENSE for details.
+    --------------------------------------------------------------  */
+
+#include "simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define RAI_SIMD_X86
+#  include <immintrin.h>
+#endif
+
+namespace rai {
+namespace simd {
+
+//===========================================================================
+//
+// kernel tables
+//
+
+template<class T> struct Kernels {
+  void (*add)(T*, const T*, uint);
+  void (*sub)(T*, const T*, uint);
+  void (*mul)(T*, const T*, uint);
+  void (*div)(T*, const T*, uint);
+  void (*addc)(T*, T, uint);
+  void (*subc)(T*, T, uint);
+  void (*mulc)(T*, T, uint);
+  void (*divc)(T*, T, uint);
+  T (*sum)(const T*, uint);
+  T (*sumOfSqr)(const T*, uint);
+  T (*dot)(const T*, const T*, uint);
+  T (*absMax)(const T*, uint);
+  void (*sqrt)(T*, const T*, uint);
+  void (*fabs)(T*, const T*, uint);
+};
+
+template<class T> Kernels<T> scalarKernels() {
+  return { scalar::add<T>, scalar::sub<T>, scalar::mul<T>, scalar::div<T>,
+           scalar::add<T>, scalar::sub<T>, scalar::mul<T>, scalar::div<T>,
+           scalar::sum<T>, scalar::sumOfSqr<T>, scalar::dot<T>, scalar::absMax<T>,
+           scalar::sqrt<T>, scalar::fabs<T> };
+}
+
+//===========================================================================
+//
+// vectorized kernels: one set per instruction set and type, generated by the macro below;
+// each processes full vectors (two accumulators for reductions) and finishes the remainder with plain loops
+//
+
+#ifdef RAI_SIMD_X86
+
+#define RAI_SIMD_KERNELS(ISA, TARGET, T, V, W, LOAD, STORE, SET1, ADD, SUB, MUL, DIV, SQRT, ABS, MAX, HSUM, HMAX) \
+  namespace ISA##_##T { \
+  __attribute__((target(TARGET))) void add(T* x, const T* y, uint n) { uint i=0; for(; i+W<=n; i+=W) STORE(x+i, ADD(LOAD(x+i), LOAD(y+i))); for(; i<n; i++) x[i] += y[i]; } \
+  __attribute__((target(TARGET))) void sub(T* x, const T* y, uint n) { uint i=0; for(; i+W<=n; i+=W) STORE(x+i, SUB(LOAD(x+i), LOAD(y+i))); for(; i<n; i++) x[i] -= y[i]; } \
+  __attribute__((target(TARGET))) void mul(T* x, const T* y, uint n) { uint i=0; for(; i+W<=n; i+=W) STORE(x+i, MUL(LOAD(x+i), LOAD(y+i))); for(; i<n; i++) x[i] *= y[i]; } \
+  __attribute__((target(TARGET))) void div(T* x, const T* y, uint n) { uint i=0; for(; i+W<=n; i+=W) STORE(x+i, DIV(LOAD(x+i), LOAD(y+i))); for(; i<n; i++) x[i] /= y[i]; } \
+  __attribute__((target(TARGET))) void addc(T* x, T c, uint n) { V v=SET1(c); uint i=0; for(; i+W<=n; i+=W) STORE(x+i, ADD(LOAD(x+i), v)); for(; i<n; i++) x[i] += c; } \
+  __attribute__((target(TARGET))) void subc(T* x, T c, uint n) { V v=SET1(c); uint i=0; for(; i+W<=n; i+=W) STORE(x+i, SUB(LOAD(x+i), v)); for(; i<n; i++) x[i] -= c; } \
+  __attribute__((target(TARGET))) void mulc(T* x, T c, uint n) { V v=SET1(c); uint i=0; for(; i+W<=n; i+=W) STORE(x+i, MUL(LOAD(x+i), v)); for(; i<n; i++) x[i] *= c; } \
+  __attribute__((target(TARGET))) void divc(T* x, T c, uint n) { V v=SET1(c); uint i=0; for(; i+W<=n; i+=W) STORE(x+i, DIV(LOAD(x+i), v)); for(; i<n; i++) x[i] /= c; } \
+  __attribute__((target(TARGET))) T sum(const T* x, uint n) { \
+    V a=SET1(0), b=SET1(0); uint i=0; \
+    for(; i+2*W<=n; i+=2*W) { a=ADD(a, LOAD(x+i)); b=ADD(b, LOAD(x+i+W)); } \
+    for(; i+W<=n; i+=W) a=ADD(a, LOAD(x+i)); \
+    T t=HSUM(ADD(a, b)); for(; i<n; i++) t += x[i]; return t; } \
+  __attribute__((target(TARGET))) T sumOfSqr(const T* x, uint n) { \
+    V a=SET1(0), b=SET1(0); uint i=0; \
+    for(; i+2*W<=n; i+=2*W) { V u=LOAD(x+i), v=LOAD(x+i+W); a=ADD(a, MUL(u, u)); b=ADD(b, MUL(v, v)); } \
+    for(; i+W<=n; i+=W) { V u=LOAD(x+i); a=ADD(a, MUL(u, u)); } \
+    T t=HSUM(ADD(a, b)); for(; i<n; i++) t += x[i]*x[i]; return t; } \
+  __attribute__((target(TARGET))) T dot(const T* x, const T* y, uint n) { \
+    V a=SET1(0), b=SET1(0); uint i=0; \
+    for(; i+2*W<=n; i+=2*W) { a=ADD(a, MUL(LOAD(x+i), LOAD(y+i))); b=ADD(b, MUL(LOAD(x+i+W), LOAD(y+i+W))); } \
+    for(; i+W<=n; i+=W) a=ADD(a, MUL(LOAD(x+i), LOAD(y+i))); \
+    T t=HSUM(ADD(a, b)); for(; i<n; i++) t += x[i]*y[i]; return t; } \
+  __attribute__((target(TARGET))) T absMax(const T* x, uint n) { \
+    if(n<W) return scalar::absMax(x, n); \
+    V m=ABS(LOAD(x)); uint i=W; \
+    for(; i+W<=n; i+=W) m=MAX(m, ABS(LOAD(x+i))); \
+    T t=HMAX(m); for(; i<n; i++) if(std::fabs(x[i])>t) t=std::fabs(x[i]); return t; } \
+  __attribute__((target(TARGET))) void sqrt(T* x, const T* y, uint n) { uint i=0; for(; i+W<=n; i+=W) STORE(x+i, SQRT(LOAD(y+i))); for(; i<n; i++) x[i] = std::sqrt(y[i]); } \
+  __attribute__((target(TARGET))) void fabs(T* x, const T* y, uint n) { uint i=0; for(; i+W<=n; i+=W) STORE(x+i, ABS(LOAD(y+i))); for(; i<n; i++) x[i] = std::fabs(y[i]); } \
+  Kernels<T> kernels() { return { add, sub, mul, div, addc, subc, mulc, divc, sum, sumOfSqr, dot, absMax, sqrt, fabs }; } \
+  }
+
+//-- AVX2 helpers (horizontal reductions, abs via clearing the sign bit)
+__attribute__((target("avx2"))) static inline double hsum_avx2(__m256d v) {
+  __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+__attribute__((target("avx2"))) static inline double hmax_avx2(__m256d v) {
+  __m128d s = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_max_sd(s, _mm_unpackhi_pd(s, s)));
+}
+__attribute__((target("avx2"))) static inline float hsum_avx2(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+__attribute__((target("avx2"))) static inline float hmax_avx2(__m256 v) {
+  __m128 s = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+  return _mm_cvtss_f32(_mm_max_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+__attribute__((target("avx2"))) static inline __m256d abs_avx2(__m256d v) { return _mm256_andnot_pd(_mm256_set1_pd(-0.), v); }
+__attribute__((target("avx2"))) static inline __m256 abs_avx2(__m256 v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), v); }
+
+RAI_SIMD_KERNELS(avx2, "avx2", double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd,
+                 _mm256_add_pd, _mm256_sub_pd, _mm256_mul_pd, _mm256_div_pd, _mm256_sqrt_pd, abs_avx2, _mm256_max_pd, hsum_avx2, hmax_avx2)
+RAI_SIMD_KERNELS(avx2, "avx2", float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps,
+                 _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _mm256_div_ps, _mm256_sqrt_ps, abs_avx2, _mm256_max_ps, hsum_avx2, hmax_avx2)
+
+//-- AVX-512 helpers (gcc falsely warns about the _mm512_undefined_* placeholders inside the intrinsics)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f"))) static inline __m512d abs_avx512(__m512d v) { return _mm512_abs_pd(v); }
+__attribute__((target("avx512f"))) static inline __m512 abs_avx512(__m512 v) { return _mm512_abs_ps(v); }
+__attribute__((target("avx512f"))) static inline double hsum_avx512(__m512d v) { return _mm512_reduce_add_pd(v); }
+__attribute__((target("avx512f"))) static inline float hsum_avx512(__m512 v) { return _mm512_reduce_add_ps(v); }
+__attribute__((target("avx512f"))) static inline double hmax_avx512(__m512d v) { return _mm512_reduce_max_pd(v); }
+__attribute__((target("avx512f"))) static inline float hmax_avx512(__m512 v) { return _mm512_reduce_max_ps(v); }
+
+RAI_SIMD_KERNELS(avx512, "avx512f", double, __m512d, 8, _mm512_loadu_pd, _mm512_storeu_pd, _mm512_set1_pd,
+                 _mm512_add_pd, _mm512_sub_pd, _mm512_mul_pd, _mm512_div_pd, _mm512_sqrt_pd, abs_avx512, _mm512_max_pd, hsum_avx512, hmax_avx512)
+RAI_SIMD_KERNELS(avx512, "avx512f", float, __m512, 16, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps,
+                 _mm512_add_ps, _mm512_sub_ps, _mm512_mul_ps, _mm512_div_ps, _mm512_sqrt_ps, abs_avx512, _mm512_max_ps, hsum_avx512, hmax_avx512)
+
+#pragma GCC diagnostic pop
+
+#undef RAI_SIMD_KERNELS
+
+#endif //RAI_SIMD_X86
+
+//===========================================================================
+//
+// runtime dispatch
+//
+
+InstructionSet bestInstructionSet() {
+#ifdef RAI_SIMD_X86
+  static InstructionSet best = __builtin_cpu_supports("avx512f") ? IS_avx512 : __builtin_cpu_supports("avx2") ? IS_avx2 : IS_scalar;
+  return best;
+#else
+  return IS_scalar;
+#endif
+}
+
+template<class T> struct Dispatch {
+  Kernels<T> table[3];
+  const Kernels<T>* active;
+};
+
+template<class T> Kernels<T> vectorKernels(InstructionSet is);
+#ifdef RAI_SIMD_X86
+template<> Kernels<double> vectorKernels(InstructionSet is) { return is==IS_avx512 ? avx512_double::kernels() : avx2_double::kernels(); }
+template<> Kernels<float> vectorKernels(InstructionSet is) { return is==IS_avx512 ? avx512_float::kernels() : avx2_float::kernels(); }
+#else
+template<class T> Kernels<T> vectorKernels(InstructionSet is) { return scalarKernels<T>(); }
+#endif
+
+template<class T> Dispatch<T>& dispatch() {
+  static Dispatch<T> D = []() {
+    Dispatch<T> D;
+    D.table[IS_scalar] = scalarKernels<T>();
+    D.table[IS_avx2] = D.table[IS_avx512] = scalarKernels<T>();
+    if(bestInstructionSet()>=IS_avx2) D.table[IS_avx2] = vectorKernels<T>(IS_avx2);
+    if(bestInstructionSet()>=IS_avx512) D.table[IS_avx512] = vectorKernels<T>(IS_avx512);
+    D.active = &D.table[bestInstructionSet()];
+    return D;
+  }();
+  return D;
+}
+
+static InstructionSet& currentInstructionSet() { static InstructionSet is=bestInstructionSet(); return is; }
+
+InstructionSet instructionSet() { return currentInstructionSet(); }
+
+void setInstructionSet(InstructionSet is) {
+  CHECK_LE(is, bestInstructionSet(), "instruction set '" <<instructionSetName(is) <<"' is not supported by this CPU");
+  currentInstructionSet() = is;
+  dispatch<double>().active = &dispatch<double>().table[is];
+  dispatch<float>().active = &dispatch<float>().table[is];
+}
+
+const char* instructionSetName(InstructionSet is) {
+  switch(is) {
+    case IS_scalar: return "scalar";
+    case IS_avx2: return "avx2";
+    case IS_avx512: return "avx512";
+  }
+  return "?";
+}
+
+//-- arrays shorter than this are not worth the dispatch
+static const uint minVectorN=8;
+
+#define RAI_SIMD_DEFINE(T) \
+  template<> void add(T* x, const T* y, uint n) { if(n<minVectorN) scalar::add(x, y, n); else dispatch<T>().active->add(x, y, n); } \
+  template<> void sub(T* x, const T* y, uint n) { if(n<minVectorN) scalar::sub(x, y, n); else dispatch<T>().active->sub(x, y, n); } \
+  template<> void mul(T* x, const T* y, uint n) { if(n<minVectorN) scalar::mul(x, y, n); else dispatch<T>().active->mul(x, y, n); } \
+  template<> void div(T* x, const T* y, uint n) { if(n<minVectorN) scalar::div(x, y, n); else dispatch<T>().active->div(x, y, n); } \
+  template<> void add(T* x, T c, uint n) { if(n<minVectorN) scalar::add(x, c, n); else dispatch<T>().active->addc(x, c, n); } \
+  template<> void sub(T* x, T c, uint n) { if(n<minVectorN) scalar::sub(x, c, n); else dispatch<T>().active->subc(x, c, n); } \
+  template<> void mul(T* x, T c, uint n) { if(n<minVectorN) scalar::mul(x, c, n); else dispatch<T>().active->mulc(x, c, n); } \
+  template<> void div(T* x, T c, uint n) { if(n<minVectorN) scalar::div(x, c, n); else dispatch<T>().active->divc(x, c, n); } \
+  template<> T sum(const T* x, uint n) { if(n<minVectorN) return scalar::sum(x, n); return dispatch<T>().active->sum(x, n); } \
+  template<> T sumOfSqr(const T* x, uint n) { if(n<minVectorN) return scalar::sumOfSqr(x, n); return dispatch<T>().active->sumOfSqr(x, n); } \
+  template<> T dot(const T* x, const T* y, uint n) { if(n<minVectorN) return scalar::dot(x, y, n); return dispatch<T>().active->dot(x, y, n); } \
+  template<> T absMax(const T* x, uint n) { if(n<minVectorN) return scalar::absMax(x, n); return dispatch<T>().active->absMax(x, n); } \
+  template<> void sqrt(T* x, const T* y, uint n) { if(n<minVectorN) scalar::sqrt(x, y, n); else dispatch<T>().active->sqrt(x, y, n); } \
+  template<> void fabs(T* x, const T* y, uint n) { if(n<minVectorN) scalar::fabs(x, y, n); else dispatch<T>().active->fabs(x, y, n); }
+RAI_SIMD_DEFINE(double)
+RAI_SIMD_DEFINE(float)
+#undef RAI_SIMD_DEFINE
+
+} //namespace simd
+} //namespace rai
@@ -0,0 +1,96 @@
+/*  ------------------------------------------------------------------
+    Copyright (c) 2011-2020 Marc Toussaint
+    email: toussaint@tu-berlin.de
+
+    This code is distributed under the MIT License.
+    Please see <root-path>/LICENSE for details.
+    --------------------------------------------------------------  */
+
+#pragma once
+
+#include "util.h"
+#include <cmath>
+
+//===========================================================================
+//
+// elementwise and reduction kernels on contiguous memory, used by the Array operators;
+// for double and float they are vectorized (AVX2/AVX-512 on x86, chosen at runtime
+// depending on the CPU), for all other types they are plain loops
+//
+
+namespace rai {
+namespace simd {
+
+enum InstructionSet { IS_scalar=0, IS_avx2, IS_avx512 };
+
+InstructionSet instructionSet();                   ///< the instruction set currently used by the double/float kernels
+InstructionSet bestInstructionSet();               ///< the best one supported by this CPU (and compiler)
+void setInstructionSet(InstructionSet is);         ///< e.g. for benchmarking; HALTs if not supported
+const char* instructionSetName(InstructionSet is);
+
+//-- plain loops: the generic implementation, and the reference for the vectorized ones
+namespace scalar {
+template<class T> void add(T* x, const T* y, uint n) { for(uint i=0; i<n; i++) x[i] += y[i]; }
+template<class T> void sub(T* x, const T* y, uint n) { for(uint i=0; i<n; i++) x[i] -= y[i]; }
+template<class T> void mul(T* x, const T* y, uint n) { for(uint i=0; i<n; i++) x[i] *= y[i]; }
+template<class T> void div(T* x, const T* y, uint n) { for(uint i=0; i<n; i++) x[i] /= y[i]; }
+template<class T> void add(T* x, T c, uint n) { for(uint i=0; i<n; i++) x[i] += c; }
+template<class T> void sub(T* x, T c, uint n) { for(uint i=0; i<n; i++) x[i] -= c; }
+template<class T> void mul(T* x, T c, uint n) { for(uint i=0; i<n; i++) x[i] *= c; }
+template<class T> void div(T* x, T c, uint n) { for(uint i=0; i<n; i++) x[i] /= c; }
+template<class T> T sum(const T* x, uint n) { T t(0); for(uint i=n; i--;) t += x[i]; return t; }
+template<class T> T sumOfSqr(const T* x, uint n) { T t(0); for(uint i=n; i--;) t += x[i]*x[i]; return t; }
+template<class T> T dot(const T* x, const T* y, uint n) { T t(0); for(uint i=n; i--;) t += x[i]*y[i]; return t; }
+template<class T> T absMax(const T* x, uint n) {
+  if(!n) return (T)0;
+  T t((T)std::fabs((double)x[0]));
+  for(uint i=1; i<n; i++) if(std::fabs((double)x[i])>t) t=(T)std::fabs((double)x[i]);
+  return t;
+}
+template<class T> void sqrt(T* x, const T* y, uint n) { for(uint i=0; i<n; i++) x[i] = (T)std::sqrt((double)y[i]); }
+template<class T> void fabs(T* x, const T* y, uint n) { for(uint i=0; i<n; i++) x[i] = (T)std::fabs((double)y[i]); }
+}
+
+//-- x op= y
+template<class T> void add(T* x, const T* y, uint n) { scalar::add(x, y, n); }
+template<class T> void sub(T* x, const T* y, uint n) { scalar::sub(x, y, n); }
+template<class T> void mul(T* x, const T* y, uint n) { scalar::mul(x, y, n); }
+template<class T> void div(T* x, const T* y, uint n) { scalar::div(x, y, n); }
+
+//-- x op= c
+template<class T> void add(T* x, T c, uint n) { scalar::add(x, c, n); }
+template<class T> void sub(T* x, T c, uint n) { scalar::sub(x, c, n); }
+template<class T> void mul(T* x, T c, uint n) { scalar::mul(x, c, n); }
+template<class T> void div(T* x, T c, uint n) { scalar::div(x, c, n); }
+
+//-- reductions
+template<class T> T sum(const T* x, uint n) { return scalar::sum(x, n); }
+template<class T> T sumOfSqr(const T* x, uint n) { return scalar::sumOfSqr(x, n); }
+template<class T> T dot(const T* x, const T* y, uint n) { return scalar::dot(x, y, n); }
+template<class T> T absMax(const T* x, uint n) { return scalar::absMax(x, n); }
+
+//-- x = f(y)
+template<class T> void sqrt(T* x, const T* y, uint n) { scalar::sqrt(x, y, n); }
+template<class T> void fabs(T* x, const T* y, uint n) { scalar::fabs(x, y, n); }
+
+#define RAI_SIMD_SPECIALIZE(T) \
+  template<> void add(T* x, const T* y, uint n); \
+  template<> void sub(T* x, const T* y, uint n); \
+  template<> void mul(T* x, const T* y, uint n); \
+  template<> void div(T* x, const T* y, uint n); \
+  template<> void add(T* x, T c, uint n); \
+  template<> void sub(T* x, T c, uint n); \
+  template<> void mul(T* x, T c, uint n); \
+  template<> void div(T* x, T c, uint n); \
+  template<> T sum(const T* x, uint n); \
+  template<> T sumOfSqr(const T* x, uint n); \
+  template<> T dot(const T* x, const T* y, uint n); \
+  template<> T absMax(const T* x, uint n); \
+  template<> void sqrt(T* x, const T* y, uint n); \
+  template<> void fabs(T* x, const T* y, uint n);
+RAI_SIMD_SPECIALIZE(double)
+RAI_SIMD_SPECIALIZE(float)
+#undef RAI_SIMD_SPECIALIZE
+
+} //namespace simd
+} //namespace rai
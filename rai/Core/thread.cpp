@@ -543,6 +543,84 @@ void Thread::main() {
   event.setStatus(tsIsClosed);
 }
 
+//===========================================================================
+//
+// ThreadPool
+//
+
+ThreadPool::ThreadPool(uint numThreads) : next(0) {
+  if(!numThreads) numThreads = std::thread::hardware_concurrency();
+  if(!numThreads) numThreads = 1;
+  for(uint w=1; w<numThreads; w++) workers.emplace_back(&ThreadPool::loop, this, w);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    quit=true;
+  }
+  wakeup.notify_all();
+  for(std::thread& th:workers) th.join();
+}
+
+void ThreadPool::work(uint worker) {
+  for(;;) {
+    uint i = next++;
+    if(i>=jobN) break;
+    try {
+      (*job)(i, worker);
+    } catch(...) {
+      std::unique_lock<std::mutex> lock(mutex);
+      if(!error) error = std::current_exception();
+      next = jobN; //skip remaining iterations
+    }
+  }
+}
+
+void ThreadPool::loop(uint worker) {
+  uint seen=0;
+  for(;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wakeup.wait(lock, [this, &seen]() { return quit || generation!=seen; });
+      if(quit) return;
+      seen = generation;
+    }
+    work(worker);
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      if(!--running) done.notify_all();
+    }
+  }
+}
+
+void ThreadPool::parallelFor(uint n, const std::function<void(uint, uint)>& f) {
+  if(!n) return;
+  if(!workers.size() || n==1) {
+    for(uint i=0; i<n; i++) f(i, 0);
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    job = &f;
+    jobN = n;
+    next = 0;
+    error = nullptr;
+    running = workers.size();
+    generation++;
+  }
+  wakeup.notify_all();
+  work(0);
+  std::exception_ptr e;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]() { return !running; });
+    job = nullptr;
+    e = error;
+  }
+  if(e) std::rethrow_exception(e);
+}
+
 //===========================================================================
 //
 // controlling threads
@@ -16,6 +16,7 @@
 #include <shared_mutex>
 #include <condition_variable>
 #include <thread>
+#include <atomic>
 
 enum ThreadState { tsIsClosed=-6, tsToOpen=-1, tsLOOPING=-2, tsBEATING=-3, tsIDLE=0, tsToStep=1, tsToClose=-4,  tsFAILURE=-5,  }; //positive states indicate steps-to-go
 struct Signaler;
@@ -317,6 +318,33 @@ struct CycleTimer {
   rai::String report();
 };
 
+//===========================================================================
+
+/** A fixed set of worker threads to run the iterations of a loop in parallel.
+ *  The calling thread participates as worker 0, so a pool of size 1 runs everything serially.
+ *  parallelFor is not reentrant: don't call it concurrently or from within a loop body */
+struct ThreadPool : NonCopyable {
+  ThreadPool(uint numThreads=0); ///< numThreads=0 means: as many as hardware threads
+  ~ThreadPool();
+
+  uint size() const { return workers.size()+1; }
+
+  /// calls f(i, worker) for all i<n (dynamically scheduled); blocks until all are done; rethrows the first exception thrown by any f
+  void parallelFor(uint n, const std::function<void(uint i, uint worker)>& f);
+
+ private:
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wakeup, done;
+  const std::function<void(uint, uint)>* job=nullptr;
+  uint jobN=0, running=0, generation=0;
+  std::atomic<uint> next;
+  std::exception_ptr error;
+  bool quit=false;
+  void work(uint worker);
+  void loop(uint worker);
+};
+
 //===========================================================================
 /**
  * A Thread does some calculation and shares the result via a VariableData.
@@ -9,7 +9,13 @@
 #include "geo.h"
 #include "../Core/array.h"
 
+#include "../Core/simd.h"
+
 #include <algorithm>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define RAI_BATCH_AVX2
+#  include <immintrin.h>
+#endif
 #ifdef RAI_GL
 #  include <GL/glu.h>
 #endif
@@ -939,8 +945,8 @@ arr Quaternion::getEulerRPY() const {
 }
 
 void Quaternion::applyOnPointArray(arr& pts) {
-  arr R = ~getArr(); //transposed, to make it applicable to an n-times-3 array
-  pts = pts * R;
+  CHECK_EQ(pts.d1, 3, "");
+  batch::transformPoints(pts.p, pts.d0, Transformation(Vector(0), *this));
 }
 
 /// this is a 3-by-4 matrix $J$, giving the angular velocity vector $w = J \dot q$  induced by a $\dot q$
@@ -1443,10 +1449,8 @@ arr& Transformation::applyOnPointArray(arr& pts) const {
     return pts;
   }
   if(!rot.isZero) {
-    arr R = ~rot.getArr(); //transposed, only to make it applicable to an n-times-3 array
-    pts = pts * R;
-  }
-  if(!pos.isZero) {
+    batch::transformPoints(pts.p, pts.N/3, *this);
+  } else if(!pos.isZero) {
     for(double* p=pts.p, *pstop=pts.p+pts.N; p<pstop; p+=3) {
       p[0] += pos.x;
       p[1] += pos.y;
@@ -2047,6 +2051,172 @@ std::ostream& operator<<(std::ostream& os, const Matrix& x)    { x.write(os); re
 std::ostream& operator<<(std::ostream& os, const Quaternion& x) { x.write(os); return os; }
 std::ostream& operator<<(std::ostream& os, const Transformation& x)     { x.write(os); return os; }
 
+//===========================================================================
+//
+// batch operations
+//
+
+namespace batch {
+
+//-- the kernels are written once for plain doubles (W=1) and for vector registers of W doubles (GCC vector arithmetic),
+//   with the same operation order as the single operations (Quaternion::getMatrix, mult, Quaternion::append)
+
+#define RAI_BATCH_QUAT_MATRIX(V, r, qw, qx, qy, qz, ONE) \
+  { V P1=qx+qx, P2=qy+qy, P3=qz+qz; \
+    V q11=qx*P1, q22=qy*P2, q33=qz*P3, q12=qx*P2, q13=qx*P3, q23=qy*P3, q01=qw*P1, q02=qw*P2, q03=qw*P3; \
+    r[0]=ONE-q22-q33; r[1]=q12-q03;     r[2]=q13+q02; \
+    r[3]=q12+q03;     r[4]=ONE-q11-q33; r[5]=q23-q01; \
+    r[6]=q13-q02;     r[7]=q23+q01;     r[8]=ONE-q11-q22; }
+
+#define RAI_BATCH_KERNELS(ISA, TARGET, V, W, LOAD, STORE, SET1) \
+  namespace ISA { \
+  TARGET void transformPoints(double* x, double* y, double* z, uint& i, uint n, const double* R, const double* t) { \
+    V r[9], t0=SET1(t[0]), t1=SET1(t[1]), t2=SET1(t[2]); \
+    for(uint k=0; k<9; k++) r[k]=SET1(R[k]); \
+    for(; i+W<=n; i+=W) { \
+      V px=LOAD(x+i), py=LOAD(y+i), pz=LOAD(z+i); \
+      STORE(x+i, r[0]*px + r[1]*py + r[2]*pz + t0); \
+      STORE(y+i, r[3]*px + r[4]*py + r[5]*pz + t1); \
+      STORE(z+i, r[6]*px + r[7]*py + r[8]*pz + t2); \
+    } } \
+  TARGET void rotatePoints(double* x, double* y, double* z, const double* q, uint& i, uint n) { \
+    V one=SET1(1.), r[9]; \
+    for(; i+W<=n; i+=W) { \
+      V qw=LOAD(q+i), qx=LOAD(q+n+i), qy=LOAD(q+2*n+i), qz=LOAD(q+3*n+i); \
+      RAI_BATCH_QUAT_MATRIX(V, r, qw, qx, qy, qz, one); \
+      V px=LOAD(x+i), py=LOAD(y+i), pz=LOAD(z+i); \
+      STORE(x+i, r[0]*px + r[1]*py + r[2]*pz); \
+      STORE(y+i, r[3]*px + r[4]*py + r[5]*pz); \
+      STORE(z+i, r[6]*px + r[7]*py + r[8]*pz); \
+    } } \
+  TARGET void compose(double* Z, const double* X, const double* Y, uint& i, uint n) { \
+    V one=SET1(1.), r[9]; \
+    for(; i+W<=n; i+=W) { \
+      V xp0=LOAD(X+i), xp1=LOAD(X+n+i), xp2=LOAD(X+2*n+i), xw=LOAD(X+3*n+i), xx=LOAD(X+4*n+i), xy=LOAD(X+5*n+i), xz=LOAD(X+6*n+i); \
+      V yp0=LOAD(Y+i), yp1=LOAD(Y+n+i), yp2=LOAD(Y+2*n+i), yw=LOAD(Y+3*n+i), yx=LOAD(Y+4*n+i), yy=LOAD(Y+5*n+i), yz=LOAD(Y+6*n+i); \
+      RAI_BATCH_QUAT_MATRIX(V, r, xw, xx, xy, xz, one); \
+      STORE(Z+i,     xp0 + r[0]*yp0 + r[1]*yp1 + r[2]*yp2); \
+      STORE(Z+n+i,   xp1 + r[3]*yp0 + r[4]*yp1 + r[5]*yp2); \
+      STORE(Z+2*n+i, xp2 + r[6]*yp0 + r[7]*yp1 + r[8]*yp2); \
+      STORE(Z+3*n+i, xw*yw - xx*yx - xy*yy - xz*yz); \
+      STORE(Z+4*n+i, xx*yw + xw*yx - xz*yy + xy*yz); \
+      STORE(Z+5*n+i, xy*yw + xz*yx + xw*yy - xx*yz); \
+      STORE(Z+6*n+i, xz*yw - xy*yx + xx*yy + xw*yz); \
+    } } \
+  }
+
+inline double load1(const double* p) { return *p; }
+inline void store1(double* p, double v) { *p=v; }
+inline double set1(double c) { return c; }
+
+RAI_BATCH_KERNELS(scalar, , double, 1, load1, store1, set1)
+
+#ifdef RAI_BATCH_AVX2
+#  define RAI_AVX2 __attribute__((target("avx2")))
+
+RAI_BATCH_KERNELS(avx2, RAI_AVX2, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd)
+
+/// points stored as n x 3: four points (three registers) are de-interleaved into x, y, z registers and back
+RAI_AVX2 void transformPointsInterleaved_avx2(double* p, uint& i, uint n, const double* R, const double* t) {
+  __m256d r[9], t0=_mm256_set1_pd(t[0]), t1=_mm256_set1_pd(t[1]), t2=_mm256_set1_pd(t[2]);
+  for(uint k=0; k<9; k++) r[k]=_mm256_set1_pd(R[k]);
+  for(; i+4<=n; i+=4) {
+    double* q = p+3*i;
+    __m256d a=_mm256_loadu_pd(q), b=_mm256_loadu_pd(q+4), c=_mm256_loadu_pd(q+8); //x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+    __m256d m1=_mm256_permute2f128_pd(a, c, 0x30), m2=_mm256_permute2f128_pd(a, c, 0x21); //x0 y0 y3 z3 | z0 x1 z2 x3
+    __m256d px=_mm256_blend_pd(_mm256_blend_pd(m1, m2, 0xA), b, 0x4);
+    __m256d py=_mm256_permute_pd(_mm256_blend_pd(m1, b, 0x9), 0x5);
+    __m256d pz=_mm256_blend_pd(_mm256_blend_pd(m2, b, 0x2), m1, 0x8);
+    __m256d x = r[0]*px + r[1]*py + r[2]*pz + t0;
+    __m256d y = _mm256_permute_pd(r[3]*px + r[4]*py + r[5]*pz + t1, 0x5); //y1 y0 y3 y2
+    __m256d z = r[6]*px + r[7]*py + r[8]*pz + t2;
+    m1 = _mm256_blend_pd(_mm256_blend_pd(x, y, 0x6), z, 0x8);
+    m2 = _mm256_blend_pd(z, x, 0xA);
+    b = _mm256_blend_pd(_mm256_blend_pd(y, z, 0x2), x, 0x4);
+    _mm256_storeu_pd(q, _mm256_permute2f128_pd(m1, m2, 0x20));
+    _mm256_storeu_pd(q+4, b);
+    _mm256_storeu_pd(q+8, _mm256_permute2f128_pd(m2, m1, 0x31));
+  }
+}
+
+#undef RAI_AVX2
+#endif
+
+#undef RAI_BATCH_KERNELS
+#undef RAI_BATCH_QUAT_MATRIX
+
+inline bool useAVX2() {
+#ifdef RAI_BATCH_AVX2
+  return simd::instructionSet()>=simd::IS_avx2;
+#else
+  return false;
+#endif
+}
+
+void transformPoints(double* pts, uint n, const Transformation& X) {
+  double R[9], t[3]={X.pos.x, X.pos.y, X.pos.z};
+  X.rot.getMatrix(R);
+  uint i=0;
+#ifdef RAI_BATCH_AVX2
+  if(useAVX2()) transformPointsInterleaved_avx2(pts, i, n, R, t);
+#endif
+  for(; i<n; i++) {
+    double* p=pts+3*i, x=p[0], y=p[1], z=p[2];
+    p[0] = R[0]*x + R[1]*y + R[2]*z + t[0];
+    p[1] = R[3]*x + R[4]*y + R[5]*z + t[1];
+    p[2] = R[6]*x + R[7]*y + R[8]*z + t[2];
+  }
+}
+
+void transformPoints(double* x, double* y, double* z, uint n, const Transformation& X) {
+  double R[9], t[3]={X.pos.x, X.pos.y, X.pos.z};
+  X.rot.getMatrix(R);
+  uint i=0;
+#ifdef RAI_BATCH_AVX2
+  if(useAVX2()) avx2::transformPoints(x, y, z, i, n, R, t);
+#endif
+  scalar::transformPoints(x, y, z, i, n, R, t);
+}
+
+void rotatePoints(double* x, double* y, double* z, const double* q, uint n) {
+  uint i=0;
+#ifdef RAI_BATCH_AVX2
+  if(useAVX2()) avx2::rotatePoints(x, y, z, q, i, n);
+#endif
+  scalar::rotatePoints(x, y, z, q, i, n);
+}
+
+void compose(double* Z, const double* X, const double* Y, uint n) {
+  uint i=0;
+#ifdef RAI_BATCH_AVX2
+  if(useAVX2()) avx2::compose(Z, X, Y, i, n);
+#endif
+  scalar::compose(Z, X, Y, i, n);
+}
+
+arr getPoses(const Array<Transformation>& X) {
+  uint n=X.N;
+  arr P(7, n);
+  for(uint i=0; i<n; i++) {
+    const Transformation& x = X.elem(i);
+    P.p[i]=x.pos.x;  P.p[n+i]=x.pos.y;  P.p[2*n+i]=x.pos.z;
+    P.p[3*n+i]=x.rot.w;  P.p[4*n+i]=x.rot.x;  P.p[5*n+i]=x.rot.y;  P.p[6*n+i]=x.rot.z;
+  }
+  return P;
+}
+
+void setPoses(Array<Transformation>& X, const arr& P) {
+  CHECK(P.nd==2 && P.d0==7, "poses need to be stored as 7 x n");
+  uint n=P.d1;
+  X.resize(n);
+  for(uint i=0; i<n; i++) {
+    X.elem(i).pos.set(P.p[i], P.p[n+i], P.p[2*n+i]);
+    X.elem(i).rot.set(P.p[3*n+i], P.p[4*n+i], P.p[5*n+i], P.p[6*n+i]);
+  }
+}
+
+} //namespace batch
+
 } //namespace rai
 
 //===========================================================================
@@ -383,6 +383,21 @@ std::ostream& operator<<(std::ostream&, const Matrix&);
 std::ostream& operator<<(std::ostream&, const Quaternion&);
 std::ostream& operator<<(std::ostream&, const Transformation&);
 
+//===========================================================================
+//
+// batch operations on many points or poses stored contiguously; vectorized (AVX2 if the CPU supports it,
+// see rai::simd) and equal to the single operations above up to rounding
+//
+
+namespace batch {
+void transformPoints(double* pts, uint n, const Transformation& X); ///< pts_i = X * pts_i for n points stored as n x 3 (e.g. Mesh::V, point clouds)
+void transformPoints(double* x, double* y, double* z, uint n, const Transformation& X); ///< the same for points stored as separate coordinate arrays
+void rotatePoints(double* x, double* y, double* z, const double* q, uint n); ///< p_i = q_i * p_i, with the n quaternions stored as 4 x n (all w, all x, all y, all z)
+void compose(double* Z, const double* X, const double* Y, uint n); ///< Z_i = X_i * Y_i for n poses stored as 7 x n (rows pos.x, pos.y, pos.z, rot.w, rot.x, rot.y, rot.z); Z may alias X or Y
+arr getPoses(const Array<Transformation>& X); ///< the 7 x n layout used by compose
+void setPoses(Array<Transformation>& X, const arr& P);
+}
+
 } //END of namespace
 
 //===========================================================================
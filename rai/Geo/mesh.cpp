@@ -343,7 +343,9 @@ void rai::Mesh::translate(const arr& d) {
 }
 
 void rai::Mesh::transform(const rai::Transformation& t) {
-  t.applyOnPointArray(V);
+  if(!V.N) return;
+  CHECK_EQ(V.d1, 3, "");
+  rai::batch::transformPoints(V.p, V.d0, t);
 }
 
 rai::Vector rai::Mesh::center() {
@@ -1199,7 +1201,7 @@ void rai::Mesh::readPlyFile(std::istream& is) {
 }
 
 #ifdef RAI_PLY
-void rai::Mesh::writePLY(const char* fn, bool bin) {
+void rai::Mesh::writePLY(const char* fn, bool bin) const {
   struct PlyFace { unsigned char nverts;  int* verts; };
   struct Vertex { float x,  y,  z ;  };
   uint _nverts = V.d0;
@@ -1358,13 +1360,13 @@ void rai::Mesh::readPLY(const char* fn) {
 }
 
 #else
-void rai::Mesh::writePLY(const char* fn, bool bin) {
+void rai::Mesh::writePLY(const char* fn, bool bin) const {
   writeAssimp(*this, fn, "ply");
 }
 void rai::Mesh::readPLY(const char* fn) { NICO }
 #endif
 
-void rai::Mesh::writeArr(std::ostream& os) {
+void rai::Mesh::writeArr(std::ostream& os) const {
   V.writeTagged(os, "V", true);
   T.writeTagged(os, "T", true);
   C.writeTagged(os, "C", true);
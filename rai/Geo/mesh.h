@@ -38,7 +38,7 @@ struct Mesh : GLDrawer {
   int texture=-1;       ///< GL texture name created with glBindTexture
 
   uintAA graph;         ///< for every vertex, the set of neighboring vertices
-  shared_ptr<ANN> ann;
+  mutable shared_ptr<ANN> ann; ///< lazily built nearest neighbor index of V (a cache, e.g. for point cloud collisions)
 
   rai::Transformation glX; ///< transform (only used for drawing! Otherwise use applyOnPoints)  (optional)
 
@@ -124,9 +124,9 @@ struct Mesh : GLDrawer {
   void readPlyFile(std::istream& is);
   void writeTriFile(const char* filename);
   void writeOffFile(const char* filename);
-  void writePLY(const char* fn, bool bin=true);
+  void writePLY(const char* fn, bool bin=true) const;
   void readPLY(const char* fn);
-  void writeArr(std::ostream&);
+  void writeArr(std::ostream&) const;
   void readArr(std::istream&);
 
   void glDraw(struct OpenGL&);
@@ -29,7 +29,7 @@ extern "C" {
 #  define FCLmode
 #endif
 
-PairCollision::PairCollision(rai::Mesh& _mesh1, rai::Mesh& _mesh2, const rai::Transformation& _t1, const rai::Transformation& _t2, double rad1, double rad2)
+PairCollision::PairCollision(const rai::Mesh& _mesh1, const rai::Mesh& _mesh2, const rai::Transformation& _t1, const rai::Transformation& _t2, double rad1, double rad2)
   : mesh1(&_mesh1), mesh2(&_mesh2), t1(&_t1), t2(&_t2), rad1(rad1), rad2(rad2) {
 
   distance=-1.;
@@ -38,6 +38,9 @@ PairCollision::PairCollision(rai::Mesh& _mesh1, rai::Mesh& _mesh2, const rai::Tr
   //-- special cases: point to pcl
   if(_mesh1.V.d0==1 && _mesh2.V.d0>2 && !_mesh2.T.N){
     CHECK(_t2.isZero(), "");
+    //the meshes may be shared between configurations and threads: build and query the (lazy, non-reentrant) index exclusively
+    static std::mutex annMutex;
+    std::lock_guard<std::mutex> lock(annMutex);
     if(!_mesh2.ann){
       _mesh2.ann = make_shared<ANN>();
       _mesh2.ann->setX(_mesh2.V);
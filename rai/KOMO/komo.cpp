@@ -34,6 +34,7 @@
 #include "../Optim/opt-ceres.h"
 
 #include "../Core/util.ipp"
+#include "../Core/thread.h"
 
 #include <iomanip>
 
@@ -71,6 +72,7 @@ KOMO::KOMO() : computeCollisions(true) {
 }
 
 KOMO::~KOMO() {
+  session.reset(); //refers to x, dual and the configurations
   if(logFile) delete logFile;
   objs.clear();
   objectives.clear();
@@ -107,6 +109,8 @@ void KOMO::clone(const KOMO& komo, bool deepCopyFeatures){
 
   if(komo.fcl) fcl=komo.fcl;
   if(komo.swift) swift=komo.swift;
+  fclWorkers=komo.fclWorkers;
+  collisionPool=komo.collisionPool;
 
   //directly copy pathConfig instead of recreating it (including switches)
   pathConfig.copy(komo.pathConfig, false);
@@ -125,6 +129,7 @@ void KOMO::clone(const KOMO& komo, bool deepCopyFeatures){
     if(deepCopyFeatures) f = f->deepCopy();
     auto ocopy = objs.append(make_shared<GroundedObjective>(f, o->type, o->timeSlices));
     ocopy->frames = pathConfig.getFrames(framesToIndices(o->frames));
+    ocopy->objId = o->objId;
   }
 }
 
@@ -751,12 +756,73 @@ void KOMO::updateAndShiftPrefix(const Configuration& C){
   updateRootObjects(C);
 }
 
+void KOMO::shiftSolution(int steps) {
+  CHECK_GE(steps, 0, "");
+  if(!steps || !T) return;
+
+  //-- path: q_t <- q_{t+steps}
+  for(int t=0; t<(int)T; t++) setConfiguration_qOrg(t, getConfiguration_qOrg(rai::MIN(t+steps, (int)T-1)));
+  x = pathConfig.getJointState();
+
+  //-- duals: a grounded objective takes the duals of its successor, which is the grounded objective of the same objective
+  //   at the same position among those grounded steps slices later; those without successor (horizon end) keep theirs
+  if(!dual.N) return;
+  uintA starts(objs.N+1);
+  uint M=0;
+  for(uint i=0; i<objs.N; i++) { starts(i)=M;  M += objs(i)->feat->dim(objs(i)->frames); }
+  starts(objs.N)=M;
+  CHECK_LE(M, dual.N, "duals don't match the grounded objectives - call reset() after changing objectives");
+  std::map<std::pair<int, int>, uintA> grounded;
+  for(uint i=0; i<objs.N; i++) grounded[{objs(i)->objId, objs(i)->timeSlices.last()}].append(i);
+  arr dual_old = dual;
+  for(auto& g:grounded) {
+    auto succ = grounded.find({g.first.first, g.first.second+steps});
+    if(succ==grounded.end()) continue;
+    for(uint k=0; k<g.second.N && k<succ->second.N; k++) {
+      uint i=g.second(k), j=succ->second(k);
+      uint d=starts(i+1)-starts(i);
+      if(starts(j+1)-starts(j)!=d) continue;
+      for(uint l=0; l<d; l++) dual.p[starts(i)+l] = dual_old.p[starts(j)+l];
+    }
+  }
+}
+
 void KOMO::reset() {
+  session.reset();
+  runTimes.clear();
+  runCount=0;
   dual.clear();
   featureValues.clear();
   featureJacobians.clear();
   featureTypes.clear();
   timeTotal=timeCollisions=timeKinematics=timeNewton=timeFeatures=0.;
+  collisionSliceQueries=collisionSliceCacheHits=0;
+  collisionStatesCache.clear();
+  collisionPairsCache.clear();
+  jacobianPattern.clear();
+  pathConfig.kinematicsMemoQueries=pathConfig.kinematicsMemoHits=0;
+}
+
+bool rai::KOMO_JacobianPattern::isValid(const rai::Array<ptr<GroundedObjective>>& _objs, const ProxyA& _proxies, bool csr) const {
+  if(!objStarts.N) return false;
+  if(csr && !csrSlots.N) return false;
+  if(objs.N!=_objs.N || 2*_proxies.N!=proxies.N) return false;
+  for(uint i=0; i<objs.N; i++) if(objs.elem(i)!=_objs.elem(i)) return false;
+  for(uint i=0; i<_proxies.N; i++) {
+    if(proxies.elem(2*i)!=_proxies.elem(i).a->ID || proxies.elem(2*i+1)!=_proxies.elem(i).b->ID) return false;
+  }
+  return true;
+}
+
+void rai::KOMO_JacobianPattern::clear() {
+  elems.clear();
+  objStarts.clear();
+  objs.clear();
+  proxies.clear();
+  csrRowPtr.clear();
+  csrColIdx.clear();
+  csrSlots.clear();
+  queries=hits=0;
 }
 
 //default - transcription as sparse, but non-factored NLP
@@ -766,13 +832,32 @@ struct Conv_KOMO_SparseNonfactored : MathematicalProgram {
 
   arr quadraticPotentialLinear, quadraticPotentialHessian;
 
+  uintA featureStarts;  ///< for each grounded objective, its first index in phi
+  arrA featureBuffer;   ///< for each grounded objective, the (sparse) Jacobian of the last evaluation
+
+  //-- only for komo.opt.secondOrderKinematics
+  arr fHessian, fHessian_x; ///< the second-order terms of the last evaluation, and where it was evaluated
+
+  //-- only for parallel evaluation (komo.opt.evalThreads)
+  shared_ptr<ThreadPool> pool;
+  uintAA evalGroups;    ///< grounded objectives sharing the same feature (features are not reentrant -> same worker)
+
+  //-- only for clones
+  shared_ptr<KOMO> komoClone; ///< the cloned KOMO this conversion refers to (and owns)
+
   Conv_KOMO_SparseNonfactored(KOMO& _komo, bool sparse=true);
 
   virtual arr getInitializationSample(const arr& previousOptima= {});
+  virtual shared_ptr<MathematicalProgram> clone();
   virtual void evaluate(arr& phi, arr& J, const arr& x);
   virtual void getFHessian(arr& H, const arr& x);
 
   virtual void report(ostream& os, int verbose);
+
+ private:
+  void evaluateParallel(arr& phi, arr& J);
+  void assembleSparseJacobian(arr& J, uint n);
+  void evaluateHessian(const arr& phi, const arr& x);
 };
 
 //this treats EACH BRANCH and dof as its own variable
@@ -854,7 +939,30 @@ struct Conv_KOMO_TimeSliceProblem : MathematicalProgram {
   virtual void evaluate(arr& phi, arr& J, const arr& x);
 };
 
+//the persistent solver of KOMO::run with opt.solverSession
+struct rai::KOMO_SolverSession {
+  shared_ptr<Conv_KOMO_SparseNonfactored> P;
+  shared_ptr<OptConstrained> solver;
+  KOMOsolver solverType;
+  rai::Array<ptr<GroundedObjective>> objs; ///< the grounded objectives the session was set up for (held, so their addresses cannot be reused while compared)
+  uint dimension;
+  uint cycles=0;
+
+  KOMO_SolverSession(KOMO& komo, const OptOptions& options) : solverType(komo.solver), dimension(komo.x.N) {
+    P = make_shared<Conv_KOMO_SparseNonfactored>(komo, komo.solver==KS_sparse);
+    solver = make_shared<OptConstrained>(komo.x, komo.dual, P, options, komo.logFile);
+    objs = komo.objs;
+  }
+
+  bool isValid(const KOMO& komo) const {
+    if(komo.solver!=solverType || komo.x.N!=dimension || komo.objs.N!=objs.N) return false;
+    for(uint i=0; i<objs.N; i++) if(objs(i)!=komo.objs(i)) return false;
+    return true;
+  }
+};
+
 void KOMO::optimize(double addInitializationNoise, const OptOptions options) {
+  if(opt.solverSession && session) addInitializationNoise=0.; //warm start from the (shifted) previous solution
   run_prepare(addInitializationNoise);
 
   if(opt.verbose>1) reportProblem();
@@ -892,6 +1000,8 @@ void KOMO::run(OptOptions options) {
   }
 
   options.verbose = rai::MAX(opt.verbose-2, 0);
+  rai::ArrayArena arena; //keeps the recycled array buffers across all evaluations of this run (bounded by ArrayArena::maxCachedBytes)
+  double runStart = rai::realTime();
   timeTotal -= rai::cpuTime();
   CHECK(T, "");
   if(logFile)(*logFile) <<"KOMO_run_log: [" <<endl;
@@ -899,6 +1009,14 @@ void KOMO::run(OptOptions options) {
   if(solver==rai::KS_none) {
     HALT("you need to choose a KOMO solver");
 
+  } else if(opt.solverSession && (solver==rai::KS_dense || solver==rai::KS_sparse)) {
+    if(session && !session->isValid(*this)) session.reset();
+    if(!session) session = make_shared<KOMO_SolverSession>(*this, options);
+    else session->solver->reinit();
+    session->solver->run();
+    session->cycles++;
+    timeNewton += session->solver->newton.timeNewton;
+
   } else if(solver==rai::KS_dense || solver==rai::KS_sparse) {
     Conv_KOMO_SparseNonfactored P(*this, solver==rai::KS_sparse);
     OptConstrained _opt(x, dual, P.ptr(), options, logFile);
@@ -943,11 +1061,14 @@ void KOMO::run(OptOptions options) {
   } else NIY;
 
   timeTotal += rai::cpuTime();
+  if(runTimes.N<runTimesCapacity) runTimes.append(rai::realTime()-runStart);
+  else runTimes(runCount%runTimesCapacity) = rai::realTime()-runStart;
+  runCount++;
 
   if(logFile)(*logFile) <<"\n] #end of KOMO_run_log" <<endl;
   if(opt.verbose>0) {
     cout <<"** optimization time:" <<timeTotal
-         <<" (kin:" <<timeKinematics <<" coll:" <<timeCollisions <<" feat:" <<timeFeatures <<" newton: " <<timeNewton <<")"
+         <<" (kin:" <<timeKinematics <<" coll:" <<timeCollisions <<" (slice cache hits:" <<collisionSliceCacheHits <<'/' <<collisionSliceQueries <<")" <<" feat:" <<timeFeatures <<" (jacobian pattern hits:" <<jacobianPattern.hits <<'/' <<jacobianPattern.queries <<" kinematics memo hits:" <<pathConfig.kinematicsMemoHits <<'/' <<pathConfig.kinematicsMemoQueries <<")" <<" newton: " <<timeNewton <<")"
          <<" setJointStateCount:" <<Configuration::setJointStateCount
         <<"\n   sos:" <<sos <<" ineq:" <<ineq <<" eq:" <<eq <<endl;
   }
@@ -1177,6 +1298,8 @@ void KOMO::setupPathConfig() {
   //Therefore configurations(0) is for time=-k and configurations(k+t) is for time=t
   CHECK(timeSlices.d0 != k_order+T, "why setup again?");
   CHECK(!pathConfig.frames.N, "why setup again?");
+  collisionStatesCache.clear();
+  collisionPairsCache.clear();
 
   //computeMeshNormals(world.frames, true);
   //computeMeshGraphs(world.frames, true);
@@ -1190,6 +1313,16 @@ void KOMO::setupPathConfig() {
     CHECK(!swift, "");
     if(!opt.useFCL) swift = C.swift();
     else fcl = C.fcl();
+
+    if(opt.useFCL && (opt.collisionThreads>1 || opt.collisionThreads<0)) {
+      collisionPool = make_shared<ThreadPool>(opt.collisionThreads>0 ? opt.collisionThreads : 0);
+      //-- one more FclInterface per worker on the same geometries (meshes were created by C.fcl())
+      Array<ptr<Mesh>> geometries(C.frames.N);
+      for(Frame* f:C.frames) if(f->shape && f->shape->cont) geometries(f->ID) = f->shape->_mesh;
+      fclWorkers.resize(collisionPool->size());
+      fclWorkers(0) = fcl;
+      for(uint w=1; w<fclWorkers.N; w++) fclWorkers(w) = make_shared<rai::FclInterface>(geometries, fcl->cutoff);
+    }
   }
 
   for(uint s=0;s<k_order+T;s++) {
@@ -1229,6 +1362,7 @@ void KOMO::setupPathConfig() {
 
   pathConfig.ensure_q();
   pathConfig.checkConsistency();
+  pathConfig.useKinematicsMemo = opt.kinematicsMemo;
 }
 
 void KOMO::getBounds(arr& bounds_lo, arr& bounds_up) {
@@ -1283,18 +1417,54 @@ void KOMO::set_x(const arr& x, const uintA& selectedConfigurationsOnly) {
   if(computeCollisions) {
     timeCollisions -= rai::cpuTime();
     pathConfig.proxies.clear();
-    arr X;
-    uintA collisionPairs;
+    //-- frame states of all time slices in one go (also ensures all frame poses before parallel reads)
+    arr X = pathConfig.getFrameState(timeSlices);
+    X.reshape(timeSlices.d0, timeSlices.d1, 7);
+
+    //-- only slices whose frame state changed since their last query are dirty (all, if geometries or contacts changed)
+    if(collisionStatesCache.nd!=3 || collisionStatesCache.d0!=X.d0 || collisionStatesCache.d1!=X.d1
+       || collisionCacheRevision!=pathConfig._geometry_revision) {
+      collisionStatesCache.clear();
+      collisionPairsCache.clear();
+      collisionPairsCache.resize(timeSlices.d0);
+    }
+    uintA dirty;
     for(uint s=k_order;s<timeSlices.d0;s++){
-      X = pathConfig.getFrameState(timeSlices[s]);
-      if(!opt.useFCL){
-        collisionPairs = swift->step(X);
-      }else{
-        fcl->step(X);
-        collisionPairs = fcl->collisions;
+      if(collisionStatesCache.N && X[s]==collisionStatesCache[s]) collisionSliceCacheHits++;
+      else dirty.append(s);
+    }
+    collisionSliceQueries += timeSlices.d0-k_order;
+
+    auto query = [this, &X](uint s, rai::FclInterface& F){
+      F.step(X[s]);
+      uintA& pairs = collisionPairsCache(s);
+      pairs = F.collisions;
+      //the broadphase tree reports pairs in a history-dependent order -> sort rows to be independent of which worker queried
+      if(pairs.d0>1){
+        uintA perm;
+        perm.setStraightPerm(pairs.d0);
+        std::sort(perm.p, perm.p+perm.N, [&pairs](uint i, uint j){ return pairs(i,0)<pairs(j,0) || (pairs(i,0)==pairs(j,0) && pairs(i,1)<pairs(j,1)); });
+        pairs.permuteRows(perm);
       }
-      collisionPairs += timeSlices.d1 * s; //fcl returns frame IDs related to 'world' -> map them into frameIDs within that time slice
-      pathConfig.addProxies(collisionPairs);
+    };
+    if(!opt.useFCL){
+      for(uint s:dirty) collisionPairsCache(s) = swift->step(X[s]);
+    }else if(collisionPool){
+      collisionPool->parallelFor(dirty.N, [this, &query, &dirty](uint i, uint worker){
+        query(dirty(i), *fclWorkers(worker));
+      });
+    }else{
+      for(uint s:dirty) query(s, *fcl);
+    }
+    collisionStatesCache = X;
+    collisionCacheRevision = pathConfig._geometry_revision;
+
+    //-- merge in slice order
+    uintA pairs;
+    for(uint s=k_order;s<timeSlices.d0;s++){
+      pairs = collisionPairsCache(s);
+      pairs += timeSlices.d1 * s; //fcl returns frame IDs related to 'world' -> map them into frameIDs within that time slice
+      pathConfig.addProxies(pairs);
     }
     pathConfig._state_proxies_isGood=true;
     timeCollisions += rai::cpuTime();
@@ -1378,6 +1548,21 @@ CHECK_EQ(M, featureValues.N, "");
   report.newNode<double>("eq", {}, totalH);
   report.newNode<double>("f", {}, totalF);
 
+  if(runTimes.N) {
+    //latency percentiles (nearest rank) of the last (at most runTimesCapacity) runs
+    arr sorted = runTimes;
+    sorted.sort();
+    auto percentile = [&sorted](double p) { return sorted(rai::MIN(uint(ceil(p*sorted.N)), sorted.N)-1); };
+    Graph& g = report.newSubgraph({"latency"}, {});
+    g.newNode<double>("runs", {}, runCount);
+    g.newNode<double>("window", {}, runTimes.N);
+    g.newNode<double>("mean", {}, sum(runTimes)/runTimes.N);
+    g.newNode<double>("p50", {}, percentile(.5));
+    g.newNode<double>("p90", {}, percentile(.9));
+    g.newNode<double>("p99", {}, percentile(.99));
+    g.newNode<double>("max", {}, sorted.last());
+  }
+
   if(gnuplt) {
     //-- write a nice gnuplot file
     ofstream fil("z.costReport");
@@ -1524,6 +1709,8 @@ StringA KOMO::getCollisionPairs(double belowMargin){
 }
 
 void Conv_KOMO_SparseNonfactored::evaluate(arr& phi, arr& J, const arr& x) {
+  rai::ArrayArena arena; //recycle the buffers of all the feature temporaries (across evaluations when within KOMO::run or MP_Solver::solve)
+
   //-- set the trajectory
   komo.set_x(x);
   if(sparse){
@@ -1533,22 +1720,21 @@ void Conv_KOMO_SparseNonfactored::evaluate(arr& phi, arr& J, const arr& x) {
   }
 
   phi.resize(featureTypes.N);
-  if(!!J) {
-    if(sparse) {
-      J.sparse().resize(phi.N, x.N, 0);
-    } else {
-      J.resize(phi.N, x.N).setZero();
-    }
-  }
+  if(!!J && !sparse) J.resize(phi.N, x.N).setZero();
 
   komo.sos=komo.ineq=komo.eq=0.;
 
   komo.timeFeatures -= rai::cpuTime();
 
   uint M=0;
-  for(shared_ptr<GroundedObjective>& ob : komo.objs) {
+  if(pool) {
+    evaluateParallel(phi, J);
+    M = phi.N;
+  } else for(uint i=0; i<komo.objs.N; i++) {
+      shared_ptr<GroundedObjective>& ob = komo.objs(i);
       //query the task map and check dimensionalities of returns
       arr y = ob->feat->eval(ob->frames);
+      if(sparse) featureBuffer(i).clear();
 //      cout <<"EVAL '" <<ob->name() <<"' phi:" <<y <<endl <<y.J() <<endl<<endl;
       if(!y.N) continue;
       checkNan(y);
@@ -1576,9 +1762,9 @@ void Conv_KOMO_SparseNonfactored::evaluate(arr& phi, arr& J, const arr& x) {
 
       if(!!J) {
         if(sparse){
-          yJ.sparse().reshape(J.d0, J.d1);
-          yJ.sparse().colShift(M);
-          J += yJ;
+          CHECK_EQ(featureStarts(i), M, "feature '" <<ob->name() <<"' returned an unexpected dimension");
+          featureBuffer(i) = yJ;
+          featureBuffer(i).sparse();
         }else{
           J.setMatrixBlock(yJ, M, 0);
         }
@@ -1588,6 +1774,9 @@ void Conv_KOMO_SparseNonfactored::evaluate(arr& phi, arr& J, const arr& x) {
       M += y.N;
   }
 
+  if(!!J && sparse) assembleSparseJacobian(J, x.N);
+  if(!!J && komo.opt.secondOrderKinematics) evaluateHessian(phi, x);
+
   komo.timeFeatures += rai::cpuTime();
 
   CHECK_EQ(M, phi.N, "");
@@ -1602,8 +1791,163 @@ void Conv_KOMO_SparseNonfactored::evaluate(arr& phi, arr& J, const arr& x) {
   }
 }
 
+void Conv_KOMO_SparseNonfactored::evaluateParallel(arr& phi, arr& J) {
+  //all frame poses need to be computed before workers read them concurrently
+  for(Frame* f:komo.pathConfig.frames) f->ensure_X();
+  uint n = komo.pathConfig.getJointStateDimension();
+
+  //-- each worker writes into its own phi slices; Jacobians are buffered per objective
+  pool->parallelFor(evalGroups.N, [this, &phi, &J, n](uint g, uint worker) {
+    rai::ArrayArena arena;
+    for(uint i:evalGroups(g)) {
+      shared_ptr<GroundedObjective>& ob = komo.objs(i);
+      arr y = ob->feat->eval(ob->frames);
+      arr& yJ = featureBuffer(i);
+      yJ.clear();
+      if(!y.N) continue;
+      checkNan(y);
+      CHECK_EQ(featureStarts(i+1)-featureStarts(i), y.N, "feature '" <<ob->name() <<"' returned an unexpected dimension");
+      if(!!J) {
+        CHECK(y.jac, "Jacobian needed but missing");
+        CHECK_EQ(y.J().nd, 2, "");
+        CHECK_EQ(y.J().d0, y.N, "");
+        CHECK_EQ(y.J().d1, n, "");
+        yJ = y.J_reset();
+        if(sparse) yJ.sparse();
+        else J.setMatrixBlock(yJ, featureStarts(i), 0); //rows are disjoint
+      }
+      phi.setVectorBlock(y, featureStarts(i));
+    }
+  });
+
+  //-- deterministic merge in the order of objectives (identical to serial evaluation)
+  for(uint i=0; i<komo.objs.N; i++) {
+    if(featureStarts(i+1)==featureStarts(i)) continue;
+    arr y;
+    y.referToRange(phi, featureStarts(i), featureStarts(i+1)-1);
+    if(absMax(y)>1e10) RAI_MSG("WARNING y=" <<y);
+    ObjectiveType type = komo.objs(i)->type;
+    if(type==OT_sos) komo.sos+=sumOfSqr(y);
+    else if(type==OT_ineq) komo.ineq += sumOfPos(y);
+    else if(type==OT_eq) komo.eq += sumOfAbs(y);
+  }
+
+}
+
+void Conv_KOMO_SparseNonfactored::assembleSparseJacobian(arr& J, uint n) {
+  rai::KOMO_JacobianPattern& P = komo.jacobianPattern;
+  bool csr = komo.opt.csrJacobians;
+  uint m = featureStarts.last();
+
+  //-- check if the feature Jacobians still have the cached pattern (the element-wise compare only if the objectives and proxies match)
+  P.queries++;
+  bool reuse = P.isValid(komo.objs, komo.pathConfig.proxies, csr);
+  for(uint i=0; reuse && i<komo.objs.N; i++) {
+    arr& yJ = featureBuffer(i);
+    if(yJ.N!=P.objStarts(i+1)-P.objStarts(i)) { reuse=false; break; }
+    if(!yJ.N) continue;
+    const int* e = yJ.sparse().elems.p;
+    const int* c = P.elems.p+2*P.objStarts(i);
+    int row = featureStarts(i);
+    for(uint k=0; k<yJ.N; k++, e+=2, c+=2) {
+      if(e[0]+row!=c[0] || e[1]!=c[1]) { reuse=false; break; }
+    }
+  }
+
+  //-- recompute the pattern
+  if(!reuse) {
+    P.objs = komo.objs;
+    P.proxies.resize(2*komo.pathConfig.proxies.N);
+    for(uint i=0; i<komo.pathConfig.proxies.N; i++) {
+      P.proxies(2*i) = komo.pathConfig.proxies(i).a->ID;
+      P.proxies(2*i+1) = komo.pathConfig.proxies(i).b->ID;
+    }
+    P.objStarts.resize(komo.objs.N+1);
+    uint nnz=0;
+    for(uint i=0; i<komo.objs.N; i++) { P.objStarts(i)=nnz;  nnz += featureBuffer(i).N; }
+    P.objStarts(komo.objs.N)=nnz;
+    P.elems.resize(nnz, 2);
+    for(uint i=0; i<komo.objs.N; i++) {
+      arr& yJ = featureBuffer(i);
+      if(!yJ.N) continue;
+      const intA& elems = yJ.sparse().elems;
+      int* e = P.elems.p+2*P.objStarts(i);
+      for(uint k=0; k<yJ.N; k++) {
+        *(e++) = elems.p[2*k] + featureStarts(i);
+        *(e++) = elems.p[2*k+1];
+      }
+    }
+    P.csrRowPtr.clear();  P.csrColIdx.clear();  P.csrSlots.clear();
+  } else P.hits++;
+
+  //-- J keeps its structure from the previous call (solvers pass the same J each time): then only its values are written;
+  //   otherwise (e.g. another J buffer) it is (re)built from the pattern, once
+  if(csr) {
+    if(!reuse) {
+      if(!isCSRMatrix(J)) J.clear();
+      J.csr().setFromTriplets(m, n, P.elems, arr(P.elems.d0).setZero(), P.csrSlots);
+      P.csrRowPtr = J.csr().rowPtr;
+      P.csrColIdx = J.csr().colIdx;
+    } else if(!isCSRMatrix(J) || J.d0!=m || J.d1!=n || J.N!=P.csrColIdx.N
+              || memcmp(J.csr().rowPtr.p, P.csrRowPtr.p, P.csrRowPtr.N*P.csrRowPtr.sizeT)
+              || memcmp(J.csr().colIdx.p, P.csrColIdx.p, P.csrColIdx.N*P.csrColIdx.sizeT)) {
+      if(!isCSRMatrix(J)) J.clear();
+      J.csr().setPattern(m, n, P.csrRowPtr, P.csrColIdx);
+    } else {
+      J.setZero();
+    }
+    for(uint i=0; i<komo.objs.N; i++) {
+      arr& yJ = featureBuffer(i);
+      const uint* slot = P.csrSlots.p+P.objStarts(i);
+      for(uint k=0; k<yJ.N; k++) J.p[slot[k]] += yJ.p[k];
+    }
+  } else {
+    if(!reuse || !isSparseMatrix(J) || J.d0!=m || J.d1!=n || J.N!=P.elems.d0
+       || memcmp(J.sparse().elems.p, P.elems.p, P.elems.N*P.elems.sizeT)) {
+      if(!isSparseMatrix(J)) J.clear();
+      SparseMatrix& S = J.sparse().resize(m, n, P.elems.d0);
+      memmove(S.elems.p, P.elems.p, P.elems.N*P.elems.sizeT);
+    }
+    for(uint i=0; i<komo.objs.N; i++) {
+      arr& yJ = featureBuffer(i);
+      if(yJ.N) memmove(J.p+P.objStarts(i), yJ.p, yJ.N*J.sizeT);
+    }
+  }
+}
+
+/// the Hessian terms that Gauss-Newton neglects: sum_i w_i d^2 phi_i/dq^2 over all rows of f (w_i=1) and sos (w_i=2 phi_i)
+/// objectives, from the analytic Hessian blocks of their features (features without these remain Gauss-Newton)
+void Conv_KOMO_SparseNonfactored::evaluateHessian(const arr& phi, const arr& x) {
+  if(sparse) fHessian.sparse().resize(x.N, x.N, 0);
+  else fHessian.resize(x.N, x.N).setZero();
+  rai::HessianBlock h;
+  arr w;
+  for(uint i=0; i<komo.objs.N; i++) {
+    shared_ptr<GroundedObjective>& ob = komo.objs(i);
+    if(ob->type!=OT_f && ob->type!=OT_sos) continue;
+    uint d = featureStarts(i+1)-featureStarts(i);
+    if(!d || !ob->feat->evalHessian(h, ob->frames)) continue;
+    CHECK_EQ(h.y.N, d, "feature '" <<ob->name() <<"' returned an unexpected Hessian dimension");
+    //the exact Hessian of a feature is indefinite away from its optimum: clip it (jointly with its Gauss-Newton term) to be PSD
+    if(ob->type==OT_f) {
+      h.addWeighted(fHessian, ones(d), zeros(d));
+    } else {
+      w = 2.*phi({featureStarts(i), featureStarts(i+1)-1});
+      h.addWeighted(fHessian, w, consts<double>(2., d));
+    }
+  }
+  fHessian_x = x;
+}
+
 void Conv_KOMO_SparseNonfactored::getFHessian(arr& H, const arr& x) {
-  if(quadraticPotentialLinear.N) {
+  if(komo.opt.secondOrderKinematics) {
+    if(x!=fHessian_x) { arr phi, J;  evaluate(phi, J, x); }
+    H = fHessian;
+    if(quadraticPotentialLinear.N) {
+      if(isSparseMatrix(H)) H = unpack(H);
+      H += quadraticPotentialHessian;
+    }
+  } else if(quadraticPotentialLinear.N) {
     H = quadraticPotentialHessian;
   } else {
     H.clear();
@@ -1644,6 +1988,37 @@ Conv_KOMO_SparseNonfactored::Conv_KOMO_SparseNonfactored(KOMO& _komo, bool spars
     featureTypes.append(OT_f);
   }
   komo.featureTypes = featureTypes;
+
+  featureStarts.resize(komo.objs.N+1);
+  M=0;
+  for(uint i=0; i<komo.objs.N; i++) {
+    featureStarts(i) = M;
+    M += komo.objs(i)->feat->dim(komo.objs(i)->frames);
+  }
+  featureStarts(komo.objs.N) = M;
+  featureBuffer.resize(komo.objs.N);
+
+  //-- setup parallel evaluation
+  if(komo.opt.evalThreads>1 || komo.opt.evalThreads<0) {
+    pool = make_shared<ThreadPool>(komo.opt.evalThreads>0 ? komo.opt.evalThreads : 0);
+    std::map<Feature*, uint> groupOfFeature;
+    for(uint i=0; i<komo.objs.N; i++) {
+      shared_ptr<GroundedObjective>& ob = komo.objs(i);
+      auto it = groupOfFeature.find(ob->feat.get());
+      if(it==groupOfFeature.end()) {
+        it = groupOfFeature.emplace(ob->feat.get(), evalGroups.N).first;
+        evalGroups.append(uintA());
+      }
+      evalGroups(it->second).append(i);
+    }
+    //largest groups first, for better load balance
+    uintA perm;
+    perm.setStraightPerm(evalGroups.N);
+    perm.sort([this](const uint& a, const uint& b) { return evalGroups(a).N>evalGroups(b).N; });
+    uintAA sorted;
+    for(uint g:perm) sorted.append(evalGroups(g));
+    evalGroups = sorted;
+  }
 }
 
 arr Conv_KOMO_SparseNonfactored::getInitializationSample(const arr& previousOptima) {
@@ -1651,6 +2026,20 @@ arr Conv_KOMO_SparseNonfactored::getInitializationSample(const arr& previousOpti
   return komo.x;
 }
 
+shared_ptr<MathematicalProgram> Conv_KOMO_SparseNonfactored::clone() {
+  auto K = make_shared<KOMO>();
+  K->clone(komo);
+  K->x = komo.x;
+  //collision engines are not reentrant: the clone queries its own FclInterface (serially)
+  CHECK(!komo.swift, "clones for concurrent evaluation need FCL collisions (KOMO/useFCL)");
+  K->fclWorkers.clear();
+  K->collisionPool.reset();
+  if(komo.fcl) K->fcl = K->world.fcl(); //(created by setModel within clone)
+  auto P = make_shared<Conv_KOMO_SparseNonfactored>(*K, sparse);
+  P->komoClone = K;
+  return P;
+}
+
 Conv_KOMO_FactoredNLP::Conv_KOMO_FactoredNLP(KOMO& _komo) : komo(_komo) {
   //count variables
   uint xDim = getDimension();
@@ -22,6 +22,7 @@
 namespace rai {
   struct FclInterface;
 }
+struct ThreadPool;
 
 //===========================================================================
 
@@ -38,6 +39,28 @@ namespace rai {
     RAI_PARAM("KOMO/", int, animateOptimization, 0)
     RAI_PARAM("KOMO/", bool, mimicStable, false)
     RAI_PARAM("KOMO/", bool, useFCL, true)
+    RAI_PARAM("KOMO/", int, evalThreads, 0) //0: evaluate objectives serially; >1: number of worker threads; -1: all hardware threads
+    RAI_PARAM("KOMO/", int, collisionThreads, 0) //0: query time slice collisions serially; >1: number of worker threads (one FclInterface each); -1: all hardware threads
+    RAI_PARAM("KOMO/", bool, csrJacobians, false) //return sparse Jacobians in compressed row format (rai::CSRMatrix), which the Optim solvers use directly
+    RAI_PARAM("KOMO/", bool, kinematicsMemo, false) //within one evaluation, objectives share the values and Jacobians of identical kinematics queries (same primitive, frame and rel vector); opt-in, as every stored entry copies the Jacobian
+    RAI_PARAM("KOMO/", bool, secondOrderKinematics, false) //getFHessian returns the exact second-order terms of all sos and f objectives with analytic feature Hessians (beyond Gauss-Newton); solvers only query it when the problem (or its Lagrangian) has f-terms
+    RAI_PARAM("KOMO/", bool, solverSession, false) //KS_sparse/KS_dense: keep the problem conversion and the solver (Newton and factorization workspaces) alive across run() calls while the grounded objectives are unchanged, e.g. in MPC loops; optimize() then adds no initialization noise
+  };
+
+  struct KOMO_SolverSession;
+
+  /// sparsity pattern of the sparse KOMO Jacobian of the last evaluation: while the grounded objectives,
+  /// the proxies and the feature Jacobian patterns are unchanged, evaluations only scatter values into it
+  struct KOMO_JacobianPattern {
+    intA elems;                          ///< (row,col) of all non-zeros, in objective order
+    uintA objStarts;                     ///< for each grounded objective, its first non-zero in elems
+    rai::Array<ptr<GroundedObjective>> objs; ///< the grounded objectives the pattern was computed for (held, so their addresses cannot be reused while compared)
+    uintA proxies;                       ///< the proxies (frame ID pairs) the pattern was computed for
+    uintA csrRowPtr, csrColIdx, csrSlots; ///< only with opt.csrJacobians: the CSR pattern, and the CSR entry of each non-zero
+    uint queries=0, hits=0;
+
+    bool isValid(const rai::Array<ptr<GroundedObjective>>& _objs, const ProxyA& _proxies, bool csr) const;
+    void clear();
   };
 }//namespace
 
@@ -60,6 +83,13 @@ struct KOMO : NonCopyable {
   bool computeCollisions;         ///< whether swift or fcl (collisions/proxies) is evaluated whenever new configurations are set (needed if features read proxy list)
   shared_ptr<rai::FclInterface> fcl;
   shared_ptr<SwiftInterface> swift;
+  rai::Array<shared_ptr<rai::FclInterface>> fclWorkers; ///< one FclInterface per collision worker (fclWorkers(0)==fcl), only with opt.collisionThreads
+  shared_ptr<ThreadPool> collisionPool;
+  uintAA collisionPairsCache;     ///< per time slice: collision pairs (world frame IDs) of its last query
+  arr collisionStatesCache;       ///< per time slice: frame state of its last query (a slice is dirty if its state differs)
+  uint collisionCacheRevision=0;  ///< the pathConfig._geometry_revision the caches were filled with
+  rai::KOMO_JacobianPattern jacobianPattern;
+  shared_ptr<rai::KOMO_SolverSession> session; ///< only with opt.solverSession: the persistent solver of the last run()
 
   //-- optimizer
   rai::KOMOsolver solver=rai::KS_sparse;
@@ -76,6 +106,9 @@ struct KOMO : NonCopyable {
   StringA featureNames;
   double timeTotal=0.;           ///< measured run time
   double timeCollisions=0., timeKinematics=0., timeNewton=0., timeFeatures=0.;
+  uint collisionSliceQueries=0, collisionSliceCacheHits=0; ///< time slices checked for collisions in set_x, and how many of them reused the cached proxies (unchanged frame state)
+  arr runTimes;                  ///< ring buffer: wall time of the last (at most runTimesCapacity) run() calls since the last reset (e.g. the latencies of MPC cycles)
+  uint runTimesCapacity=1000, runCount=0; ///< runCount: all run() calls since the last reset
   ofstream* logFile=0;
 
   KOMO();
@@ -158,11 +191,12 @@ public:
   void initWithWaypoints(const arrA& waypoints, uint waypointStepsPerPhase=1); ///< set all configurations (EXCEPT prefix) to interpolate given waypoints
   void updateRootObjects(const rai::Configuration& C);
   void updateAndShiftPrefix(const rai::Configuration& C);
+  void shiftSolution(int steps=1); ///< receding horizon warm start: shift the path and the duals of all grounded objectives by steps time slices (the last are repeated); call before updateAndShiftPrefix
 
 
   //-- optimization
   void optimize(double addInitializationNoise=.01, const rai::OptOptions options=NOOPT);  ///< run the solver (same as run_prepare(); run(); )
-  void reset();                                      ///< reset the dual variables and feature value buffers (always needed when adding/changing objectives before continuing an optimization)
+  void reset();                                      ///< reset the dual variables, feature value buffers and solver session (always needed when adding/changing objectives or solver options before continuing an optimization)
 
   //advanced
   void run_prepare(double addInitializationNoise);   ///< ensure the configurations are setup, decision variable is initialized, and noise added (if >0)
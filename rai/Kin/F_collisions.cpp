@@ -46,7 +46,7 @@ void F_PairCollision::phi2(arr& y, arr& J, const FrameL& F) {
   double r1=0., r2=0.;
   rai::Mesh dot;
   dot.setDot();
-  rai::Mesh *m1=&dot, *m2=&dot;
+  const rai::Mesh *m1=&dot, *m2=&dot;
   if(f1->shape && f1->shape->type()!=rai::ST_marker){
     r1=f1->shape->radius();
     m1 = &f1->shape->sscCore();  if(!m1->V.N) { m1 = &f1->shape->mesh(); r1=0.; }
@@ -9,6 +9,62 @@
 #include "F_pose.h"
 #include "TM_default.h"
 
+//===========================================================================
+//
+// helpers to compose second-order kinematics
+//
+
+/// a += sign*b
+static void hessian_add(rai::HessianBlock& a, rai::HessianBlock& b, double sign) {
+  a.align(b);
+  if(sign<0.) { a.y -= b.y;  a.J -= b.J;  a.H -= b.H; }
+  else { a.y += b.y;  a.J += b.J;  a.H += b.H; }
+}
+
+/// y = (a, b) stacked
+static void hessian_stack(rai::HessianBlock& y, rai::HessianBlock& a, rai::HessianBlock& b) {
+  a.align(b);
+  uint da=a.y.N, db=b.y.N, m=a.dofs.N;
+  y.resize(da+db, a.dofs);
+  y.y.setVectorBlock(a.y, 0);
+  y.y.setVectorBlock(b.y, da);
+  y.J.setMatrixBlock(a.J, 0, 0);
+  y.J.setMatrixBlock(b.J, da, 0);
+  if(!m) return;
+  memmove(y.H.p, a.H.p, a.H.N*y.H.sizeT);
+  memmove(y.H.p+da*m*m, b.H.p, b.H.N*y.H.sizeT);
+}
+
+/// y_k = sum_ij C(k,i,j) a_i b_j
+static void hessian_bilinear(rai::HessianBlock& y, const arr& C, rai::HessianBlock& a, rai::HessianBlock& b) {
+  a.align(b);
+  uint d=C.d0, m=a.dofs.N;
+  CHECK_EQ(C.d1, a.y.N, "");
+  CHECK_EQ(C.d2, b.y.N, "");
+  y.resize(d, a.dofs);
+  for(uint k=0; k<d; k++) for(uint i=0; i<C.d1; i++) for(uint j=0; j<C.d2; j++) {
+        double c = C(k, i, j);
+        if(!c) continue;
+        double ai=a.y(i), bj=b.y(j);
+        const double *aJ=&a.J(i, 0), *bJ=&b.J(j, 0);
+        y.y(k) += c*ai*bj;
+        for(uint r=0; r<m; r++) {
+          y.J(k, r) += c*(bj*aJ[r] + ai*bJ[r]);
+          for(uint s=0; s<m; s++) y.H(k, r, s) += c*(bj*a.H(i, r, s) + ai*b.H(j, r, s) + aJ[r]*bJ[s] + bJ[r]*aJ[s]);
+        }
+      }
+}
+
+/// the columns of the rotation matrix of f, stacked (as kinematicsMat)
+static void hessian_mat(rai::HessianBlock& y, rai::Frame* f) {
+  rai::HessianBlock x, yy, z, xy;
+  f->C.hessianVec(x, f, Vector_x);
+  f->C.hessianVec(yy, f, Vector_y);
+  f->C.hessianVec(z, f, Vector_z);
+  hessian_stack(xy, x, yy);
+  hessian_stack(y, xy, z);
+}
+
 //===========================================================================
 
 void F_Position::phi2(arr& y, arr& J, const FrameL& F) {
@@ -18,6 +74,13 @@ void F_Position::phi2(arr& y, arr& J, const FrameL& F) {
   f->C.kinematicsPos(y, J, f);
 }
 
+
+bool F_Position::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 1, "");
+  rai::Frame *f = F.elem(0);
+  f->C.hessianPos(y, f);
+  return true;
+}
 //===========================================================================
 
 arr F_PositionDiff::phi(const FrameL& F) {
@@ -28,6 +91,15 @@ arr F_PositionDiff::phi(const FrameL& F) {
   return p1-p2;
 }
 
+
+bool F_PositionDiff::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 2, "");
+  rai::HessianBlock y2;
+  F.elem(0)->C.hessianPos(y, F.elem(0));
+  F.elem(1)->C.hessianPos(y2, F.elem(1));
+  hessian_add(y, y2, -1.);
+  return true;
+}
 //===========================================================================
 
 void F_PositionRel::phi2(arr& y, arr& J, const FrameL& F) {
@@ -47,6 +119,22 @@ void F_PositionRel::phi2(arr& y, arr& J, const FrameL& F) {
   }
 }
 
+
+bool F_PositionRel::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 2, "");
+  rai::Frame *f1 = F.elem(0);
+  rai::Frame *f2 = F.elem(1);
+  rai::HessianBlock R, d, y2;
+  hessian_mat(R, f2);
+  f1->C.hessianPos(d, f1);
+  f2->C.hessianPos(y2, f2);
+  hessian_add(d, y2, -1.);
+  //y_k = (R e_k)^T d
+  arr C = zeros(3, 9, 3);
+  for(uint k=0; k<3; k++) for(uint l=0; l<3; l++) C(k, 3*k+l, l) = 1.;
+  hessian_bilinear(y, C, R, d);
+  return true;
+}
 //===========================================================================
 
 void F_Vector::phi2(arr& y, arr& J, const FrameL& F){
@@ -56,6 +144,13 @@ void F_Vector::phi2(arr& y, arr& J, const FrameL& F){
   f->C.kinematicsVec(y, J, f, vec);
 }
 
+
+bool F_Vector::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 1, "");
+  rai::Frame *f = F.elem(0);
+  f->C.hessianVec(y, f, vec);
+  return true;
+}
 //===========================================================================
 
 void F_VectorDiff::phi2(arr& y, arr& J, const FrameL& F){
@@ -70,10 +165,46 @@ void F_VectorDiff::phi2(arr& y, arr& J, const FrameL& F){
   J -= J2;
 }
 
+
+bool F_VectorDiff::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 2, "");
+  rai::HessianBlock y2;
+  F.elem(0)->C.hessianVec(y, F.elem(0), vec1);
+  F.elem(1)->C.hessianVec(y2, F.elem(1), vec2);
+  hessian_add(y, y2, -1.);
+  return true;
+}
 //===========================================================================
 
 void F_VectorRel::phi2(arr& y, arr& J, const FrameL& F){
-  NIY;
+  if(order>0){  Feature::phi2(y, J, F);  return;  }
+  CHECK_EQ(F.N, 2, "");
+  rai::Frame *f1 = F.elem(0);
+  rai::Frame *f2 = F.elem(1);
+  arr y1, J1;
+  f1->C.kinematicsVec(y1, J1, f1, vec);
+  arr Rinv = ~(f2->ensure_X().rot.getArr());
+  y = Rinv * y1;
+  if(!!J) {
+    arr A;
+    f2->C.jacobian_angular(A, f2);
+    J = Rinv * (J1 - crossProduct(A, y1));
+  }
+}
+
+
+bool F_VectorRel::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 2, "");
+  rai::Frame *f1 = F.elem(0);
+  rai::Frame *f2 = F.elem(1);
+  rai::HessianBlock R, v;
+  hessian_mat(R, f2);
+  f1->C.hessianVec(v, f1, vec);
+  //y_k = (R e_k)^T v
+  arr C = zeros(3, 9, 3);
+  for(uint k=0; k<3; k++) for(uint l=0; l<3; l++) C(k, 3*k+l, l) = 1.;
+  hessian_bilinear(y, C, R, v);
+  return true;
 }
 
 //===========================================================================
@@ -85,6 +216,12 @@ void F_Matrix::phi2(arr& y, arr& J, const FrameL& F){
   f->C.kinematicsMat(y, J, f);
 }
 
+
+bool F_Matrix::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 1, "");
+  hessian_mat(y, F.elem(0));
+  return true;
+}
 //===========================================================================
 
 void F_MatrixDiff::phi2(arr& y, arr& J, const FrameL& F){
@@ -99,6 +236,15 @@ void F_MatrixDiff::phi2(arr& y, arr& J, const FrameL& F){
   J -= J2;
 }
 
+
+bool F_MatrixDiff::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 2, "");
+  rai::HessianBlock y2;
+  hessian_mat(y, F.elem(0));
+  hessian_mat(y2, F.elem(1));
+  hessian_add(y, y2, -1.);
+  return true;
+}
 //===========================================================================
 
 void F_Quaternion::phi2(arr& y, arr& J, const FrameL& F){
@@ -110,6 +256,13 @@ void F_Quaternion::phi2(arr& y, arr& J, const FrameL& F){
   f->C.kinematicsQuat(y, J, f);
 }
 
+
+bool F_Quaternion::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 1, "");
+  rai::Frame *f = F.elem(0);
+  f->C.hessianQuat(y, f);
+  return true;
+}
 //===========================================================================
 
 void F_QuaternionDiff::phi2(arr& y, arr& J, const FrameL& F){
@@ -129,6 +282,15 @@ void F_QuaternionDiff::phi2(arr& y, arr& J, const FrameL& F){
   }
 }
 
+
+bool F_QuaternionDiff::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 2, "");
+  rai::HessianBlock y2;
+  F.elem(0)->C.hessianQuat(y, F.elem(0));
+  F.elem(1)->C.hessianQuat(y2, F.elem(1));
+  hessian_add(y, y2, scalarProduct(y.y, y2.y)>=0. ? -1. : 1.);
+  return true;
+}
 //===========================================================================
 
 void F_QuaternionRel::phi2(arr& y, arr& J, const FrameL& F){
@@ -152,6 +314,29 @@ void F_QuaternionRel::phi2(arr& y, arr& J, const FrameL& F){
   checkNan(J);
 }
 
+
+bool F_QuaternionRel::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 2, "");
+  rai::Frame *f1 = F.elem(0);
+  rai::Frame *f2 = F.elem(1);
+  rai::HessianBlock qa, qb;
+  f1->C.hessianQuat(qb, f1);
+  f2->C.hessianQuat(qa, f2);
+  if(qa.y(0)!=1.) { //ainv, as in phi2
+    qa.y(0) *= -1.;  qa.J[0]() *= -1.;  qa.H[0]() *= -1.;
+  }
+  //y = ainv * qb: y_k = sum_ij (e_i * e_j)_k ainv_i qb_j
+  arr C(4, 4, 4);
+  for(uint i=0; i<4; i++) for(uint j=0; j<4; j++) {
+      rai::Quaternion ei, ej;
+      ei.set(i==0, i==1, i==2, i==3);
+      ej.set(j==0, j==1, j==2, j==3);
+      arr eij = (ei*ej).getArr4d();
+      for(uint k=0; k<4; k++) C(k, i, j) = eij(k);
+    }
+  hessian_bilinear(y, C, qa, qb);
+  return true;
+}
 //===========================================================================
 
 void F_ScalarProduct::phi2(arr& y, arr& J, const FrameL& F){
@@ -172,6 +357,19 @@ void F_ScalarProduct::phi2(arr& y, arr& J, const FrameL& F){
   J = ~zj * Ji + ~zi * Jj;
 }
 
+
+bool F_ScalarProduct::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  CHECK_EQ(F.N, 2, "");
+  rai::Frame *f1 = F.elem(0);
+  rai::Frame *f2 = F.elem(1);
+  rai::HessianBlock zi, zj;
+  f1->C.hessianVec(zi, f1, vec1);
+  f2->C.hessianVec(zj, f2, vec2);
+  arr C = zeros(1, 3, 3);
+  for(uint i=0; i<3; i++) C(0, i, i) = 1.;
+  hessian_bilinear(y, C, zi, zj);
+  return true;
+}
 //===========================================================================
 
 void F_Pose::phi2(arr& y, arr& J, const FrameL& F) {
@@ -182,6 +380,14 @@ void F_Pose::phi2(arr& y, arr& J, const FrameL& F) {
 //  J.setBlockMatrix(pos.J(), quat.J());
 }
 
+
+bool F_Pose::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  rai::HessianBlock pos, quat;
+  F_Position().evalHessian(pos, F);
+  F_Quaternion().evalHessian(quat, F);
+  hessian_stack(y, pos, quat);
+  return true;
+}
 //===========================================================================
 
 void F_PoseDiff::phi2(arr& y, arr& J, const FrameL& F) {
@@ -192,6 +398,14 @@ void F_PoseDiff::phi2(arr& y, arr& J, const FrameL& F) {
 //  J.setBlockMatrix(pos.J(), quat.J());
 }
 
+
+bool F_PoseDiff::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  rai::HessianBlock pos, quat;
+  F_PositionDiff().evalHessian(pos, F);
+  F_QuaternionDiff().evalHessian(quat, F);
+  hessian_stack(y, pos, quat);
+  return true;
+}
 //===========================================================================
 
 void F_PoseRel::phi2(arr& y, arr& J, const FrameL& F) {
@@ -202,6 +416,14 @@ void F_PoseRel::phi2(arr& y, arr& J, const FrameL& F) {
 //  J.setBlockMatrix(pos.J(), quat.J());
 }
 
+
+bool F_PoseRel::phi2_hessian(rai::HessianBlock& y, const FrameL& F) {
+  rai::HessianBlock pos, quat;
+  F_PositionRel().evalHessian(pos, F);
+  F_QuaternionRel().evalHessian(quat, F);
+  hessian_stack(y, pos, quat);
+  return true;
+}
 //===========================================================================
 
 void angVel_base(rai::Frame* f0, rai::Frame* f1, arr& y, arr& J) {
@@ -14,16 +14,19 @@
 
 struct F_Position : Feature {
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 3; }
 };
 
 struct F_PositionDiff : Feature {
   virtual arr phi(const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 3; }
 };
 
 struct F_PositionRel : Feature {
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 3; }
 };
 
@@ -33,6 +36,7 @@ struct F_Vector : Feature {
   rai::Vector vec;
   F_Vector(const rai::Vector& _vec) : vec(_vec) {}
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 3; }
 };
 
@@ -40,6 +44,7 @@ struct F_VectorDiff : Feature {
   rai::Vector vec1, vec2;
   F_VectorDiff(const rai::Vector& _vec1, const rai::Vector& _vec2)  : vec1(_vec1), vec2(_vec2) {}
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 3; }
 };
 
@@ -47,6 +52,7 @@ struct F_VectorRel: Feature {
   rai::Vector vec;
   F_VectorRel(const rai::Vector& _vec)  : vec(_vec) {}
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 3; }
 };
 
@@ -54,11 +60,13 @@ struct F_VectorRel: Feature {
 
 struct F_Matrix: Feature {
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 9; }
 };
 
 struct F_MatrixDiff : Feature {
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 9; }
 };
 
@@ -68,6 +76,7 @@ struct F_ScalarProduct : Feature {
   rai::Vector vec1, vec2;
   F_ScalarProduct(const rai::Vector& _vec1, const rai::Vector& _vec2)  : vec1(_vec1), vec2(_vec2) {}
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 1; }
 };
 
@@ -76,17 +85,20 @@ struct F_ScalarProduct : Feature {
 struct F_Quaternion : Feature {
   F_Quaternion(){ flipTargetSignOnNegScalarProduct = true; }
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 4; }
 };
 
 struct F_QuaternionDiff : Feature {
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 4; }
 };
 
 struct F_QuaternionRel: Feature {
   F_QuaternionRel(){ flipTargetSignOnNegScalarProduct = true; }
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 4; }
 };
 
@@ -94,16 +106,19 @@ struct F_QuaternionRel: Feature {
 
 struct F_Pose : Feature {
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 7; }
 };
 
 struct F_PoseDiff : Feature {
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 7; }
 };
 
 struct F_PoseRel : Feature {
   virtual void phi2(arr& y, arr& J, const FrameL& F);
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) { return 7; }
 };
 
@@ -8,9 +8,9 @@ ParticleDofs::ParticleDofs(Frame& a, ParticleDofs* copy){
     frame=&a;
     CHECK(frame->shape, "only shapes have ParticleDofs");
     CHECK_EQ(frame->shape->type(), ST_mesh, "only mesh shapes have ParticleDofs");
-    mesh = &frame->shape->mesh();
-    CHECK(mesh->V.d0>0, "mesh has no particles");
-    dim = mesh->V.N;
+    const Mesh& mesh = frame->shape->mesh();
+    CHECK(mesh.V.d0>0, "mesh has no particles");
+    dim = mesh.V.N;
     frame->C.reset_q();
     frame->particleDofs=this;
     if(copy) {
@@ -26,12 +26,13 @@ ParticleDofs::~ParticleDofs(){
 
 void ParticleDofs::setDofs(const arr& q, uint n){
     CHECK_LE(n+dim, q.N, "out of range");
-    CHECK_EQ(dim, mesh->V.N, "");
-    memmove(mesh->V.p, q.p+n, q.sizeT*dim);
+    Mesh& mesh = frame->shape->set_mesh(); //the mesh may be shared with copies of the configuration
+    CHECK_EQ(dim, mesh.V.N, "");
+    memmove(mesh.V.p, q.p+n, q.sizeT*dim);
 }
 
 arr ParticleDofs::calcDofsFromConfig() const{
-    arr Vflat = mesh->V;
+    arr Vflat = frame->shape->mesh().V;
     Vflat.reshape(-1);
     return Vflat;
 }
@@ -7,8 +7,6 @@
 namespace rai{
 
 struct ParticleDofs : Dof, NonCopyable, GLDrawer {
-  Mesh *mesh;
-
   ParticleDofs(Frame& a, ParticleDofs* copy=nullptr);
   ~ParticleDofs();
 
@@ -184,6 +184,35 @@ fct Feature::vf2(const FrameL& F) { ///< direct conversion to vector function: u
 //  };
 //}
 
+bool Feature::evalHessian(rai::HessianBlock& y, const FrameL& F) {
+  if(order>0 || !phi2_hessian(y, F)) return false;
+  //-- the linear transformation, as in applyLinearTrans, on y, J and H
+  if(target.N) {
+    if(flipTargetSignOnNegScalarProduct) {
+      if(scalarProduct(y.y, target)<-.0) { y.y *= -1.;  y.J *= -1.;  y.H *= -1.; }
+    }
+    if(target.N==1) y.y -= target.scalar();
+    else y.y -= target;
+  }
+  if(scale.N) {
+    uint m=y.dofs.N;
+    if(scale.N==1) { //scalar
+      y.y *= scale.scalar();  y.J *= scale.scalar();  y.H *= scale.scalar();
+    } else if(scale.nd==1) { //element-wise
+      CHECK_EQ(scale.d0, y.y.N, "");
+      for(uint k=0; k<y.y.N; k++) { y.y(k) *= scale(k);  y.J[k]() *= scale(k);  y.H[k]() *= scale(k); }
+    } else if(scale.nd==2) { //matrix
+      CHECK_EQ(scale.d1, y.y.N, "");
+      y.y = scale * y.y;
+      y.J = scale * y.J;
+      y.H.reshape(scale.d1, m*m);
+      y.H = scale * y.H;
+      y.H.reshape(scale.d0, m, m);
+    }
+  }
+  return true;
+}
+
 void Feature::applyLinearTrans(arr& y) {
   if(target.N) {
     if(flipTargetSignOnNegScalarProduct) {
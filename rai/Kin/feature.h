@@ -43,12 +43,15 @@ protected:
   virtual arr phi(const FrameL& F);
   virtual void phi2(arr& y, arr& J, const FrameL& F);
   virtual uint dim_phi2(const FrameL& F) {  NIY; }
+  //-- optional second-order kinematics (for order=0 only): phi with Jacobian and Hessian w.r.t. the dofs it depends on; false if not implemented
+  virtual bool phi2_hessian(rai::HessianBlock& y, const FrameL& F) { return false; }
 
  public:
   arr eval(const FrameL& F) { arr y = phi(F); applyLinearTrans(y); return y; }
 //  Value eval(const FrameL& F) { arr y, J; eval(y, J, F); return Value(y, J); }
   arr eval(const rai::Configuration& C) { return eval(getFrames(C)); }
   uint dim(const FrameL& F) { uint d=dim_phi2(F); return applyLinearTrans_dim(d); }
+  bool evalHessian(rai::HessianBlock& y, const FrameL& F); ///< as eval, but with the Hessian block (see rai::HessianBlock); false if the feature has none
   fct vf2(const FrameL& F);
 
   virtual rai::String shortTag(const rai::Configuration& C);
@@ -98,8 +98,28 @@ std::shared_ptr<Feature> Feature::deepCopy(){
 #define _cpy(T) { T* f = dynamic_cast<T*>(this); if(f) return make_shared<T>(*f); }
   _cpy(F_PositionDiff);
   _cpy(F_qItself);
+  _cpy(F_qQuaternionNorms);
+  _cpy(F_qLimits);
+  _cpy(F_Position);
+  _cpy(F_PositionRel);
+  _cpy(F_Vector);
+  _cpy(F_VectorDiff);
+  _cpy(F_VectorRel);
+  _cpy(F_Quaternion);
+  _cpy(F_QuaternionDiff);
+  _cpy(F_QuaternionRel);
+  _cpy(F_Pose);
+  _cpy(F_PoseDiff);
+  _cpy(F_PoseRel);
+  _cpy(F_ScalarProduct);
+  _cpy(F_PairCollision);
+  _cpy(F_AccumulatedCollisions);
+  _cpy(F_AboveBox);
+  _cpy(F_InsideBox);
+  _cpy(F_GraspOppose);
+  _cpy(F_AngVel);
 #undef _cpy
-  HALT("deepCopy not registered for this type: " <<rai::niceTypeidName(typeid(this)));
+  HALT("deepCopy not registered for this type: " <<rai::niceTypeidName(typeid(*this)));
   return make_shared<Feature>();
 }
 
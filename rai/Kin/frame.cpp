@@ -31,13 +31,13 @@ template<> const char* rai::Enum<rai::BodyType>::names []= {
 rai::Transformation_Xtoken::~Transformation_Xtoken() { f._state_updateAfterTouchingX(); }
 rai::Transformation_Qtoken::~Transformation_Qtoken() { f._state_updateAfterTouchingQ(); }
 
-rai::Transformation* rai::Transformation_Xtoken::operator->() { f.ensure_X(); return &f.X; }
-rai::Transformation* rai::Transformation_Qtoken::operator->() { return &f.Q; }
-rai::Transformation& rai::Transformation_Xtoken::operator*() { f.ensure_X(); return f.X; }
-rai::Transformation& rai::Transformation_Qtoken::operator*() { return f.Q; }
+rai::Transformation* rai::Transformation_Xtoken::operator->() { f.X() = f.calc_X_alongChain(); return &f.X(); }
+rai::Transformation* rai::Transformation_Qtoken::operator->() { return &f.Q(); }
+rai::Transformation& rai::Transformation_Xtoken::operator*() { f.X() = f.calc_X_alongChain(); return f.X(); }
+rai::Transformation& rai::Transformation_Qtoken::operator*() { return f.Q(); }
 
-void rai::Transformation_Xtoken::operator=(const rai::Transformation& _X) { f.X=_X; }
-void rai::Transformation_Qtoken::operator=(const rai::Transformation& _Q) { f.Q=_Q; }
+void rai::Transformation_Xtoken::operator=(const rai::Transformation& _X) { f.X()=_X; }
+void rai::Transformation_Qtoken::operator=(const rai::Transformation& _Q) { f.Q()=_Q; }
 
 //===========================================================================
 //
@@ -51,9 +51,16 @@ rai::Frame::Frame(Configuration& _C, const Frame* copyFrame)
 
   ID=C.frames.N;
   C.frames.append(this);
+  C._state_fkOrder_isGood=false;
+  C._geometry_revision++;
+  C.frameQ.append(Transformation(0));
+  C.frameX.append(Transformation(0));
   if(copyFrame) {
     const Frame& f = *copyFrame;
-    name=f.name; Q=f.Q; X=f.X; _state_X_isGood=f._state_X_isGood; tau=f.tau; ats=f.ats;
+    name=f.name; Q()=f.Q(); X()=f.X(); tau=f.tau; ats=f.ats;
+    //a pending fwd pass in the original may leave f's X stale: then let the copy recompute it from its parent
+    _state_X_isGood = f._state_X_isGood && !f.C._state_X_pending;
+    if(!_state_X_isGood) C._state_X_pending=true;
     //we cannot copy link! because we can't know if the frames already exist. Configuration::copy copies the rel's !!
     if(copyFrame->joint) new Joint(*this, copyFrame->joint);
     if(copyFrame->shape) new Shape(*this, copyFrame->shape);
@@ -76,14 +83,21 @@ rai::Frame::~Frame() {
   if(inertia) delete inertia;
   if(parent) unLink();
   while(children.N) children.last()->unLink();
+  C._state_fkOrder_isGood=false;
+  C._geometry_revision++;
   if(this==C.frames.last()) { //great: this is very efficient to remove without breaking indexing
     CHECK_EQ(ID, C.frames.N-1, "");
     C.frames.resizeCopy(C.frames.N-1);
+    C.frameQ.resizeCopy(C.frameQ.N-1);
+    C.frameX.resizeCopy(C.frameX.N-1);
   }else{
     CHECK_EQ(this, C.frames.elem(ID), "");
     C.frames.remove(ID);
+    C.frameQ.remove(ID);
+    C.frameX.remove(ID);
     listReindex(C.frames);
   }
+  C.reset_frameNames();
   C.reset_q();
 }
 
@@ -92,10 +106,10 @@ void rai::Frame::calc_X_from_parent() {
   CHECK(parent->_state_X_isGood, "");
 
   tau = parent->tau;
-  Transformation& from = parent->X;
-  X = from;
-  X.appendTransformation(Q);
-  CHECK_EQ(X.pos.x, X.pos.x, "NAN transformation:" <<from <<'*' <<Q);
+  Transformation& from = parent->X();
+  X() = from;
+  X().appendTransformation(Q());
+  CHECK_EQ(X().pos.x, X().pos.x, "NAN transformation:" <<from <<'*' <<Q());
   if(joint) {
     Joint* j = joint;
     if(j->type==JT_hingeX || j->type==JT_transX || j->type==JT_XBall)  j->axis = from.rot.getX();
@@ -106,14 +120,13 @@ void rai::Frame::calc_X_from_parent() {
   }
 
   _state_X_isGood=true;
-  C._state_proxies_isGood = false;
 }
 
 void rai::Frame::calc_Q_from_parent(bool enforceWithinJoint) {
   CHECK(parent, "");
-  CHECK(_state_X_isGood, "");
 
-  Q.setDifference(parent->ensure_X(), X);
+  //X is given
+  Q().setDifference(parent->calc_X_alongChain(), X());
   if(joint && enforceWithinJoint) {
     arr q = joint->calcDofsFromConfig();
     joint->setDofs(q, 0);
@@ -132,26 +145,45 @@ const rai::Transformation& rai::Frame::ensure_X() {
   }
 #endif
 
-  if(!_state_X_isGood) { if(parent) { parent->ensure_X(); calc_X_from_parent(); } }
+  if(C._state_X_pending) C.ensure_X_locked();
   CHECK(_state_X_isGood, "");
-  return X;
+  return X();
 }
 
 const rai::Transformation& rai::Frame::get_Q() const {
-  return Q;
+  return Q();
 }
 
 const rai::Transformation& rai::Frame::get_X() const {
+  if(C._state_X_pending) C.ensure_X_locked();
   CHECK(_state_X_isGood, "");
-  return X;
+  return X();
+}
+
+/// while a fwd pass is pending, frames flagged good may be stale below a dirty ancestor: walk up to the root and recompose
+/// from the topmost dirty frame down (a root's X is always given); nothing is written, so the pending pass stays valid
+rai::Transformation rai::Frame::calc_X_alongChain() const {
+  if(!C._state_X_pending) return X();
+  FrameL chain;
+  for(Frame* f=(Frame*)this; f; f=f->parent) chain.append(f);
+  Transformation X0 = chain.last()->X();
+  bool recompose = !chain.last()->_state_X_isGood;
+  for(uint i=chain.N-1; i--;) {
+    Frame* f = chain.elem(i);
+    if(!f->_state_X_isGood) recompose=true;
+    if(recompose) X0.appendTransformation(f->Q());
+    else X0 = f->X();
+  }
+  return X0;
 }
 
 void rai::Frame::_state_updateAfterTouchingX() {
-  _state_setXBadinBranch();
-  _state_X_isGood = true;
   if(parent) {
-    Q.setDifference(parent->ensure_X(), X);
-    _state_updateAfterTouchingQ();
+    //the new X is given: only the parent's chain is composed (no fwd pass), so per-frame writes stay O(depth)
+    Q().setDifference(parent->calc_X_alongChain(), X());
+    _state_updateAfterTouchingQ(); //the next fwd pass recomputes X (unchanged) and the branch below
+  } else {
+    _state_setXBadinBranch(); //a dirty root keeps its X; the next fwd pass updates the branch below
   }
 }
 
@@ -201,7 +233,7 @@ rai::Frame* rai::Frame::getUpwardLink(rai::Transformation& Qtotal, bool untilPar
     } else {
       if(f->joint && f->joint->isPartBreak()) break;
     }
-    if(!!Qtotal) Qtotal = f->Q*Qtotal;
+    if(!!Qtotal) Qtotal = f->Q()*Qtotal;
     f = f->parent;
   }
   return (Frame*)f;
@@ -258,8 +290,7 @@ const char* rai::Frame::isPart() {
 void rai::Frame::prefixSubtree(const char* prefix) {
   FrameL F = {this};
   getSubtree(F);
-  for(auto* f:F) f->name.prepend(prefix);
-
+  for(auto* f:F) { String s(prefix);  s <<f->name;  f->setName(s); } //via setName, so that the frame name index is updated
 }
 
 void rai::Frame::computeCompoundInertia(){
@@ -274,10 +305,11 @@ void rai::Frame::computeCompoundInertia(){
 }
 
 void rai::Frame::_state_setXBadinBranch() {
-  if(_state_X_isGood) { //no need to propagate to children if already bad
+  if(_state_X_isGood) {
     _state_X_isGood=false;
-    for(Frame* child:children) child->_state_setXBadinBranch();
+    C._state_revision++;
   }
+  C._state_X_pending=true; //the children are not touched: Configuration::ensure_X propagates down the topological order
 }
 
 void rai::Frame::read(const Graph& ats) {
@@ -334,10 +366,10 @@ void rai::Frame::read(const Graph& ats) {
       sh = new Shape(*f);
     }
     sh->type() = rai::ST_ssCvx;
-    sh->sscCore().V = core;
+    sh->set_sscCore().V = core;
     sh->size = ARR(r);
-    sh->mesh().C = ARR(1., 1., 0., .5);
-    sh->mesh().setSSCvx(core, r);
+    sh->set_mesh().C = ARR(1., 1., 0., .5);
+    sh->set_mesh().setSSCvx(core, r);
   }
 }
 
@@ -345,9 +377,9 @@ void rai::Frame::write(Graph& G) {
   if(parent) G.newNode<rai::String>({"parent"}, {}, parent->name);
 
   if(parent) {
-    if(!Q.isZero()) G.newNode<arr>({"Q"}, {}, Q.getArr7d());
+    if(!Q().isZero()) G.newNode<arr>({"Q"}, {}, Q().getArr7d());
   } else {
-    if(!X.isZero()) G.newNode<arr>({"X"}, {}, X.getArr7d());
+    if(!X().isZero()) G.newNode<arr>({"X"}, {}, X().getArr7d());
   }
 
   if(joint) joint->write(G);
@@ -370,9 +402,9 @@ void rai::Frame::write(std::ostream& os) const {
   os <<" \t{ ";
 
   if(parent) {
-    if(!Q.isZero()) os <<" Q:" <<Q;
+    if(!Q().isZero()) os <<" Q:" <<Q();
   } else {
-    if(!X.isZero()) os <<" X:" <<X;
+    if(!X().isZero()) os <<" X:" <<X();
   }
 //  if(parent) os <<"parent:" <<parent->name;
 
@@ -395,53 +427,67 @@ void rai::Frame::write(std::ostream& os) const {
 
 /************* USER INTERFACE **************/
 
+rai::Frame& rai::Frame::setName(const char* _name) {
+  String oldName = name;
+  name = _name;
+  C.update_frameName(this, oldName);
+  return *this;
+}
+
 rai::Frame& rai::Frame::setShape(rai::ShapeType shape, const arr& size) {
-  getShape().type() = shape;
-  getShape().size() = size;
-  getShape().createMeshes();
+  Shape& s = getShape();
+  s.type() = shape;
+  s.size() = size;
+  if(shape!=ST_mesh && shape!=ST_pointCloud && shape!=ST_quad && shape!=ST_ssCvx) {
+    //createMeshes builds these from scratch: start from fresh meshes (keeping the color) instead of copying shared ones
+    arr color = s.mesh().C;
+    s._mesh = make_shared<Mesh>();
+    s._mesh->C = color;
+    s._sscCore.reset();
+  }
+  s.createMeshes();
   return *this;
 }
 
 rai::Frame& rai::Frame::setPose(const rai::Transformation& _X) {
-  ensure_X();
-  X = _X;
+  X() = _X;
   _state_updateAfterTouchingX();
   return *this;
 }
 
 rai::Frame& rai::Frame::setPosition(const arr& pos) {
-  ensure_X();
-  X.pos.set(pos);
+  X() = calc_X_alongChain();
+  X().pos.set(pos);
   _state_updateAfterTouchingX();
   return *this;
 }
 
 rai::Frame& rai::Frame::setQuaternion(const arr& quat) {
-  ensure_X();
-  X.rot.set(quat);
-  X.rot.normalize();
+  X() = calc_X_alongChain();
+  X().rot.set(quat);
+  X().rot.normalize();
   _state_updateAfterTouchingX();
   return *this;
 }
 
 rai::Frame& rai::Frame::setRelativePose(const rai::Transformation& _Q) {
   CHECK(parent, "you cannot set relative pose for a frame without parent");
-  Q = _Q;
+  Q() = _Q;
   _state_updateAfterTouchingQ();
   return *this;
 }
 
 rai::Frame& rai::Frame::setRelativePosition(const arr& pos) {
   CHECK(parent, "you cannot set relative position for a frame without parent");
-  Q.pos.set(pos);
+  Q().pos.set(pos);
   _state_updateAfterTouchingQ();
   return *this;
 }
 
 rai::Frame& rai::Frame::setRelativeQuaternion(const arr& quat) {
   CHECK(parent, "you cannot set relative pose for a frame without parent");
-  Q.rot.set(quat);
-  Q.rot.normalize();
+  Q().rot.set(quat);
+  Q().rot.normalize();
   _state_updateAfterTouchingQ();
   return *this;
 }
@@ -452,9 +498,9 @@ rai::Frame& rai::Frame::setPointCloud(const arr& points, const byteA& colors) {
     cerr <<"given point cloud has zero size" <<endl;
     return *this;
   }
-  getShape().mesh().V.clear().operator=(points).reshape(-1, 3);
+  getShape().set_mesh().V.clear().operator=(points).reshape(-1, 3);
   if(colors.N) {
-    getShape().mesh().C.clear().operator=(convert<double>(byteA(colors))/255.).reshape(-1, 3);
+    getShape().set_mesh().C.clear().operator=(convert<double>(byteA(colors))/255.).reshape(-1, 3);
   }
   return *this;
 }
@@ -462,24 +508,24 @@ rai::Frame& rai::Frame::setPointCloud(const arr& points, const byteA& colors) {
 rai::Frame& rai::Frame::setConvexMesh(const arr& points, const byteA& colors, double radius) {
   if(!radius) {
     getShape().type() = ST_mesh;
-    getShape().mesh().V.clear().operator=(points).reshape(-1, 3);
-    getShape().mesh().makeConvexHull();
+    getShape().set_mesh().V.clear().operator=(points).reshape(-1, 3);
+    getShape().set_mesh().makeConvexHull();
     getShape().size.clear();
   } else {
     getShape().type() = ST_ssCvx;
-    getShape().sscCore().V.clear().operator=(points).reshape(-1, 3);
-    getShape().sscCore().makeConvexHull();
-    getShape().mesh().setSSCvx(getShape().sscCore().V, radius);
+    getShape().set_sscCore().V.clear().operator=(points).reshape(-1, 3);
+    getShape().set_sscCore().makeConvexHull();
+    getShape().set_mesh().setSSCvx(getShape().sscCore().V, radius);
     getShape().size = ARR(radius);
   }
   if(colors.N) {
-    getShape().mesh().C.clear().operator=(convert<double>(byteA(colors))/255.).reshape(-1, 3);
+    getShape().set_mesh().C.clear().operator=(convert<double>(byteA(colors))/255.).reshape(-1, 3);
   }
   return *this;
 }
 
 rai::Frame& rai::Frame::setColor(const arr& color) {
-  getShape().mesh().C = color;
+  getShape().set_mesh().C = color;
   return *this;
 }
 
@@ -495,6 +541,7 @@ rai::Frame& rai::Frame::setJoint(rai::JointType jointType) {
 
 rai::Frame& rai::Frame::setContact(int cont) {
   getShape().cont = cont;
+  C._geometry_revision++;
   return *this;
 }
 
@@ -507,9 +554,14 @@ rai::Frame& rai::Frame::setMass(double mass) {
   return *this;
 }
 
-rai::Frame& rai::Frame::addAttribute(const char* key, double value) {
+rai::Graph& rai::Frame::set_ats() {
   if(!ats) ats = make_shared<Graph>();
-  ats->newNode<double>(key, {}, value);
+  else if(ats.use_count()>1) ats = make_shared<Graph>(*ats); //copy-on-write: the graph is shared with copies of the configuration
+  return *ats;
+}
+
+rai::Frame& rai::Frame::addAttribute(const char* key, double value) {
+  set_ats().newNode<double>(key, {}, value);
   return *this;
 }
 
@@ -550,6 +602,8 @@ arr rai::Frame::getJointState() const {
 
 rai::Frame* rai::Frame::insertPreLink(const rai::Transformation& A) {
   //new frame between: parent -> f -> this
+  Transformation Q0 = 0;
+  if(!!A) Q0 = A; //copy: A may refer into C.frameQ/frameX, which the new frame reallocates
   Frame* f;
 
   if(parent) {
@@ -562,8 +616,9 @@ rai::Frame* rai::Frame::insertPreLink(const rai::Transformation& A) {
   }
   parent=f;
   parent->children.append(this);
+  C._state_fkOrder_isGood=false;
 
-  if(!!A) f->Q=A; else f->Q.setZero();
+  f->Q() = Q0;
   f->_state_updateAfterTouchingQ();
 
   return f;
@@ -571,6 +626,8 @@ rai::Frame* rai::Frame::insertPreLink(const rai::Transformation& A) {
 
 rai::Frame* rai::Frame::insertPostLink(const rai::Transformation& B) {
   //new frame between: parent -> this -> f
+  Transformation Q0 = 0;
+  if(!!B) Q0 = B; //copy: B may refer into C.frameQ/frameX, which the new frame reallocates
   Frame* f = new Frame(C);
   if(name) f->name <<'<' <<name;
 
@@ -578,8 +635,9 @@ rai::Frame* rai::Frame::insertPostLink(const rai::Transformation& B) {
   f->children = children;
   for(Frame* b:children) b->parent = f;
   children.clear();
+  C._state_fkOrder_isGood=false;
 
-  if(!!B) f->Q=B; else f->Q.setZero();
+  f->Q() = Q0;
   f->_state_updateAfterTouchingQ();
 
   f->setParent(this, false);
@@ -592,7 +650,8 @@ void rai::Frame::unLink() {
   ensure_X();
   parent->children.removeValue(this);
   parent=nullptr;
-  Q.setZero();
+  C._state_fkOrder_isGood=false;
+  Q().setZero();
   if(joint) {  delete joint;  joint=nullptr;  }
 }
 
@@ -609,10 +668,9 @@ rai::Frame& rai::Frame::setParent(rai::Frame* _parent, bool keepAbsolutePose_and
     }
   }
 
-  if(keepAbsolutePose_and_adaptRelativePose) ensure_X();
-
   parent=_parent;
   parent->children.append(this);
+  C._state_fkOrder_isGood=false;
 
   if(keepAbsolutePose_and_adaptRelativePose) calc_Q_from_parent();
   _state_updateAfterTouchingQ();
@@ -708,11 +766,112 @@ void rai::Joint::setMimic(rai::Joint* j, bool unsetPreviousMimic){
   }
 }
 
+void rai::Joint::calcTransformation(Transformation& Q, const double* qp) const {
+  Q.setZero();
+  switch(type) {
+    case JT_hingeX: {
+      Q.rot.setRadX(qp[0]);
+    } break;
+
+    case JT_hingeY: {
+      Q.rot.setRadY(qp[0]);
+    } break;
+
+    case JT_hingeZ: {
+      Q.rot.setRadZ(qp[0]);
+    } break;
+
+    case JT_universal: {
+      rai::Quaternion rot1, rot2;
+      rot1.setRadX(qp[0]);
+      rot2.setRadY(qp[1]);
+      Q.rot = rot1*rot2;
+    } break;
+
+    case JT_quatBall: {
+      Q.rot.set(qp);
+      {
+        double n=Q.rot.normalization();
+        if(!rai_Kin_frame_ignoreQuatNormalizationWarning) if(n<.1 || n>10.) LOG(-1) <<"quat normalization is extreme: " <<n;
+      }
+      Q.rot.normalize();
+      Q.rot.isZero=false; //WHY? (gradient check fails without!)
+    } break;
+
+    case JT_free: {
+      Q.pos.set(qp);
+      Q.rot.set(qp+3);
+      {
+        double n=Q.rot.normalization();
+        if(!rai_Kin_frame_ignoreQuatNormalizationWarning) if(n<.1 || n>10.) LOG(-1) <<"quat normalization is extreme: " <<n;
+      }
+      Q.rot.normalize();
+      Q.rot.isZero=false;
+    } break;
+
+    case JT_XBall: {
+      Q.pos.x = qp[0];
+      Q.pos.y = 0.;
+      Q.pos.z = 0.;
+      Q.pos.isZero = false;
+      Q.rot.set(qp+1);
+      {
+        double n=Q.rot.normalization();
+        if(n<.1 || n>10.) LOG(-1) <<"quat normalization is extreme: " <<n;
+      }
+      Q.rot.normalize();
+      Q.rot.isZero=false;
+    } break;
+
+    case JT_transX: {
+      Q.pos = qp[0] * Vector_x;
+    } break;
+
+    case JT_transY: {
+      Q.pos = qp[0] * Vector_y;
+    } break;
+
+    case JT_transZ: {
+      Q.pos = qp[0] * Vector_z;
+    } break;
+
+    case JT_transXY: {
+      Q.pos.set(qp[0], qp[1], 0.);
+    } break;
+
+    case JT_trans3: {
+      Q.pos.set(qp);
+    } break;
+
+    case JT_transXYPhi: {
+      Q.pos.set(qp[0], qp[1], 0.);
+      Q.rot.setRadZ(qp[2]);
+    } break;
+
+    case JT_transYPhi: {
+      Q.pos.set(0., qp[0], 0.);
+      Q.rot.setRadZ(qp[1]);
+    } break;
+
+    case JT_phiTransXY: {
+      Q.rot.setRadZ(qp[0]);
+      Q.pos = Q.rot*Vector(qp[1], qp[2], 0.);
+    } break;
+
+    case JT_rigid:
+      break;
+
+    case JT_tau:
+      break;
+    default: NIY;
+  }
+}
+
 void rai::Joint::setDofs(const arr& q_full, uint _qIndex) {
   if(type==JT_rigid) return;
   CHECK(dim!=UINT_MAX, "");
   CHECK_LE(_qIndex+dim, q_full.N, "");
-  rai::Transformation& Q = frame->Q;
+  rai::Transformation& Q = frame->Q();
   Q.setZero();
   std::shared_ptr<arr> q_copy;
   double* qp;
@@ -731,104 +890,11 @@ void rai::Joint::setDofs(const arr& q_full, uint _qIndex) {
       frame->tau = mimic->frame->tau;
     }
   } else {
-    switch(type) {
-      case JT_hingeX: {
-        Q.rot.setRadX(qp[0]);
-      } break;
-
-      case JT_hingeY: {
-        Q.rot.setRadY(qp[0]);
-      } break;
-
-      case JT_hingeZ: {
-        Q.rot.setRadZ(qp[0]);
-      } break;
-
-      case JT_universal: {
-        rai::Quaternion rot1, rot2;
-        rot1.setRadX(qp[0]);
-        rot2.setRadY(qp[1]);
-        Q.rot = rot1*rot2;
-      } break;
-
-      case JT_quatBall: {
-        Q.rot.set(qp);
-        {
-          double n=Q.rot.normalization();
-          if(!rai_Kin_frame_ignoreQuatNormalizationWarning) if(n<.1 || n>10.) LOG(-1) <<"quat normalization is extreme: " <<n;
-        }
-        Q.rot.normalize();
-        Q.rot.isZero=false; //WHY? (gradient check fails without!)
-      } break;
-
-      case JT_free: {
-        Q.pos.set(qp);
-        Q.rot.set(qp+3);
-        {
-          double n=Q.rot.normalization();
-          if(!rai_Kin_frame_ignoreQuatNormalizationWarning) if(n<.1 || n>10.) LOG(-1) <<"quat normalization is extreme: " <<n;
-        }
-        Q.rot.normalize();
-        Q.rot.isZero=false;
-      } break;
-
-      case JT_XBall: {
-        Q.pos.x = qp[0];
-        Q.pos.y = 0.;
-        Q.pos.z = 0.;
-        Q.pos.isZero = false;
-        Q.rot.set(qp+1);
-        {
-          double n=Q.rot.normalization();
-          if(n<.1 || n>10.) LOG(-1) <<"quat normalization is extreme: " <<n;
-        }
-        Q.rot.normalize();
-        Q.rot.isZero=false;
-      } break;
-
-      case JT_transX: {
-        Q.pos = qp[0] * Vector_x;
-      } break;
-
-      case JT_transY: {
-        Q.pos = qp[0] * Vector_y;
-      } break;
-
-      case JT_transZ: {
-        Q.pos = qp[0] * Vector_z;
-      } break;
-
-      case JT_transXY: {
-        Q.pos.set(qp[0], qp[1], 0.);
-      } break;
-
-      case JT_trans3: {
-        Q.pos.set(qp);
-      } break;
-
-      case JT_transXYPhi: {
-        Q.pos.set(qp[0], qp[1], 0.);
-        Q.rot.setRadZ(qp[2]);
-      } break;
-
-      case JT_transYPhi: {
-        Q.pos.set(0., qp[0], 0.);
-        Q.rot.setRadZ(qp[1]);
-      } break;
-
-      case JT_phiTransXY: {
-        Q.rot.setRadZ(qp[0]);
-        Q.pos = Q.rot*Vector(qp[1], qp[2], 0.);
-      } break;
-
-      case JT_rigid:
-        break;
-
-      case JT_tau:
-        frame->tau = 1e-1 * qp[0];
-        if(frame->tau<1e-10) frame->tau=1e-10;
-        break;
-      default: NIY;
+    if(type==JT_tau) {
+      frame->tau = 1e-1 * qp[0];
+      if(frame->tau<1e-10) frame->tau=1e-10;
+    } else {
+      calcTransformation(Q, qp);
     }
   }
   CHECK_EQ(Q.pos.x, Q.pos.x, "NAN transform");
@@ -841,7 +907,7 @@ void rai::Joint::setDofs(const arr& q_full, uint _qIndex) {
 
   for(Joint* j:mimicers){
     if(type!=JT_tau){
-      j->frame->Q = Q;
+      j->frame->Q() = Q;
       j->frame->_state_setXBadinBranch();
     }else{
       j->frame->tau = frame->tau;
@@ -851,7 +917,7 @@ void rai::Joint::setDofs(const arr& q_full, uint _qIndex) {
 
 arr rai::Joint::calcDofsFromConfig() const {
   arr q;
-  const rai::Transformation& Q=frame->Q;
+  const rai::Transformation& Q=frame->Q();
   switch(type) {
     case JT_hingeX:
     case JT_hingeY:
@@ -1227,6 +1293,7 @@ rai::Shape::Shape(Frame& f, const Shape* copyShape)
 
   CHECK(!frame.shape, "this frame ('" <<frame.name <<"') already has a shape attached");
   frame.shape = this;
+  frame.C._geometry_revision++;
   if(copyShape) {
     const Shape& s = *copyShape;
     if(s._mesh) _mesh = s._mesh; //shallow shared_ptr copy!
@@ -1235,12 +1302,37 @@ rai::Shape::Shape(Frame& f, const Shape* copyShape)
     size = s.size;
     cont = s.cont;
   } else {
-    mesh().C= {.8, .8, .8};
+    set_mesh().C= {.8, .8, .8};
   }
 }
 
 rai::Shape::~Shape() {
   frame.shape = nullptr;
+  frame.C._geometry_revision++;
+}
+
+const rai::Mesh& rai::Shape::mesh() const {
+  static const Mesh empty;
+  return _mesh ? *_mesh : empty;
+}
+
+const rai::Mesh& rai::Shape::sscCore() const {
+  static const Mesh empty;
+  return _sscCore ? *_sscCore : empty;
+}
+
+rai::Mesh& rai::Shape::set_mesh() {
+  frame.C._geometry_revision++;
+  if(!_mesh) _mesh = make_shared<Mesh>();
+  else if(_mesh.use_count()>1) _mesh = make_shared<Mesh>(*_mesh);
+  return *_mesh;
+}
+
+rai::Mesh& rai::Shape::set_sscCore() {
+  frame.C._geometry_revision++;
+  if(!_sscCore) _sscCore = make_shared<Mesh>();
+  else if(_sscCore.use_count()>1) _sscCore = make_shared<Mesh>(*_sscCore);
+  return *_sscCore;
 }
 
 bool rai::Shape::canCollideWith(const rai::Frame* f) const {
@@ -1255,6 +1347,7 @@ bool rai::Shape::canCollideWith(const rai::Frame* f) const {
 }
 
 void rai::Shape::read(const Graph& ats) {
+  frame.C._geometry_revision++;
 
   {
     double d;
@@ -1267,32 +1360,32 @@ void rai::Shape::read(const Graph& ats) {
     else if(ats.get(str, "shape")) { str>> type(); }
     else if(ats.get(d, "type"))    { type()=(ShapeType)(int)d;}
     else if(ats.get(str, "type"))  { str>> type(); }
-    if(ats.get(str, "mesh"))     { mesh().read(FILE(str), str.getLastN(3).p, str); }
+    if(ats.get(str, "mesh"))     { set_mesh().read(FILE(str), str.getLastN(3).p, str); }
     else if(ats.get(fil, "mesh"))     {
       fil.cd_file();
-      mesh().read(fil.getIs(), fil.name.getLastN(3).p, fil.name);
+      set_mesh().read(fil.getIs(), fil.name.getLastN(3).p, fil.name);
 //      cout <<"MESH: " <<mesh().V.dim() <<endl;
     }
     if(ats.get(fil, "texture"))     {
       fil.cd_file();
-      read_ppm(mesh().texImg, fil.name, true);
+      read_ppm(set_mesh().texImg, fil.name, true);
 //      cout <<"TEXTURE: " <<mesh().texImg.dim() <<endl;
     }
-    if(ats.get(d, "meshscale"))  { mesh().scale(d); }
-    if(ats.get(x, "meshscale"))  { mesh().scale(x(0), x(1), x(2)); }
-    if(ats.get(mesh().C, "color")) {
+    if(ats.get(d, "meshscale"))  { set_mesh().scale(d); }
+    if(ats.get(x, "meshscale"))  { set_mesh().scale(x(0), x(1), x(2)); }
+    if(ats.get(set_mesh().C, "color")) {
       CHECK(mesh().C.N>=1 && mesh().C.N<=4, "color needs to be 1D, 2D, 3D or 4D (floats)");
     }
     if(ats.get(x, "mesh_rope"))  {
       CHECK_EQ(x.N, 4, "requires 3D extend and numSegments");
       uint n=x(-1);
       arr y = x({0,2});
-      arr& V = mesh().V;
+      arr& V = set_mesh().V;
       V.resize(n+1, 3).setZero();
       for(uint i=1;i<=n;i++){
         V[i] = (double(i)/n)*y;
       }
-      mesh().makeLineStrip();
+      set_mesh().makeLineStrip();
     }
 
     if(mesh().V.N && type()==ST_none) type()=ST_mesh;
@@ -1301,11 +1394,12 @@ void rai::Shape::read(const Graph& ats) {
     if(ats["coloredBox"]) {
       CHECK_EQ(mesh().V.d0, 8, "I need a box");
       arr col=mesh().C;
-      mesh().C.resize(mesh().T.d0, 3);
-      for(uint i=0; i<mesh().C.d0; i++) {
-        if(i==2 || i==3) mesh().C[i] = col; //arr(color, 3);
-        else if(i>=4 && i<=7) mesh().C[i] = 1.;
-        else mesh().C[i] = .5;
+      arr& C = set_mesh().C;
+      C.resize(mesh().T.d0, 3);
+      for(uint i=0; i<C.d0; i++) {
+        if(i==2 || i==3) C[i] = col; //arr(color, 3);
+        else if(i>=4 && i<=7) C[i] = 1.;
+        else C[i] = .5;
       }
     }
 
@@ -1321,7 +1415,7 @@ void rai::Shape::read(const Graph& ats) {
   //center the mesh:
   if(type()==rai::ST_mesh && mesh().V.N) {
     if(ats["rel_includes_mesh_center"]) {
-      mesh().center();
+      set_mesh().center();
     }
     //    if(c.length()>1e-8 && !ats["rel_includes_mesh_center"]){
     //      frame.link->Q.addRelativeTranslation(c);
@@ -1403,7 +1497,7 @@ void rai::Shape::glDraw(OpenGL& gl) {
       if(!mesh().V.N) {
         LOG(1) <<"trying to draw empty mesh";
       } else {
-        mesh().glDraw(gl);
+        _mesh->glDraw(gl); //drawing does not change the (possibly shared) mesh
       }
     }
   }
@@ -1430,24 +1524,24 @@ void rai::Shape::createMeshes() {
   switch(_type) {
     case rai::ST_none: HALT("shapes should have a type - somehow wrong initialization..."); break;
     case rai::ST_box:
-      mesh().clear();
-      mesh().setBox();
-      mesh().scale(size(0), size(1), size(2));
+      set_mesh().clear();
+      set_mesh().setBox();
+      set_mesh().scale(size(0), size(1), size(2));
       break;
     case rai::ST_sphere: {
-      sscCore().V = arr({1, 3}, {0., 0., 0.});
+      set_sscCore().V = arr({1, 3}, {0., 0., 0.});
       double rad=1;
       if(size.N) rad=size(-1);
-      mesh().setSSCvx(sscCore().V, rad);
+      set_mesh().setSSCvx(sscCore().V, rad);
     } break;
     case rai::ST_cylinder:
       CHECK(size(-1)>1e-10, "");
-      mesh().setCylinder(size(-1), size(-2));
+      set_mesh().setCylinder(size(-1), size(-2));
       break;
     case rai::ST_capsule:
       CHECK(size(-1)>1e-10, "");
-      sscCore().V = arr({2, 3}, {0., 0., -.5*size(-2), 0., 0., .5*size(-2)});
-      mesh().setSSCvx(sscCore().V, size(-1));
+      set_sscCore().V = arr({2, 3}, {0., 0., -.5*size(-2), 0., 0., .5*size(-2)});
+      set_mesh().setSSCvx(sscCore().V, size(-1));
       break;
     case rai::ST_marker:
     case rai::ST_camera:
@@ -1458,42 +1552,42 @@ void rai::Shape::createMeshes() {
       break;
     case rai::ST_quad: {
       byteA tex = mesh().texImg;
-      mesh().setQuad(size(0), size(1), tex);
+      set_mesh().setQuad(size(0), size(1), tex);
     } break;
     case rai::ST_ssCvx:
       CHECK(size(-1)>1e-10, "");
       if(!sscCore().V.N) {
         CHECK(mesh().V.N, "mesh or sscCore needs to be loaded");
-        sscCore() = mesh();
+        set_sscCore() = mesh();
       }
-      mesh().setSSCvx(sscCore().V, size.last());
+      set_mesh().setSSCvx(sscCore().V, size.last());
       break;
     case rai::ST_ssBox: {
       if(size(3)<1e-10) {
-        sscCore().setBox();
-        sscCore().scale(size(0), size(1), size(2));
-        mesh() = sscCore();
+        set_sscCore().setBox();
+        set_sscCore().scale(size(0), size(1), size(2));
+        set_mesh() = sscCore();
         break;
       }
       double r = size(3);
       CHECK(size.N==4 && r>1e-10, "");
       for(uint i=0; i<3; i++) if(size(i)<2.*r) size(i) = 2.*r;
-      sscCore().setBox();
-      sscCore().scale(size(0)-2.*r, size(1)-2.*r, size(2)-2.*r);
-      mesh().setSSBox(size(0), size(1), size(2), r);
+      set_sscCore().setBox();
+      set_sscCore().scale(size(0)-2.*r, size(1)-2.*r, size(2)-2.*r);
+      set_mesh().setSSBox(size(0), size(1), size(2), r);
       //      mesh().setSSCvx(sscCore, r);
     } break;
     case rai::ST_ssCylinder: {
       if(size(2)<1e-10) {
-        sscCore().setCylinder(size(1), size(0));
-        mesh() = sscCore();
+        set_sscCore().setCylinder(size(1), size(0));
+        set_mesh() = sscCore();
         break;
       }
       double r = size(2);
       CHECK(size.N==3 && r>1e-10, "");
       for(uint i=0; i<2; i++) if(size(i)<2.*r) size(i) = 2.*r;
-      sscCore().setCylinder(size(1)-2.*r, size(0)-2.*r);
-      mesh().setSSCvx(sscCore().V, r);
+      set_sscCore().setCylinder(size(1)-2.*r, size(0)-2.*r);
+      set_mesh().setSSCvx(sscCore().V, r);
     } break;
     case rai::ST_ssBoxElip: {
       CHECK_EQ(size.N, 7, "");
@@ -1505,8 +1599,8 @@ void rai::Shape::createMeshes() {
       rai::Mesh elip;
       elip.setSphere();
       elip.scale(size(3), size(4), size(5));
-      sscCore().setSSCvx(MinkowskiSum(box.V, elip.V), 0);
-      mesh().setSSCvx(sscCore().V, r);
+      set_sscCore().setSSCvx(MinkowskiSum(box.V, elip.V), 0);
+      set_mesh().setSSCvx(sscCore().V, r);
     } break;
     default: {
       HALT("createMeshes not possible for shape type '" <<_type <<"'");
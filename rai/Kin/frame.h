@@ -72,16 +72,19 @@ struct Transformation_Qtoken {
 struct Frame : NonCopyable {
   Configuration& C;        ///< a Frame is uniquely associated with a Configuration
   uint ID;                 ///< unique identifier (index in Configuration.frames)
-  String name;             ///< name
+  String name;             ///< name (rename with setName(), which updates the name index of getFrame; direct writes make lookups rebuild it)
   Frame* parent=nullptr;   ///< parent frame
   FrameL children;         ///< list of children
 
  protected:
-  Transformation Q=0;        ///< relative transform to parent
-  Transformation X=0;        ///< frame's absolute pose
+  //the references are invalidated when frames are added or removed (C.frameQ/frameX reallocate): copy before doing so
+  Transformation& Q();       ///< relative transform to parent (stored in C.frameQ, indexed by ID)
+  Transformation& X();       ///< frame's absolute pose (stored in C.frameX, indexed by ID)
+  const Transformation& Q() const;
+  const Transformation& X() const;
   //data structure state (lazy evaluation leave the state structure out of sync)
-  bool _state_X_isGood=true; // X represents the current state
-  void _state_setXBadinBranch();
+  bool _state_X_isGood=true; // X represents the current state (if !C._state_X_pending; otherwise X may be stale below a dirty ancestor)
+  void _state_setXBadinBranch(); // O(1): flags only this frame dirty -- the next C.ensure_X() recomputes its branch
   void _state_updateAfterTouchingX();
   void _state_updateAfterTouchingQ();
   //low-level fwd kinematics computation
@@ -90,7 +93,8 @@ struct Frame : NonCopyable {
 
  public:
   double tau=0.;             ///< frame's relative time transformation (could be thought as part of the transformation X in space-time)
-  std::shared_ptr<Graph> ats;                 ///< list of any-type attributes
+  std::shared_ptr<Graph> ats;                 ///< list of any-type attributes (possibly shared with copies of the configuration -- modify only via set_ats())
+  Graph& set_ats();                           ///< attributes for modification: created if missing, a graph shared with copies of the configuration is copied first (copy-on-write)
 
   //attachments to the frame
   Joint* joint=nullptr;          ///< this frame is an articulated joint
@@ -111,6 +115,7 @@ struct Frame : NonCopyable {
   const Transformation& ensure_X();
   const Transformation& get_Q() const;
   const Transformation& get_X() const;
+  Transformation calc_X_alongChain() const; ///< the current pose composed along the ancestor chain only -- O(depth), without a fwd pass or touching any state
   Transformation_Xtoken set_X() { return Transformation_Xtoken(*this); }
   Transformation_Qtoken set_Q() { return Transformation_Qtoken(*this); }
 
@@ -141,6 +146,7 @@ struct Frame : NonCopyable {
   void write(std::ostream& os) const;
 
   //-- HIGHER LEVEL USER INTERFACE
+  Frame& setName(const char* _name);
   Frame& setShape(rai::ShapeType shape, const arr& size);
   Frame& setPose(const rai::Transformation& _X);
   Frame& setPosition(const arr& pos);
@@ -231,6 +237,7 @@ struct Joint : Dof, NonCopyable {
 
   void setMimic(Joint* j, bool unsetPreviousMimic=false);
   void setDofs(const arr& q, uint n=0);
+  void calcTransformation(Transformation& Q, const double* qp) const; ///< the relative transform for the (scaled) joint state qp, without touching the frame (ignores mimic)
   arr calcDofsFromConfig() const;
   arr getScrewMatrix();
   uint getDimFromType() const;
@@ -289,9 +296,11 @@ struct Shape : NonCopyable, GLDrawer {
 
   double radius() { if(size.N) return size(-1); return 0.; }
   Enum<ShapeType>& type() { return _type; }
-  Mesh& mesh() { if(!_mesh) _mesh = make_shared<Mesh>();  return *_mesh; }
-  Mesh& sscCore() { if(!_sscCore) _sscCore = make_shared<Mesh>();  return *_sscCore; }
-  double alpha() { arr& C=mesh().C; if(C.N==4) return C(3); return 1.; }
+  const Mesh& mesh() const;     ///< possibly shared with copies of the configuration -- modify only via set_mesh()
+  const Mesh& sscCore() const;
+  Mesh& set_mesh();     ///< mesh for modification: a mesh shared with copies of the configuration is copied first (copy-on-write)
+  Mesh& set_sscCore();  ///< as above
+  double alpha() const { const arr& C=mesh().C; if(C.N==4) return C(3); return 1.; }
 
   void createMeshes();
   shared_ptr<ScalarFunction> functional(bool worldCoordinates=true);
@@ -25,10 +25,14 @@
 #include "../GeoOptim/geoOptim.h"
 #include "../Gui/opengl.h"
 #include "../Algo/algos.h"
+#include "../Core/thread.h"
 #include <iomanip>
 #include <algorithm>
 #include <sstream>
 #include <climits>
+#include <unordered_map>
+#include <map>
+#include <mutex>
 
 #ifdef RAI_ASSIMP
 #  include <assimp/Exporter.hpp>
@@ -42,7 +46,7 @@
 
 namespace rai {
 
-uint Configuration::setJointStateCount = 0;
+std::atomic<uint> Configuration::setJointStateCount(0);
 
 //===========================================================================
 //
@@ -79,7 +83,7 @@ uintA jointsToIndices(const JointL& joints) {
 
 void makeConvexHulls(FrameL& frames, bool onlyContactShapes) {
   for(Frame* f: frames) if(f->shape && (!onlyContactShapes || f->shape->cont))
-      f->shape->mesh().makeConvexHull();
+      f->shape->set_mesh().makeConvexHull();
 }
 
 void computeOptimalSSBoxes(FrameL& frames) {
@@ -103,16 +107,18 @@ void computeOptimalSSBoxes(FrameL& frames) {
 void computeMeshNormals(FrameL& frames, bool force) {
   for(Frame* f: frames) if(f->shape) {
       Shape* s = f->shape;
-      if(force || s->mesh().V.d0!=s->mesh().Vn.d0 || s->mesh().T.d0!=s->mesh().Tn.d0) s->mesh().computeNormals();
-      if(force || s->sscCore().V.d0!=s->sscCore().Vn.d0 || s->sscCore().T.d0!=s->sscCore().Tn.d0) s->sscCore().computeNormals();
+      const Mesh& m = s->mesh(), &c = s->sscCore();
+      if(force || m.V.d0!=m.Vn.d0 || m.T.d0!=m.Tn.d0) s->set_mesh().computeNormals();
+      if(force || c.V.d0!=c.Vn.d0 || c.T.d0!=c.Tn.d0) s->set_sscCore().computeNormals();
     }
 }
 
 void computeMeshGraphs(FrameL& frames, bool force) {
   for(Frame* f: frames) if(f->shape) {
       Shape* s = f->shape;
-      if(force || s->mesh().V.d0!=s->mesh().graph.N|| s->mesh().T.d0!=s->mesh().Tn.d0) s->mesh().buildGraph();
-      if(force || s->sscCore().V.d0!=s->sscCore().graph.N || s->sscCore().T.d0!=s->sscCore().Tn.d0) s->sscCore().buildGraph();
+      const Mesh& m = s->mesh(), &c = s->sscCore();
+      if(force || m.V.d0!=m.graph.N|| m.T.d0!=m.Tn.d0) s->set_mesh().buildGraph();
+      if(force || c.V.d0!=c.graph.N || c.T.d0!=c.Tn.d0) s->set_sscCore().buildGraph();
     }
 }
 
@@ -121,13 +127,78 @@ void computeMeshGraphs(FrameL& frames, bool force) {
 // Configuration
 //
 
+/// hashed name->frame index for getFrame (the first frame of each name wins): frames are indexed lazily in ID order, Frame::setName
+/// updates it, and a lookup that hits a stale entry or misses rebuilds it when the frames were renamed directly
+struct FrameNameIndex {
+  std::unordered_map<std::string, Frame*> map;
+  uint N=0; //frames 0..N-1 are indexed
+  std::mutex mutex;
+
+  static std::string key(const String& name) { return std::string(name.p, name.N); }
+
+  void reset() { std::lock_guard<std::mutex> lock(mutex); map.clear(); N=0; }
+
+  void index(const FrameL& frames) {
+    if(N>frames.N) { map.clear(); N=0; }
+    for(; N<frames.N; N++) map.emplace(key(frames.elem(N)->name), frames.elem(N));
+  }
+
+  Frame* find(const FrameL& frames, const char* name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    index(frames);
+    auto it = map.find(name);
+    if(it!=map.end() && it->second->name==name) return it->second;
+    //a miss, or an entry renamed directly (without setName) since it was indexed: if a frame has this name, rebuild
+    if(it==map.end()) {
+      uint i=0;
+      for(; i<frames.N; i++) if(frames.elem(i)->name==name) break;
+      if(i==frames.N) return nullptr;
+    }
+    map.clear(); N=0;
+    index(frames);
+    it = map.find(name);
+    if(it==map.end()) return nullptr;
+    return it->second;
+  }
+
+  void rename(const FrameL& frames, Frame* f, const String& oldName) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(f->ID>=N) return; //indexed later anyway
+    auto it = map.find(key(oldName));
+    if(it!=map.end() && it->second==f) { //the next frame of the old name (if any) takes over
+      map.erase(it);
+      for(uint i=f->ID+1; i<N; i++) if(frames.elem(i)->name==oldName) { map.emplace(key(oldName), frames.elem(i)); break; }
+    }
+    auto ins = map.emplace(key(f->name), f);
+    if(!ins.second && ins.first->second->ID>f->ID) ins.first->second = f;
+  }
+};
+
+/// the kinematicsPos/Vec/Quat results of one state revision, keyed on (primitive, frame ID, rel vector)
+struct KinematicsMemo {
+  typedef std::tuple<int, uint, double, double, double> Key;
+  std::map<Key, std::pair<arr, arr>> table;
+  uint revision=0;
+  Configuration::JacobianMode jacMode=Configuration::JM_dense;
+  std::mutex mutex; //features may be evaluated concurrently
+};
+
 struct sConfiguration {
+  KinematicsMemo kinematicsMemo;
+  FrameNameIndex frameNames;
   shared_ptr<ConfigurationViewer> viewer;
   shared_ptr<SwiftInterface> swift;
   shared_ptr<FclInterface> fcl;
   unique_ptr<PhysXInterface> physx;
   unique_ptr<OdeInterface> ode;
   unique_ptr<FeatherstoneInterface> fs;
+  shared_ptr<ThreadPool> batchPool;
+
+  //-- fwd pass (Configuration::calc_fwdPass)
+  FrameL fkOrder;   //all frames, parents before children, the subtree of each root contiguous
+  uintA fkSubtrees; //start of each root's subtree in fkOrder, plus the end
+  byteA fkChanged;  //per frame ID: X was recomputed or set in the current pass (entries set on entry: X is given)
+  std::mutex fkMutex; //a pending pass triggered by concurrent readers runs once (ensure_X_locked)
 };
 
 Configuration::Configuration() {
@@ -189,14 +260,13 @@ Frame* Configuration::addFrame(const char* name, const char* parent, const char*
   if(parent && parent[0]) {
     Frame* p = getFrame(parent);
     if(p) {
-      f->set_X() = p->ensure_X();
+      f->set_X() = p->calc_X_alongChain();
       f->setParent(p, true);
     }
   }
 
   if(args && args[0]) {
-    if(!f->ats) f->ats = make_shared<Graph>();
-    String(args) >>*(f->ats);
+    String(args) >>f->set_ats();
     f->read(*f->ats);
   }
 
@@ -238,7 +308,7 @@ void Configuration::addAssimp(const char* filename) {
       if(A.meshes(i)(0).V.N){
         Shape* s = new Shape(*f);
         s->type() = ST_mesh;
-        s->mesh() = A.meshes(i).scalar();
+        s->set_mesh() = A.meshes(i).scalar();
       }
     }else if(A.meshes(i).N>1){
       uint j=0;
@@ -249,7 +319,7 @@ void Configuration::addAssimp(const char* filename) {
           f1->set_Q()->setZero();
           Shape* s = new Shape(*f1);
           s->type() = ST_mesh;
-          s->mesh() = mesh;
+          s->set_mesh() = mesh;
         }
       }
     }
@@ -355,7 +425,8 @@ void Configuration::addConfiguration(const Configuration& C, double tau){
 /// get first frame with given name
 Frame* Configuration::getFrame(const char* name, bool warnIfNotExist, bool reverse) const {
   if(!reverse) {
-    for(Frame* b: frames) if(b->name==name) return b;
+    Frame* f = self->frameNames.find(frames, name);
+    if(f) return f;
   } else {
     for(uint i=frames.N; i--;) if(frames.elem(i)->name==name) return frames.elem(i);
   }
@@ -533,18 +604,219 @@ arr Configuration::getDofState(const DofL& dofs) const {
   return x;
 }
 
-/// get the (F.N,7)-matrix of all poses for all given frames
+/// forward kinematics: flagging a frame dirty is O(1) and leaves its branch as is; this pass walks all frames in a cached
+/// topological order (each parent before its children) and recomputes every dirty frame and every frame below a recomputed
+/// or explicitly set one -- instead of recursing up to the root on every pose access
+void Configuration::calc_fwdPass() {
+  sConfiguration& S = *self;
+  if(!_state_fkOrder_isGood) {
+    S.fkOrder.clear();
+    S.fkSubtrees.clear();
+    for(Frame* f:frames) if(!f->parent) {
+        S.fkSubtrees.append(S.fkOrder.N);
+        S.fkOrder.append(f);
+        for(uint i=S.fkSubtrees.last(); i<S.fkOrder.N; i++) S.fkOrder.append(S.fkOrder.elem(i)->children);
+      }
+    S.fkSubtrees.append(S.fkOrder.N);
+    CHECK_EQ(S.fkOrder.N, frames.N, "the frame tree has a loop");
+    _state_fkOrder_isGood=true;
+  }
+  if(S.fkChanged.N!=frames.N) S.fkChanged.resize(frames.N).setZero();
+
+  byte* changed = S.fkChanged.p;
+  auto pass = [this, &S, changed](uint start, uint end) {
+    for(uint i=start; i<end; i++) {
+      Frame* f = S.fkOrder.p[i];
+      byte& c = changed[f->ID];
+      if(c) { f->_state_X_isGood=true; continue; } //X was set explicitly
+      if(!f->parent) {
+        if(!f->_state_X_isGood) { f->_state_X_isGood=true; c=1; }
+      } else if(!f->_state_X_isGood || changed[f->parent->ID]) {
+        f->calc_X_from_parent();
+        c=1;
+      }
+    }
+  };
+
+  uint n = S.fkSubtrees.N-1;
+  if(fkThreads>1 && n>1) {
+    if(!S.batchPool || S.batchPool->size()!=fkThreads) S.batchPool = make_shared<ThreadPool>(fkThreads);
+    S.batchPool->parallelFor(n, [&](uint r, uint) { pass(S.fkSubtrees.p[r], S.fkSubtrees.p[r+1]); });
+  } else {
+    pass(0, S.fkOrder.N);
+  }
+
+  memset(changed, 0, S.fkChanged.N);
+  _state_X_pending=false;
+  _state_proxies_isGood=false;
+}
+
+void Configuration::ensure_X_locked() const {
+  std::lock_guard<std::mutex> lock(self->fkMutex);
+  if(_state_X_pending) ((Configuration*)this)->calc_fwdPass();
+}
+
+/// get the (F.N,7)-matrix of all poses for all given frames (for all frames: one pass over the pose arrays, see ensure_X)
 arr Configuration::getFrameState(const FrameL& F) const {
   arr X(F.N, 7);
-  for(uint i=0; i<X.d0; i++) {
-    X[i] = F.elem(i)->ensure_X().getArr7d();
+  double* x=X.p;
+  for(Frame* f:F) {
+    const Transformation& t = f->ensure_X();
+    x[0]=t.pos.x; x[1]=t.pos.y; x[2]=t.pos.z;
+    x[3]=t.rot.w; x[4]=t.rot.x; x[5]=t.rot.y; x[6]=t.rot.z;
+    x+=7;
+  }
+  return X;
+}
+
+/// forward kinematics for many joint states at once: one sweep over the frames on the paths to the roots
+/// (parents first) per sample, in local buffers -- the frames' own state is never touched
+arr Configuration::batchForwardKinematics(const arr& Q, const uintA& frameIDs, arr& J, int threads) {
+  uint n = getJointStateDimension();
+  CHECK_EQ(Q.nd, 2, "Q needs to be a (samples x dofs) matrix");
+  CHECK_EQ(Q.d1, n, "wrong joint state dimensionality");
+  uint S=Q.d0, F=frameIDs.N;
+
+  //poses of roots and relative transforms of non-articulated frames are read concurrently below
+  ensure_X();
+
+  //-- all frames on the paths to the roots, parents before children
+  FrameL path, chain;
+  intA parent, index(frames.N);
+  Array<const Joint*> joints; //for each path frame, its articulated joint (or nullptr)
+  index = -1;
+  for(uint id:frameIDs) {
+    chain.clear();
+    for(Frame* f=frames(id); f && index(f->ID)<0; f=f->parent) chain.append(f);
+    for(uint k=chain.N; k--;) {
+      Frame* f = chain(k);
+      index(f->ID) = path.N;
+      parent.append(f->parent ? index(f->parent->ID) : -1);
+      const Joint* j = f->joint;
+      const Joint* src = (j && j->mimic) ? j->mimic : j;
+      if(j && j->type!=JT_rigid && j->type!=JT_tau && src->active && src->qIndex<n) joints.append(j);
+      else joints.append(nullptr);
+      path.append(f);
+    }
+  }
+
+  //-- Jacobians are computed within the sweep for 1-dof hinge/prismatic joints; otherwise sample by sample on copies of the configuration
+  bool sweepJacobian = true;
+  for(const Joint* j:joints) if(j && (j->mimic || j->type<JT_hingeX || j->type>JT_transZ)) sweepJacobian=false;
+
+  arr X(S, F, 7);
+  if(!!J) J.resize(TUP(S, F, 7, n)).setZero();
+
+  auto sweep = [&](uint s, Array<Transformation>& Xs) {
+    const double* q = Q.p+s*n;
+    Transformation rel;
+    double qScaled[7];
+    for(uint i=0; i<path.N; i++) {
+      int p = parent.p[i];
+      if(p<0) { Xs.p[i] = path.p[i]->get_X(); continue; }
+      Xs.p[i] = Xs.p[p];
+      const Joint* j = joints.p[i];
+      if(j) {
+        const Joint* src = j->mimic ? j->mimic : j;
+        const double* qp = q+src->qIndex;
+        if(src->scale!=1.) {
+          for(uint k=0; k<src->dim; k++) qScaled[k] = src->scale*qp[k];
+          qp = qScaled;
+        }
+        src->calcTransformation(rel, qp);
+        Xs.p[i].appendTransformation(rel);
+      } else {
+        Xs.p[i].appendTransformation(path.p[i]->get_Q());
+      }
+    }
+
+    for(uint k=0; k<F; k++) {
+      uint a = index.p[frameIDs.p[k]];
+      const Transformation& Xa = Xs.p[a];
+      double* x = X.p+(s*F+k)*7;
+      x[0]=Xa.pos.x;  x[1]=Xa.pos.y;  x[2]=Xa.pos.z;
+      x[3]=Xa.rot.w;  x[4]=Xa.rot.x;  x[5]=Xa.rot.y;  x[6]=Xa.rot.z;
+      if(!J || !sweepJacobian) continue;
+
+      //same as kinematicsPos and kinematicsQuat (with a dense jacobian_angular)
+      double* Jp = J.p+(s*F+k)*7*n;
+      double* Jq = Jp+3*n;
+      const Quaternion& r = Xa.rot;
+      for(uint i=a; parent.p[i]>=0; i=parent.p[i]) {
+        const Joint* j = joints.p[i];
+        if(!j) continue;
+        const Transformation& from = Xs.p[parent.p[i]];
+        Vector axis;
+        if(j->type==JT_hingeX || j->type==JT_transX) axis = from.rot.getX();
+        else if(j->type==JT_hingeY || j->type==JT_transY) axis = from.rot.getY();
+        else axis = from.rot.getZ();
+        axis *= j->scale;
+        uint c = j->qIndex;
+        if(j->type>=JT_hingeX && j->type<=JT_hingeZ) {
+          Vector v = axis ^ (Xa.pos-from.pos);
+          Jp[c] += v.x;  Jp[n+c] += v.y;  Jp[2*n+c] += v.z;
+          Jq[c]     += .5*(-r.x*axis.x - r.y*axis.y - r.z*axis.z);
+          Jq[n+c]   += .5*(+r.w*axis.x + r.z*axis.y - r.y*axis.z);
+          Jq[2*n+c] += .5*(-r.z*axis.x + r.w*axis.y + r.x*axis.z);
+          Jq[3*n+c] += .5*(+r.y*axis.x - r.x*axis.y + r.w*axis.z);
+        } else {
+          Jp[c] += axis.x;  Jp[n+c] += axis.y;  Jp[2*n+c] += axis.z;
+        }
+      }
+    }
+  };
+
+  if(!threads) {
+    Array<Transformation> Xs(path.N);
+    for(uint s=0; s<S; s++) sweep(s, Xs);
+  } else {
+    if(!self->batchPool || (threads>0 && self->batchPool->size()!=(uint)threads)) self->batchPool = make_shared<ThreadPool>(threads>0 ? threads : 0);
+    ThreadPool& pool = *self->batchPool;
+    Array<Array<Transformation>> Xs(pool.size());
+    for(auto& x:Xs) x.resize(path.N);
+    uint chunk=64;
+    pool.parallelFor((S+chunk-1)/chunk, [&](uint c, uint worker) {
+      for(uint s=c*chunk; s<S && s<(c+1)*chunk; s++) sweep(s, Xs(worker));
+    });
+  }
+
+  //-- Jacobian fallback: each worker sets the joint states on its own copy of the configuration
+  if(!!J && !sweepJacobian) {
+    uint workers = threads ? self->batchPool->size() : 1;
+    Array<shared_ptr<Configuration>> copies(workers);
+    for(auto& C:copies) {
+      C = make_shared<Configuration>();
+      C->copy(*this);
+      C->jacMode = JM_dense;
+    }
+    auto jacobians = [&](uint s, Configuration& C) {
+      arr y, Jpos, Jquat;
+      C.setJointState(Q[s]);
+      for(uint k=0; k<F; k++) {
+        Frame* f = C.frames(frameIDs(k));
+        C.kinematicsPos(y, Jpos, f);
+        C.kinematicsQuat(y, Jquat, f);
+        memmove(J.p+(s*F+k)*7*n, Jpos.p, Jpos.N*J.sizeT);
+        memmove(J.p+((s*F+k)*7+3)*n, Jquat.p, Jquat.N*J.sizeT);
+      }
+    };
+    if(!threads) {
+      for(uint s=0; s<S; s++) jacobians(s, *copies(0));
+    } else {
+      uint chunk=16;
+      self->batchPool->parallelFor((S+chunk-1)/chunk, [&](uint c, uint worker) {
+        for(uint s=c*chunk; s<S && s<(c+1)*chunk; s++) jacobians(s, *copies(worker));
+      });
+    }
   }
+
   return X;
 }
 
 /// set the q-vector (all joint and force DOFs)
 void Configuration::setJointState(const arr& _q) {
   setJointStateCount++; //global counter
+  _state_revision++;
 
 #ifndef RAI_NOCHECK
   uint N=getJointStateDimension();
@@ -568,6 +840,7 @@ void Configuration::setJointState(const arr& _q) {
 /// set the DOFs (joints and forces) for the given subset of frames
 void Configuration::setDofState(const arr& _q, const DofL& dofs) {
   setJointStateCount++; //global counter
+  _state_revision++;
   ensure_q();
 
   uint nd=0;
@@ -608,15 +881,19 @@ void Configuration::setDofState(const arr& _q, const DofL& dofs) {
 /// set the pose of all frames as given by the (F.N,7)-matrix
 void Configuration::setFrameState(const arr& X, const FrameL& F) {
   CHECK_EQ(X.d0, F.N, "X.d0=" <<X.d0 <<" is larger than frames.N=" <<F.N);
-  for(Frame* f:F) f->_state_setXBadinBranch();
+  ensure_X();
+  //the given poses enter the fwd pass as explicitly set: only the frames below them are recomputed
+  self->fkChanged.resize(frames.N).setZero();
   for(uint i=0; i<F.N; i++) {
     Frame *f = F.elem(i);
-    f->X.set(X[i]);
-    f->X.rot.normalize();
-    f->_state_X_isGood = true;
+    f->X().set(X[i]);
+    f->X().rot.normalize();
+    self->fkChanged.p[f->ID] = 1;
   }
+  calc_fwdPass();
+  _state_revision++;
   for(Frame* f:F) if(f->parent){
-    f->Q.setDifference(f->parent->ensure_X(), f->X);
+    f->Q().setDifference(f->parent->X(), f->X());
     _state_q_isGood=false;
   }
 }
@@ -898,6 +1175,14 @@ void Configuration::clear() {
   _state_proxies_isGood=false;
 }
 
+void Configuration::reset_frameNames() {
+  self->frameNames.reset();
+}
+
+void Configuration::update_frameName(Frame* f, const String& oldName) {
+  self->frameNames.rename(frames, f, oldName);
+}
+
 /// clear the q-vector
 void Configuration::reset_q() {
   q.clear();
@@ -943,8 +1228,8 @@ void Configuration::flipFrames(Frame* a, Frame* b) {
   if(b->joint) {
     b->joint->flip();
   }
-  a->Q = -b->Q;
-  b->Q.setZero();
+  a->Q() = -b->Q();
+  b->Q().setZero();
   b->unLink();
   a->setParent(b);
 }
@@ -982,6 +1267,7 @@ void Configuration::reconnectLinksToClosestJoints() {
           f->parent->children.removeValue(f);
           link->children.append(f);
           f->parent = link;
+          _state_fkOrder_isGood=false;
           f->set_Q() = Q;
         }
       }
@@ -1010,8 +1296,15 @@ void Configuration::optimizeTree(bool _pruneRigidJoints, bool pruneNamed, bool p
 
 void Configuration::sortFrames() {
   frames = calc_topSort();
+  //permute the pose arrays along with the frames, so that they remain indexed by ID
+  Array<Transformation> Q(frames.N), X(frames.N);
+  for(uint i=0; i<frames.N; i++) { Q.p[i] = frameQ.p[frames.p[i]->ID];  X.p[i] = frameX.p[frames.p[i]->ID]; }
+  frameQ = Q;
+  frameX = X;
   uint i=0;
   for(Frame* f: frames) f->ID = i++;
+  _state_revision++; //the kinematics memo is keyed on frame IDs
+  reset_frameNames();
 }
 
 void Configuration::makeObjectsFree(const StringA& objects, double H_cost) {
@@ -1045,7 +1338,10 @@ bool Configuration::checkConsistency() const {
      when a frame has a parent, X may be non-good, but can always be computed using ensure_X
      q may generaly be non-good
      when setJointState is called, q becomes good and all Q are recomputed to stay consistent
-     when frame_setX... is called, q becomes non-good, all frame descendents will have non-good X, Q for that frame is recomputed (from its parent's X), and X for that frame is good as well
+     when frame_setX... is called, q becomes non-good, Q for that frame is recomputed (from its parent's X, composed along the parent's chain
+       without a fwd pass), and X for that frame and all its descendents is non-good
+     only the frames where the change happens are flagged non-good (_state_X_pending): as long as the flag is up, X of their descendents
+       may be stale while flagged good -- the next ensure_X recomputes all of them in one pass
 
      when initially loading a configuration, q and all X are typically non-good
      */
@@ -1096,21 +1392,21 @@ bool Configuration::checkConsistency() const {
     if(a->inertia) CHECK_EQ(&a->inertia->frame, a, "");
     if(a->ats) a->ats->checkConsistency();
 
-    a->Q.checkNan();
-    a->X.checkNan();
-    CHECK_ZERO(a->Q.rot.normalization()-1., 1e-6, "");
-    CHECK_ZERO(a->X.rot.normalization()-1., 1e-6, "");
+    a->Q().checkNan();
+    a->X().checkNan();
+    CHECK_ZERO(a->Q().rot.normalization()-1., 1e-6, "");
+    CHECK_ZERO(a->X().rot.normalization()-1., 1e-6, "");
 
     // frame has no parent -> Q needs to be zero, X is good
     if(!a->parent) {
-      CHECK(a->_state_X_isGood, "");
-      CHECK(a->Q.isZero(), "");
+      CHECK(a->_state_X_isGood || _state_X_pending, "");
+      CHECK(a->Q().isZero(), "");
     }
     // frame has a parent -> X may be non-good, otherwise it must be consistent with Q
-    if(a->parent && a->_state_X_isGood) {
+    if(a->parent && a->_state_X_isGood && !_state_X_pending) {
       CHECK(a->parent->_state_X_isGood, "");
-      Transformation test = a->parent->X * a->Q;
-      CHECK_ZERO((a->X / test).diffZero(), 1e-6, "");
+      Transformation test = a->parent->X() * a->Q();
+      CHECK_ZERO((a->X() / test).diffZero(), 1e-6, "");
     }
   }
 
@@ -1159,10 +1455,10 @@ bool Configuration::checkConsistency() const {
 
   //check isZero for all transformations
   for(Frame* a: frames) {
-    a->X.pos.checkZero();
-    a->X.rot.checkZero();
-    a->Q.pos.checkZero();
-    a->Q.rot.checkZero();
+    a->X().pos.checkZero();
+    a->X().rot.checkZero();
+    a->Q().pos.checkZero();
+    a->Q().rot.checkZero();
   }
 
   for(const Proxy& p : proxies) {
@@ -1276,6 +1572,7 @@ FrameL Configuration::getCollisionAllPairs(){
 void Configuration::prefixNames(bool clear) {
   if(!clear) for(Frame* a: frames) a->name=STRING('_' <<a->ID <<'_' <<a->name);
   else       for(Frame* a: frames) a->name.clear() <<a->ID;
+  reset_frameNames();
 }
 
 void Configuration::calc_indexedActiveJoints(bool resetActiveJointSet) {
@@ -1303,6 +1600,7 @@ void Configuration::calc_indexedActiveJoints(bool resetActiveJointSet) {
   }
 
   _state_indexedJoints_areGood=true;
+  _state_revision++;
 
   //-- count active DOFs
   uint qcount=0;
@@ -1454,7 +1752,7 @@ arr Configuration::calc_fwdPropagateVelocities(const arr& qdot) {
         Matrix R = j->X().rot.getMatrix();
         Vector qV(R*q_vel); //relative vel in global coords
         Vector qW(R*q_angvel); //relative ang vel in global coords
-        linVel += angVel^(f->X.pos - from->X.pos);
+        linVel += angVel^(f->X().pos - from->X().pos);
         /*if(!isLinkTree) */linVel += qW^(f->get_X().pos - j->X().pos);
         linVel += qV;
         angVel += qW;
@@ -1503,16 +1801,50 @@ void Configuration::kinematicsZero(arr& y, arr& J, uint n) const {
   jacobian_zero(J, n);
 }
 
-/// what is the linear velocity of a world point (pos_world) attached to frame a for a given joint velocity?
-void Configuration::jacobian_pos(arr& J, Frame* a, const Vector& pos_world) const {
-  CHECK_EQ(&a->C, this, "");
+//-- the Jacobian primitives below walk the chain from a frame to its root and emit their entries through one of
+//   two emitters: into the (dense or rowShifted) array J as before, or, for JM_sparse, as (row, col, value) triplets
+//   straight into a buffer preallocated for the dofs on the chain -- the cost is proportional to the chain length,
+//   not to getJointStateDimension() (which is T*n for a KOMO pathConfig)
 
-  a->ensure_X();
+namespace {
 
-  uint N=getJointStateDimension();
-  jacobian_zero(J, 3);
-  if(!J) return;
+/// writes Jacobian entries into a dense or rowShifted array (blocks overwrite)
+struct ArrJacobianEmitter {
+  arr& J;
+  ArrJacobianEmitter(arr& _J) : J(_J) {}
+  void add(uint i, uint j, double x) { J.elem(i, j) += x; }
+  void add3(uint j, const Vector& v) { add(0, j, v.x); add(1, j, v.y); add(2, j, v.z); }
+  void block(const arr& B, uint j) { J.setMatrixBlock(B, 0, j); }
+};
+
+/// writes Jacobian entries as sparse triplets into a preallocated buffer (no search for existing entries)
+struct TripletJacobianEmitter {
+  SparseMatrix& S;
+  uint k=0;
+  TripletJacobianEmitter(arr& J, uint d0, uint d1, uint maxEntries) : S(J.sparse()) {
+    S.resize(d0, d1, maxEntries);
+    if(S.rows.nd) { S.rows.clear(); S.cols.clear(); }
+  }
+  ~TripletJacobianEmitter() { S.resizeCopy(S.Z.d0, S.Z.d1, k); }
+  void add(uint i, uint j, double x) {
+    CHECK_LE(k+1, S.Z.N, "more Jacobian entries than preallocated");
+    S.elems.p[2*k]=i;  S.elems.p[2*k+1]=j;  S.Z.p[k]=x;  k++;
+  }
+  void add3(uint j, const Vector& v) { add(0, j, v.x); add(1, j, v.y); add(2, j, v.z); }
+  void block(const arr& B, uint j) { for(uint r=0; r<B.d0; r++) for(uint c=0; c<B.d1; c++) add(r, j+c, B.p[r*B.d1+c]); }
+};
+
+/// upper bound on the number of nonzeros of the position or angular Jacobian of frame a (3 rows per chain dof)
+uint chainJacobianEntries(Frame* a, uint N) {
+  uint n=0;
+  for(; a; a=a->parent) {
+    Joint* j=a->joint;
+    if(j && j->active && j->qIndex<N) n += 3*j->dim;
+  }
+  return n;
+}
 
+template<class Emitter> void emitJacobian_pos(Emitter& J, Frame* a, const Vector& pos_world, const arr& q, uint N) {
   while(a) { //loop backward down the kinematic tree
     if(!a->parent) break; //frame has no inlink -> done
     Joint* j=a->joint;
@@ -1523,77 +1855,56 @@ void Configuration::jacobian_pos(arr& J, Frame* a, const Vector& pos_world) cons
         if(j->type==JT_hingeX || j->type==JT_hingeY || j->type==JT_hingeZ) {
           Vector tmp = j->axis ^ (pos_world-j->X()*j->Q().pos);
           tmp *= j->scale;
-          J.elem(0, j_idx) += tmp.x;
-          J.elem(1, j_idx) += tmp.y;
-          J.elem(2, j_idx) += tmp.z;
-        } else if(j->type==JT_transX || j->type==JT_transY || j->type==JT_transZ || j->type==JT_XBall) {
-          J.elem(0, j_idx) += j->scale * j->axis.x;
-          J.elem(1, j_idx) += j->scale * j->axis.y;
-          J.elem(2, j_idx) += j->scale * j->axis.z;
+          J.add3(j_idx, tmp);
+        } else if(j->type==JT_transX || j->type==JT_transY || j->type==JT_transZ) {
+          J.add3(j_idx, j->scale * j->axis);
         } else if(j->type==JT_transXY) {
           arr R = j->X().rot.getArr();
           R *= j->scale;
-          J.setMatrixBlock(R.sub(0, -1, 0, 1), 0, j_idx);
+          J.block(R.sub(0, -1, 0, 1), j_idx);
         } else if(j->type==JT_transXYPhi) {
           arr R = j->X().rot.getArr();
           R *= j->scale;
-          J.setMatrixBlock(R.sub(0, -1, 0, 1), 0, j_idx);
-          Vector tmp = j->axis ^ (pos_world-(j->X().pos + j->X().rot*a->Q.pos));
+          J.block(R.sub(0, -1, 0, 1), j_idx);
+          Vector tmp = j->axis ^ (pos_world-(j->X().pos + j->X().rot*a->get_Q().pos));
           tmp *= j->scale;
-          J.elem(0, j_idx+2) += tmp.x;
-          J.elem(1, j_idx+2) += tmp.y;
-          J.elem(2, j_idx+2) += tmp.z;
+          J.add3(j_idx+2, tmp);
         } else if(j->type==JT_phiTransXY) {
           Vector tmp = j->axis ^ (pos_world-j->X().pos);
           tmp *= j->scale;
-          J.elem(0, j_idx) += tmp.x;
-          J.elem(1, j_idx) += tmp.y;
-          J.elem(2, j_idx) += tmp.z;
-          arr R = (j->X().rot*a->Q.rot).getArr();
+          J.add3(j_idx, tmp);
+          arr R = (j->X().rot*a->get_Q().rot).getArr();
           R *= j->scale;
-          J.setMatrixBlock(R.sub(0, -1, 0, 1), 0, j_idx+1);
+          J.block(R.sub(0, -1, 0, 1), j_idx+1);
         }
-        if(j->type==JT_XBall) {
+        if(j->type==JT_XBall) { //(the translational axis is the x-axis of the joint's origin)
           arr R = conv_vec2arr(j->X().rot.getX());
           R *= j->scale;
           R.reshape(3, 1);
-          J.setMatrixBlock(R, 0, j_idx);
+          J.block(R, j_idx);
         }
         if(j->type==JT_trans3 || j->type==JT_free) {
           arr R = j->X().rot.getArr();
           R *= j->scale;
-          J.setMatrixBlock(R, 0, j_idx);
+          J.block(R, j_idx);
         }
         if(j->type==JT_quatBall || j->type==JT_free || j->type==JT_XBall) {
           uint offset = 0;
           if(j->type==JT_XBall) offset=1;
           if(j->type==JT_free) offset=3;
-          arr Jrot = j->X().rot.getArr() * a->Q.rot.getJacobian(); //transform w-vectors into world coordinate
-          Jrot = crossProduct(Jrot, conv_vec2arr(pos_world-(j->X().pos+j->X().rot*a->Q.pos)));  //cross-product of all 4 w-vectors with lever
+          arr Jrot = j->X().rot.getArr() * a->get_Q().rot.getJacobian(); //transform w-vectors into world coordinate
+          Jrot = crossProduct(Jrot, conv_vec2arr(pos_world-(j->X().pos+j->X().rot*a->get_Q().pos)));  //cross-product of all 4 w-vectors with lever
           Jrot /= sqrt(sumOfSqr(q({j->qIndex+offset, j->qIndex+offset+3})));   //account for the potential non-normalization of q
-          //          for(uint i=0;i<4;i++) for(uint k=0;k<3;k++) J.elem(k,j_idx+offset+i) += Jrot(k,i);
           Jrot *= j->scale;
-          J.setMatrixBlock(Jrot, 0, j_idx+offset);
+          J.block(Jrot, j_idx+offset);
         }
       }
     }
     a = a->parent;
   }
-
-//  if(isSparseMatrix(J) && xIndex) {
-//    J.sparse().reshape(J.d0, J.d1+xIndex);
-//    J.sparse().rowShift(xIndex);
-//  }
 }
 
-/// what is the angular velocity of frame a for a given joint velocity?
-void Configuration::jacobian_angular(arr& J, Frame* a) const {
-  a->ensure_X();
-
-  uint N = getJointStateDimension();
-  jacobian_zero(J, 3);
-  if(!J) return;
-
+template<class Emitter> void emitJacobian_angular(Emitter& J, Frame* a, const arr& q, uint N) {
   while(a) { //loop backward down the kinematic tree
     Joint* j=a->joint;
     if(j && j->active) {
@@ -1602,9 +1913,7 @@ void Configuration::jacobian_angular(arr& J, Frame* a) const {
       if(j_idx<N) {
         if((j->type>=JT_hingeX && j->type<=JT_hingeZ) || j->type==JT_transXYPhi || j->type==JT_phiTransXY) {
           if(j->type==JT_transXYPhi) j_idx += 2; //refer to the phi only
-          J.elem(0, j_idx) += j->scale * j->axis.x;
-          J.elem(1, j_idx) += j->scale * j->axis.y;
-          J.elem(2, j_idx) += j->scale * j->axis.z;
+          J.add3(j_idx, j->scale * j->axis);
         }
         if(j->type==JT_quatBall || j->type==JT_free || j->type==JT_XBall) {
           uint offset = 0;
@@ -1612,9 +1921,8 @@ void Configuration::jacobian_angular(arr& J, Frame* a) const {
           if(j->type==JT_free) offset=3;
           arr Jrot = j->X().rot.getArr() * a->get_Q().rot.getJacobian(); //transform w-vectors into world coordinate
           Jrot /= sqrt(sumOfSqr(q({j->qIndex+offset, j->qIndex+offset+3}))); //account for the potential non-normalization of q
-          //          for(uint i=0;i<4;i++) for(uint k=0;k<3;k++) J.elem(k,j_idx+offset+i) += Jrot(k,i);
           Jrot *= j->scale;
-          J.setMatrixBlock(Jrot, 0, j_idx+offset);
+          J.block(Jrot, j_idx+offset);
         }
         //all other joints: J=0 !!
       }
@@ -1623,6 +1931,42 @@ void Configuration::jacobian_angular(arr& J, Frame* a) const {
   }
 }
 
+} //namespace
+
+/// what is the linear velocity of a world point (pos_world) attached to frame a for a given joint velocity?
+void Configuration::jacobian_pos(arr& J, Frame* a, const Vector& pos_world) const {
+  CHECK_EQ(&a->C, this, "");
+
+  a->ensure_X();
+
+  uint N=getJointStateDimension();
+  if(jacMode==JM_sparse && !!J) {
+    TripletJacobianEmitter S(J, 3, N, chainJacobianEntries(a, N));
+    emitJacobian_pos(S, a, pos_world, q, N);
+    return;
+  }
+  jacobian_zero(J, 3);
+  if(!J) return;
+  ArrJacobianEmitter D(J);
+  emitJacobian_pos(D, a, pos_world, q, N);
+}
+
+/// what is the angular velocity of frame a for a given joint velocity?
+void Configuration::jacobian_angular(arr& J, Frame* a) const {
+  a->ensure_X();
+
+  uint N = getJointStateDimension();
+  if(jacMode==JM_sparse && !!J) {
+    TripletJacobianEmitter S(J, 3, N, chainJacobianEntries(a, N));
+    emitJacobian_angular(S, a, q, N);
+    return;
+  }
+  jacobian_zero(J, 3);
+  if(!J) return;
+  ArrJacobianEmitter D(J);
+  emitJacobian_angular(D, a, q, N);
+}
+
 /// how does the time coordinate of frame a change with q-change?
 void Configuration::jacobian_tau(arr& J, Frame* a) const {
   HALT("use kinematicsTau?");
@@ -1649,15 +1993,61 @@ void Configuration::jacobian_tau(arr& J, Frame* a) const {
   }
 }
 
+namespace {
+
+enum KinematicsPrimitive { KP_pos, KP_vec, KP_quat };
+
+KinematicsMemo::Key kinematicsMemoKey(KinematicsPrimitive p, Frame* a, const Vector& rel) {
+  if(!rel || rel.isZero) return KinematicsMemo::Key(p, a->ID, 0., 0., 0.);
+  return KinematicsMemo::Key(p, a->ID, rel.x, rel.y, rel.z);
+}
+
+/// the memo table, cleared if the state or Jacobian format changed since it was filled
+KinematicsMemo& kinematicsMemo(const Configuration& C) {
+  KinematicsMemo& M = C.self->kinematicsMemo;
+  if(M.revision!=C._state_revision || M.jacMode!=C.jacMode) {
+    M.table.clear();
+    M.revision = C._state_revision;
+    M.jacMode = C.jacMode;
+  }
+  return M;
+}
+
+bool kinematicsMemoGet(const Configuration& C, arr& y, arr& J, const KinematicsMemo::Key& key) {
+  C.getJointStateDimension(); //ensure_q first: re-indexing the active DOFs bumps the revision, which must invalidate the table before the lookup
+  std::lock_guard<std::mutex> lock(C.self->kinematicsMemo.mutex);
+  KinematicsMemo& M = kinematicsMemo(C);
+  C.kinematicsMemoQueries++;
+  auto it = M.table.find(key);
+  if(it==M.table.end()) return false;
+  C.kinematicsMemoHits++;
+  if(!!y) y = it->second.first;
+  J = it->second.second;
+  return true;
+}
+
+void kinematicsMemoPut(const Configuration& C, const arr& y, const arr& J, const KinematicsMemo::Key& key) {
+  std::lock_guard<std::mutex> lock(C.self->kinematicsMemo.mutex);
+  KinematicsMemo& M = kinematicsMemo(C);
+  std::pair<arr, arr>& entry = M.table[key];
+  entry.first = y;
+  entry.second = J;
+}
+
+} //namespace
+
 /** @brief return the jacobian \f$J = \frac{\partial\phi_i(q)}{\partial q}\f$ of the position
   of the i-th body (3 x n tensor)*/
 void Configuration::kinematicsPos(arr& y, arr& J, Frame* a, const Vector& rel) const {
   CHECK_EQ(&a->C, this, "given frame is not element of this Configuration");
+  bool memo = useKinematicsMemo && !!J;
+  if(memo && kinematicsMemoGet(*this, y, J, kinematicsMemoKey(KP_pos, a, rel))) return;
 
   Vector pos_world = a->ensure_X().pos;
   if(!!rel && !rel.isZero) pos_world += a->ensure_X().rot*rel;
   if(!!y) y = conv_vec2arr(pos_world);
   if(!!J) jacobian_pos(J, a, pos_world);
+  if(memo) kinematicsMemoPut(*this, conv_vec2arr(pos_world), J, kinematicsMemoKey(KP_pos, a, rel));
 }
 
 /* takes the joint state x and returns the jacobian dz of
@@ -1666,6 +2056,8 @@ void Configuration::kinematicsPos(arr& y, arr& J, Frame* a, const Vector& rel) c
 void Configuration::kinematicsVec(arr& y, arr& J, Frame* a, const Vector& vec) const {
   CHECK_EQ(&a->C, this, "");
   CHECK(!!vec, "need a vector");
+  bool memo = useKinematicsMemo && !!J;
+  if(memo && kinematicsMemoGet(*this, y, J, kinematicsMemoKey(KP_vec, a, vec))) return;
 
   Vector vec_world;
   vec_world = a->ensure_X().rot*vec;
@@ -1675,6 +2067,7 @@ void Configuration::kinematicsVec(arr& y, arr& J, Frame* a, const Vector& vec) c
     jacobian_angular(A, a);
     J = crossProduct(A, conv_vec2arr(vec_world));
   }
+  if(memo) kinematicsMemoPut(*this, conv_vec2arr(vec_world), J, kinematicsMemoKey(KP_vec, a, vec));
 }
 
 /// Jacobian of the i-th body's orientation matrix (flattened as 9-vector)
@@ -1704,6 +2097,8 @@ void Configuration::kinematicsMat(arr& y, arr& J, Frame* a) const {
 /// Jacobian of the i-th body's z-orientation vector
 void Configuration::kinematicsQuat(arr& y, arr& J, Frame* a) const { //TODO: allow for relative quat
   CHECK_EQ(&a->C, this, "");
+  bool memo = useKinematicsMemo && !!J;
+  if(memo && kinematicsMemoGet(*this, y, J, kinematicsMemoKey(KP_quat, a, NoVector))) return;
 
   const Quaternion& rot_a = a->ensure_X().rot;
   if(!!y) y = rot_a.getArr4d();
@@ -1732,6 +2127,7 @@ void Configuration::kinematicsQuat(arr& y, arr& J, Frame* a) const { //TODO: all
     J *= .5;
     J = ROT_A * J;
   } else NIY;
+  if(memo) kinematicsMemoPut(*this, rot_a.getArr4d(), J, kinematicsMemoKey(KP_quat, a, NoVector));
 }
 
 void Configuration::kinematicsTau(double& tau, arr& J, Frame* a) const {
@@ -1782,95 +2178,273 @@ void Configuration::kinematicsPos_wrtFrame(arr& y, arr& J, Frame* b, const Vecto
   }
 }
 
-/** @brief return the Hessian \f$H = \frac{\partial^2\phi_i(q)}{\partial q\partial q}\f$ of the position
-  of the i-th body (3 x n x n tensor) */
-void Configuration::hessianPos(arr& H, Frame* a, Vector* rel) const {
-  HALT("this is buggy: a sign error: see examples/Kin/ors testKinematics");
-  Joint* j1, *j2;
-  uint j1_idx, j2_idx;
-  Vector tmp, pos_a;
+//-- second-order kinematics: every dof on the chain of a frame acts as a twist (angular axis w and linear part v, the
+//   velocity of the point at the world origin), so that its Jacobian column for a world point p is v + w x p. An ancestor
+//   dof i rigidly transports all dofs j after it, dw_j/dq_i = w_i x w_j, and all mixed second derivatives follow from
+//   the first-order twists of the same sweep. Only the 4 dofs of a quaternion joint are not exponential coordinates --
+//   for these the derivative of their axes is given explicitly
 
-  uint N=getJointStateDimension();
+namespace {
 
-  //initialize Jacobian
-  H.resize(3, N, N);
-  H.setZero();
-
-  //get reference frame
-  pos_a = a->ensure_X().pos;
-  if(rel) pos_a += a->ensure_X().rot*(*rel);
-
-  if((j1=a->joint)) {
-    while(j1) {
-      j1_idx=j1->qIndex;
-
-      j2=j1;
-      while(j2) {
-        j2_idx=j2->qIndex;
-
-        if(j1->type>=JT_hingeX && j1->type<=JT_hingeZ && j2->type>=JT_hingeX && j2->type<=JT_hingeZ) { //both are hinges
-          tmp = j2->axis ^ (j1->axis ^ (pos_a-j1->X().pos));
-          H(0, j1_idx, j2_idx) = H(0, j2_idx, j1_idx) = tmp.x;
-          H(1, j1_idx, j2_idx) = H(1, j2_idx, j1_idx) = tmp.y;
-          H(2, j1_idx, j2_idx) = H(2, j2_idx, j1_idx) = tmp.z;
-        } else if(j1->type>=JT_transX && j1->type<=JT_transZ && j2->type>=JT_hingeX && j2->type<=JT_hingeZ) { //i=trans, j=hinge
-          tmp = j1->axis ^ j2->axis;
-          H(0, j1_idx, j2_idx) = H(0, j2_idx, j1_idx) = tmp.x;
-          H(1, j1_idx, j2_idx) = H(1, j2_idx, j1_idx) = tmp.y;
-          H(2, j1_idx, j2_idx) = H(2, j2_idx, j1_idx) = tmp.z;
-        } else if(j1->type==JT_transXY && j2->type>=JT_hingeX && j2->type<=JT_hingeZ) { //i=trans3, j=hinge
-          NIY;
-        } else if(j1->type==JT_transXYPhi && j1->type==JT_phiTransXY && j2->type>=JT_hingeX && j2->type<=JT_hingeZ) { //i=trans3, j=hinge
-          NIY;
-        } else if(j1->type==JT_trans3 && j2->type>=JT_hingeX && j2->type<=JT_hingeZ) { //i=trans3, j=hinge
-          Matrix R, A;
-          j1->X().rot.getMatrix(R.p());
-          A.setSkew(j2->axis);
-          R = R*A;
-          H(0, j1_idx, j2_idx) = H(0, j2_idx, j1_idx) = R.m00;
-          H(1, j1_idx, j2_idx) = H(1, j2_idx, j1_idx) = R.m10;
-          H(2, j1_idx, j2_idx) = H(2, j2_idx, j1_idx) = R.m20;
-          H(0, j1_idx+1, j2_idx) = H(0, j2_idx, j1_idx+1) = R.m01;
-          H(1, j1_idx+1, j2_idx) = H(1, j2_idx, j1_idx+1) = R.m11;
-          H(2, j1_idx+1, j2_idx) = H(2, j2_idx, j1_idx+1) = R.m21;
-          H(0, j1_idx+2, j2_idx) = H(0, j2_idx, j1_idx+2) = R.m02;
-          H(1, j1_idx+2, j2_idx) = H(1, j2_idx, j1_idx+2) = R.m12;
-          H(2, j1_idx+2, j2_idx) = H(2, j2_idx, j1_idx+2) = R.m22;
-        } else if(j1->type>=JT_hingeX && j1->type<=JT_hingeZ && j2->type>=JT_transX && j2->type<=JT_trans3) { //i=hinge, j=trans
-          //nothing! Hessian is zero (ej is closer to root than ei)
-        } else NIY;
+/// the twists of all dofs on the chain of a frame, in the order their transformations are applied (root first)
+struct ChainTwists {
+  uintA dofs;
+  Array<Vector> w, v;
+  uintA quatStart;            ///< for each quaternion joint on the chain, the position of its first (of 4) dofs
+  Array<Vector> quatCenter;   ///< for each quaternion joint, the center of rotation
+  Array<Vector> quatDw;       ///< for each quaternion joint, the 4x4 derivatives dw_k/dq_l
+
+  ChainTwists(Frame* a, const arr& q, uint N) {
+    FrameL chain;
+    for(; a && a->parent; a=a->parent) {
+      Joint* j=a->joint;
+      if(j && j->active && j->qIndex<N) chain.append(a);
+    }
+    for(uint c=chain.N; c--;) {
+      Frame* f = chain(c);
+      Joint* j = f->joint;
+      Transformation X = j->X();
+      uint idx = j->qIndex;
+      double s = j->scale;
+      switch(j->type) {
+        case JT_hingeX: case JT_hingeY: case JT_hingeZ:
+          addRot(idx, s*j->axis, X*j->Q().pos);  break;
+        case JT_transX: case JT_transY: case JT_transZ:
+          addTrans(idx, s*j->axis);  break;
+        case JT_transXY:
+          addTrans(idx, s*X.rot.getX());  addTrans(idx+1, s*X.rot.getY());  break;
+        case JT_transXYPhi:
+          addTrans(idx, s*X.rot.getX());  addTrans(idx+1, s*X.rot.getY());
+          addRot(idx+2, s*j->axis, X.pos + X.rot*f->get_Q().pos);  break;
+        case JT_phiTransXY: {
+          addRot(idx, s*j->axis, X.pos);
+          Quaternion rot = X.rot*f->get_Q().rot;
+          addTrans(idx+1, s*rot.getX());  addTrans(idx+2, s*rot.getY());
+        } break;
+        case JT_XBall:
+          addTrans(idx, s*X.rot.getX());
+          addQuat(idx+1, f, q, s);  break;
+        case JT_trans3: case JT_free:
+          addTrans(idx, s*X.rot.getX());  addTrans(idx+1, s*X.rot.getY());  addTrans(idx+2, s*X.rot.getZ());
+          if(j->type==JT_free) addQuat(idx+3, f, q, s);
+          break;
+        case JT_quatBall:
+          addQuat(idx, f, q, s);  break;
+        default: break; //as for the Jacobians: all other joints contribute nothing
+      }
+    }
+  }
 
-        j2=j2->from()->joint;
-        if(!j2) break;
+  void addTrans(uint idx, const Vector& axis) { dofs.append(idx);  w.append(Vector(0));  v.append(axis); }
+  void addRot(uint idx, const Vector& axis, const Vector& center) { dofs.append(idx);  w.append(axis);  v.append(center ^ axis); }
+
+  /// w_k = s X.rot G_k(q/|q|) / |q| with G=Quaternion::getJacobian(), which is linear in the quaternion: G_k(u) = sum_l u_l G_k(e_l)
+  void addQuat(uint idx, Frame* f, const arr& q, double s) {
+    Transformation X = f->joint->X();
+    Vector c = X.pos + X.rot*f->get_Q().pos;
+    const double* qj = q.p+idx;
+    double qq = qj[0]*qj[0] + qj[1]*qj[1] + qj[2]*qj[2] + qj[3]*qj[3];
+    arr Jrot = X.rot.getArr() * f->get_Q().rot.getJacobian();
+    Jrot *= s/sqrt(qq);
+    quatStart.append(dofs.N);
+    quatCenter.append(c);
+    for(uint k=0; k<4; k++) addRot(idx+k, Vector(Jrot(0, k), Jrot(1, k), Jrot(2, k)), c);
+    Quaternion e;
+    for(uint l=0; l<4; l++) {
+      e.set(l==0, l==1, l==2, l==3);
+      arr B = X.rot.getArr() * e.getJacobian();
+      for(uint k=0; k<4; k++) {
+        Vector dw = Vector(B(0, k), B(1, k), B(2, k));
+        quatDw.append((s/qq)*dw - (2.*qj[l]/qq)*w(dofs.N-4+k));
       }
-      j1=j1->from()->joint;
-      if(!j1) break;
     }
   }
+
+  /// the quaternion joint that chain dofs i and j both belong to, or -1
+  int quatJoint(uint i, uint j) const {
+    for(uint b=0; b<quatStart.N; b++) if(i>=quatStart(b) && i<quatStart(b)+4 && j>=quatStart(b) && j<quatStart(b)+4) return b;
+    return -1;
+  }
+  const Vector& dw(uint b, uint k, uint l) const { return quatDw(16*b+4*l+k); } ///< dw_k/dq_l within quaternion joint b
+};
+
+inline void setHessianEntry(arr& H, uint i, uint j, const Vector& h) {
+  uint m=H.d1;
+  H.p[i*m+j]=h.x;  H.p[m*m+i*m+j]=h.y;  H.p[2*m*m+i*m+j]=h.z;
+}
+
+/// second order kinematics of a point (isPoint) or a direction attached to a frame, both given in world coordinates
+void hessianPoint(HessianBlock& y, const ChainTwists& T, const Vector& p, bool isPoint) {
+  uint m=T.dofs.N;
+  y.resize(3, T.dofs);
+  y.y = conv_vec2arr(p);
+  Array<Vector> J(m);
+  for(uint i=0; i<m; i++) {
+    J(i) = T.w(i) ^ p;
+    if(isPoint) J(i) += T.v(i);
+    y.J(0, i)=J(i).x;  y.J(1, i)=J(i).y;  y.J(2, i)=J(i).z;
+  }
+  for(uint i=0; i<m; i++) for(uint j=i; j<m; j++) {
+      if(T.quatJoint(i, j)>=0) continue;
+      Vector h = T.w(i) ^ J(j);
+      setHessianEntry(y.H, i, j, h);
+      setHessianEntry(y.H, j, i, h);
+    }
+  for(uint b=0; b<T.quatStart.N; b++) {
+    Vector r = p;
+    if(isPoint) r -= T.quatCenter(b);
+    uint s=T.quatStart(b);
+    for(uint k=0; k<4; k++) for(uint l=0; l<4; l++) {
+        setHessianEntry(y.H, s+k, s+l, (T.dw(b, k, l) ^ r) + (T.w(s+k) ^ J(s+l)));
+      }
+  }
+}
+
+/// c = (0,a) * b (quaternion product with a pure quaternion a)
+inline void quatMultPure(double* c, const Vector& a, const double* b) {
+  c[0] = -a.x*b[1] - a.y*b[2] - a.z*b[3];
+  c[1] =  a.x*b[0] + a.y*b[3] - a.z*b[2];
+  c[2] = -a.x*b[3] + a.y*b[0] + a.z*b[1];
+  c[3] =  a.x*b[2] - a.y*b[1] + a.z*b[0];
+}
+
+} //namespace
+
+void HessianBlock::resize(uint d, const uintA& _dofs) {
+  dofs = _dofs;
+  uint m=dofs.N;
+  y.resize(d).setZero();
+  J.resize(d, m).setZero();
+  H.resize(d, m, m).setZero();
+}
+
+void HessianBlock::align(HessianBlock& b) {
+  if(dofs==b.dofs) return;
+  uint m1=dofs.N, m2=b.dofs.N, m=m1+m2;
+  auto pad = [m](HessianBlock& x, uint off) {
+    uint d=x.y.N, mx=x.dofs.N;
+    arr J=zeros(d, m), H=zeros(d, m, m);
+    for(uint k=0; k<d; k++) for(uint i=0; i<mx; i++) {
+        J(k, off+i) = x.J(k, i);
+        for(uint j=0; j<mx; j++) H(k, off+i, off+j) = x.H(k, i, j);
+      }
+    x.J = J;
+    x.H = H;
+  };
+  uintA all = dofs;
+  all.append(b.dofs);
+  pad(*this, 0);
+  pad(b, m1);
+  dofs = b.dofs = all;
+}
+
+void HessianBlock::addWeighted(arr& Hq, const arr& w, const arr& gaussNewtonWeights) const {
+  uint d=y.N, m=dofs.N;
+  CHECK_EQ(w.N, d, "");
+  arr W = zeros(m, m);
+  for(uint k=0; k<d; k++) if(w.p[k]) W += w.p[k] * H[k];
+  if(!!gaussNewtonWeights && m) {
+    CHECK_EQ(gaussNewtonWeights.N, d, "");
+    arr GN = zeros(m, m);
+    for(uint k=0; k<d; k++) if(gaussNewtonWeights.p[k]) GN += gaussNewtonWeights.p[k] * (J[k] ^ J[k]);
+    arr sig, V;
+    W += GN;
+    lapack_EigenDecomp(W, sig, V);
+    if(min(sig)<0.) {
+      for(double& s:sig) if(s<0.) s=0.;
+      W = ~V * diag(sig) * V;
+    }
+    W -= GN;
+  }
+  if(isSparseMatrix(Hq)) {
+    SparseMatrix& S = Hq.sparse();
+    uint nz=0, k=Hq.N;
+    for(double x:W) if(x) nz++;
+    S.resizeCopy(Hq.d0, Hq.d1, k+nz);
+    if(S.rows.nd) { S.rows.clear(); S.cols.clear(); }
+    for(uint i=0; i<m; i++) for(uint j=0; j<m; j++) {
+        double x = W.p[i*m+j];
+        if(!x) continue;
+        S.elems.p[2*k] = dofs.p[i];  S.elems.p[2*k+1] = dofs.p[j];  Hq.p[k] = x;  k++;
+      }
+  } else {
+    CHECK(!isSpecial(Hq), "");
+    for(uint i=0; i<m; i++) for(uint j=0; j<m; j++) Hq(dofs.p[i], dofs.p[j]) += W.p[i*m+j];
+  }
+}
+
+/** @brief the position of a point attached to frame a, with its Jacobian and Hessian w.r.t. the dofs on the chain of a,
+  all from one sweep down the chain */
+void Configuration::hessianPos(HessianBlock& y, Frame* a, const Vector& rel) const {
+  CHECK_EQ(&a->C, this, "given frame is not element of this Configuration");
+  Vector pos_world = a->ensure_X().pos;
+  if(!!rel && !rel.isZero) pos_world += a->ensure_X().rot*rel;
+  hessianPoint(y, ChainTwists(a, q, getJointStateDimension()), pos_world, true);
+}
+
+/// second-order kinematics of the vector vec attached to frame a
+void Configuration::hessianVec(HessianBlock& y, Frame* a, const Vector& vec) const {
+  CHECK_EQ(&a->C, this, "");
+  Vector vec_world = a->ensure_X().rot*vec;
+  hessianPoint(y, ChainTwists(a, q, getJointStateDimension()), vec_world, false);
+}
+
+/// second-order kinematics of the quaternion of frame a (same convention as kinematicsQuat: dy = .5 (0,w) * y)
+void Configuration::hessianQuat(HessianBlock& y, Frame* a) const {
+  CHECK_EQ(&a->C, this, "");
+  const Quaternion& rot_a = a->ensure_X().rot;
+  ChainTwists T(a, q, getJointStateDimension());
+  uint m=T.dofs.N;
+  y.resize(4, T.dofs);
+  y.y = rot_a.getArr4d();
+  arr J(m, 4); //transposed
+  for(uint i=0; i<m; i++) {
+    quatMultPure(J[i].p, .5*T.w(i), y.y.p);
+    for(uint k=0; k<4; k++) y.J(k, i) = J(i, k);
+  }
+  double h[4], tmp[4];
+  auto set = [&y, m, &h](uint i, uint j) { for(uint k=0; k<4; k++) y.H.p[(k*m+i)*m+j] = h[k]; };
+  for(uint i=0; i<m; i++) for(uint j=i; j<m; j++) {
+      if(T.quatJoint(i, j)>=0) continue;
+      quatMultPure(h, .5*T.w(j), J[i].p);
+      quatMultPure(tmp, .5*(T.w(i) ^ T.w(j)), y.y.p);
+      for(uint k=0; k<4; k++) h[k] += tmp[k];
+      set(i, j);
+      set(j, i);
+    }
+  for(uint b=0; b<T.quatStart.N; b++) {
+    uint s=T.quatStart(b);
+    for(uint k=0; k<4; k++) for(uint l=0; l<4; l++) {
+        quatMultPure(h, .5*T.w(s+k), J[s+l].p);
+        quatMultPure(tmp, .5*T.dw(b, k, l), y.y.p);
+        for(uint c=0; c<4; c++) h[c] += tmp[c];
+        set(s+k, s+l);
+      }
+  }
 }
 
 void Configuration::equationOfMotion(arr& M, arr& F, const arr& qdot, bool gravity) {
   fs().update();
-  fs().setGravity();
+  fs().setGravity(gravity ? -9.81 : 0.);
   fs().equationOfMotion(M, F, qdot);
 }
 
 /** @brief return the joint accelerations \f$\ddot q\f$ given the
-  joint torques \f$\tau\f$ (computed via Featherstone's Articulated Body Algorithm in O(n)) */
+  joint torques \f$\tau\f$ (computed via Featherstone's Articulated Body Algorithm in O(n),
+  or by inverting the mass matrix if Featherstone/useABA=false) */
 void Configuration::fwdDynamics(arr& qdd, const arr& qd, const arr& tau, bool gravity) {
   fs().update();
-  fs().setGravity();
+  fs().setGravity(gravity ? -9.81 : 0.);
   //  cout <<tree <<endl;
-  fs().fwdDynamics_MF(qdd, qd, tau);
-  //  fs().fwdDynamics_aba_1D(qdd, qd, tau); //works
-  //  fwdDynamics_aba_nD(qdd, tree, qd, tau); //does not work
+  if(fs().useABA) fs().fwdDynamics_aba(qdd, qd, tau);
+  else fs().fwdDynamics_MF(qdd, qd, tau);
 }
 
 /** @brief return the necessary joint torques \f$\tau\f$ to achieve joint accelerations
   \f$\ddot q\f$ (computed via the Recursive Newton-Euler Algorithm in O(n)) */
 void Configuration::inverseDynamics(arr& tau, const arr& qd, const arr& qdd, bool gravity) {
   fs().update();
-  fs().setGravity();
+  fs().setGravity(gravity ? -9.81 : 0.);
   fs().invDynamics(tau, qd, qdd);
 }
 
@@ -2074,11 +2648,8 @@ void Configuration::stepDynamics(arr& qdot, const arr& Bu_control, double tau, d
 
   auto eqn = [&](const arr& x) -> arr {
     setJointState(x[0]);
-    arr M, Minv, F;
-    equationOfMotion(M, F, x[1], gravity);
-    inverse_SymPosDef(Minv, M);
-    //Minv = inverse(M); //TODO why does symPosDef fail?
-    arr y = Minv * (Bu_control - F);
+    arr y;
+    fwdDynamics(y, x[1], Bu_control, gravity);
     return y;
   };
 
@@ -2171,7 +2742,7 @@ void Configuration::copyProxies(const ProxyA& _proxies) {
 
 /// prototype for \c operator<<
 void Configuration::write(std::ostream& os, bool explicitlySorted) const {
-  for(Frame* f: frames) if(!f->name.N) f->name <<'_' <<f->ID;
+  for(Frame* f: frames) if(!f->name.N) f->setName(STRING('_' <<f->ID));
   if(!explicitlySorted){
     for(Frame* f: frames) f->write(os);
   }else{
@@ -2182,7 +2753,7 @@ void Configuration::write(std::ostream& os, bool explicitlySorted) const {
 }
 
 void Configuration::write(Graph& G) const {
-  for(Frame* f: frames) if(!f->name.N) f->name <<'_' <<f->ID;
+  for(Frame* f: frames) if(!f->name.N) f->setName(STRING('_' <<f->ID));
   for(Frame* f: frames) f->write(G.newSubgraph({f->name}));
 }
 
@@ -2290,7 +2861,7 @@ void Configuration::writeCollada(const char* filename, const char* format) const
     // create a mesh?
     if(f->shape && f->shape->type()!=ST_marker){
       aiMesh* mesh = scene.mMeshes[n_meshes] = new aiMesh();
-      Mesh& M = f->shape->mesh();
+      const Mesh& M = f->shape->mesh();
       buildAiMesh(M, mesh);
       double alpha = f->shape->alpha();
       if(alpha==1.)
@@ -2355,7 +2926,7 @@ void Configuration::writeMeshes(const char* pathPrefix) const {
       if(f->shape->type()==ST_ssCvx) f->shape->sscCore().writeArr(FILE(filename));
 #else
       filename <<f->name <<".ply";
-      f->ats->getNew<FileToken>("mesh").name = filename;
+      f->set_ats().getNew<FileToken>("mesh").name = filename;
       if(f->shape->type()==ST_mesh) f->shape->mesh().writePLY(filename.p);
       if(f->shape->type()==ST_ssCvx) f->shape->sscCore().writePLY(filename.p);
 #endif
@@ -2464,7 +3035,7 @@ void Configuration::report(std::ostream& os) const {
      <<" #ucertainties=" <<nUc
      <<" #proxies=" <<proxies.N
      <<" #dofs=" <<dofs.N
-     <<" #evals=" <<setJointStateCount
+     <<" #evals=" <<setJointStateCount.load()
      <<endl;
 
 //  os <<" limits=" <<getLimits() <<endl;
@@ -2571,7 +3142,7 @@ void Configuration::readFromGraph(const Graph& G, bool addInsteadOfClear) {
       Frame* b = listFindByName(frames, n->parents(0)->key);
       CHECK(b, "could not find frame '" <<n->parents(0)->key <<"'");
       f->setParent(b);
-      if((*f->ats)["rel"]) f->ats->get(f->Q, "rel");
+      if((*f->ats)["rel"]) f->ats->get(f->Q(), "rel");
     }
   }
 
@@ -2909,7 +3480,7 @@ void Configuration::glDraw_sub(OpenGL& gl, const FrameL& F, int drawOpaqueOrTran
   if(drawOpaqueOrTransparanet==0 || drawOpaqueOrTransparanet==1) {
     //first non-transparent
     for(Frame* f: F) if(f->shape && f->shape->alpha()==1.) {
-      if(F.nd==2 && f->ID>F.d1 && f->shape->_mesh==F.elem(f->ID-F.d1)->shape->_mesh && f->X==F.elem(f->ID-F.d1)->X){//has the same shape and pose as previous time slice frame
+      if(F.nd==2 && f->ID>F.d1 && f->shape->_mesh==F.elem(f->ID-F.d1)->shape->_mesh && f->X()==F.elem(f->ID-F.d1)->X()){//has the same shape and pose as previous time slice frame
         continue;
       }
       gl.drawId(f->ID);
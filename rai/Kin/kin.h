@@ -13,6 +13,8 @@
 #include "../Geo/geo.h"
 #include "../Geo/mesh.h"
 
+#include <atomic>
+
 struct OpenGL;
 struct PhysXInterface;
 struct SwiftInterface;
@@ -56,6 +58,23 @@ namespace rai {
 
 //===========================================================================
 
+/// second-order kinematics of a d-dim quantity y(q), restricted to the m joint state entries it depends on:
+/// J(k,i) = dy_k/dq_dofs(i) and H(k,i,j) = d^2 y_k/dq_dofs(i)dq_dofs(j)
+struct HessianBlock {
+  uintA dofs; ///< indices into the joint state (may repeat, e.g. for mimic joints -- their entries add up)
+  arr y;      ///< d-vector
+  arr J;      ///< d x m
+  arr H;      ///< d x m x m
+
+  void resize(uint d, const uintA& _dofs); ///< zero y, J, H
+  void align(HessianBlock& b); ///< re-expresses this and b w.r.t. the common dofs this->dofs + b.dofs, so both can be combined entry-wise
+  /// Hq += sum_k w_k H(k,:,:), where Hq is the full (dense or sparse) n x n Hessian; if gaussNewtonWeights g are given, the
+  /// block plus J^T diag(g) J is first clipped to be positive semi-definite, so that adding it to a Gauss-Newton Hessian keeps it so
+  void addWeighted(arr& Hq, const arr& w, const arr& gaussNewtonWeights=NoArr) const;
+};
+
+//===========================================================================
+
 /// data structure to store a kinematic/physical situation (lists of frames (with joints, shapes, inertias), forces & proxies)
 struct Configuration : GLDrawer {
   unique_ptr<struct sConfiguration> self;
@@ -67,18 +86,31 @@ struct Configuration : GLDrawer {
   arr q;            ///< the current configuration state (DOF) vector
   arr qInactive;    ///< configuration state of all inactive DOFs
 
+  //-- frame poses, stored contiguously and indexed by Frame::ID (access via Frame::get_X/set_X/get_Q/set_Q)
+  Array<Transformation> frameQ; ///< relative transforms of all frames to their parents
+  Array<Transformation> frameX; ///< absolute poses of all frames (valid where the frame's _state_X_isGood)
+
   //-- data structure state (lazy evaluation leave the state structure out of sync)
   DofL activeDofs; //list of currently active dofs (computed with ensure_activeSets(); reset with reset_q())
   bool _state_indexedJoints_areGood=false; // the active sets, incl. their topological sorting, are up to date
   bool _state_q_isGood=false; // the q-vector represents the current relative transforms (and force dofs)
   bool _state_proxies_isGood=false; // the proxies have been created for the current state
+  std::atomic<bool> _state_X_pending={false}; // some frame was flagged dirty since the last fwd pass (ensure_X)
+  bool _state_fkOrder_isGood=false; // the cached topological order of the fwd pass matches the tree
+  uint fkThreads=0; ///< if >1, the fwd pass treats independent root subtrees in parallel (pays off for large multi-root trees only)
   //TODO: need a _state for all the plugin engines (SWIFT, PhysX)? To auto-reinitialize them when the config changed structurally?
 
   //-- format in which Jacobians are returned
   enum JacobianMode { JM_dense, JM_sparse, JM_rowShifted, JM_noArr, JM_emptyShape };
   JacobianMode jacMode = JM_dense;
 
-  static uint setJointStateCount;
+  static std::atomic<uint> setJointStateCount; //global counter (configurations may be used concurrently)
+
+  //-- memo of kinematicsPos/Vec/Quat queries, e.g. when many objectives query the same frames (enabled by KOMO for its path configuration)
+  bool useKinematicsMemo=false; ///< reuse the value and Jacobian of a query (primitive, frame ID, rel vector) until the state changes
+  uint _state_revision=0;       ///< incremented with every change of the joint state or frame poses; invalidates the memo
+  uint _geometry_revision=0;    ///< incremented when frames or shapes are added or removed, or meshes or contact flags change; invalidates collision caches
+  mutable uint kinematicsMemoQueries=0, kinematicsMemoHits=0;
 
   /// @name constructors
   Configuration();
@@ -126,6 +158,7 @@ struct Configuration : GLDrawer {
   arr getFrameState() const { return getFrameState(frames); } ///< same as getFrameState() for all \ref frames
   arr getFrameState(const FrameL& F) const;
   arr getFrameState(const uintA& F) const { return getFrameState(getFrames(F)); } ///< same as getFrameState() with getFrames()
+  arr batchForwardKinematics(const arr& Q, const uintA& frameIDs, arr& J=NoArr, int threads=-1); ///< poses (S x F x 7) of frames for each of the S joint states (rows of Q), optionally Jacobians (S x F x 7 x n); does not change the configuration; threads: 0 serial, -1 all hardware threads; Jacobians of other than 1-dof hinge/prismatic joints are computed per sample on a (per-thread) copy of the configuration, which is much slower
 
   /// @name set state
   void setJointState(const arr& _q);
@@ -161,6 +194,8 @@ struct Configuration : GLDrawer {
   /// @name structural operations, changes of configuration
   void clear();
   void reset_q();
+  void reset_frameNames(); ///< invalidate the hashed name index of getFrame (needed after renaming frames directly)
+  void update_frameName(Frame* f, const String& oldName); ///< update the hashed name index of getFrame after renaming f (called by Frame::setName)
   void reconfigureRoot(Frame* newRoot, bool ofLinkOnly);  ///< n becomes the root of the kinematic tree; joints accordingly reversed; lists resorted
   void flipFrames(Frame* a, Frame* b);
   void pruneRigidJoints();        ///< delete rigid joints -> they become just links
@@ -183,12 +218,15 @@ struct Configuration : GLDrawer {
   /// @name computations on the tree
   void calc_indexedActiveJoints(bool resetActiveJointSet=true); ///< sort of private: count the joint dimensionalities and assign j->q_index
   void calc_Q_from_q();  ///< from q compute the joint's Q transformations
+  void calc_fwdPass();   ///< one pass over the (cached) topological order: recompute X of all dirty frames and all frames below them
   void calcDofsFromConfig();  ///< updates q based on the joint's Q transformations
   arr calc_fwdPropagateVelocities(const arr& qdot);    ///< elementary forward kinematics
 
   /// @name ensure state consistencies
   void ensure_indexedJoints() {   if(!_state_indexedJoints_areGood) calc_indexedActiveJoints();  }
   void ensure_q() {  if(!_state_q_isGood) calcDofsFromConfig();  }
+  void ensure_X() {  if(_state_X_pending) ensure_X_locked();  } ///< forward kinematics of all dirty frames and their branches
+  void ensure_X_locked() const; ///< runs a pending fwd pass under a lock: concurrent readers (Frame::get_X/ensure_X, e.g. under evalThreads) trigger it once and wait for it
   void ensure_proxies() {  if(!_state_proxies_isGood) stepSwift();  }
 
   /// @name Jacobians and kinematics (low level)
@@ -205,7 +243,9 @@ struct Configuration : GLDrawer {
   void kinematicsMat(arr& y, arr& J, Frame* a) const;
   void kinematicsQuat(arr& y, arr& J, Frame* a) const;
   void kinematicsPos_wrtFrame(arr& y, arr& J, Frame* b, const Vector& rel, Frame* self) const;
-  void hessianPos(arr& H, Frame* a, Vector* rel=0) const;
+  void hessianPos(HessianBlock& y, Frame* a, const Vector& rel=NoVector) const; ///< position with Jacobian & Hessian w.r.t. the chain dofs of a
+  void hessianVec(HessianBlock& y, Frame* a, const Vector& vec) const;
+  void hessianQuat(HessianBlock& y, Frame* a) const;
   void kinematicsTau(double& tau, arr& J, Frame* a=0) const;
 
   void kinematicsPenetration(arr& y, arr& J, const Proxy& p, double margin=.0, bool addValues=false) const;
@@ -275,6 +315,22 @@ private:
 
 stdPipes(Configuration)
 
+}//namespace
+
+//===========================================================================
+//
+// Frame pose accessors (need both Frame and Configuration complete; inline for the fwd kinematics loops)
+//
+
+#include "frame.h"
+
+namespace rai {
+
+inline Transformation& Frame::Q() { return C.frameQ.p[ID]; }
+inline Transformation& Frame::X() { return C.frameX.p[ID]; }
+inline const Transformation& Frame::Q() const { return C.frameQ.p[ID]; }
+inline const Transformation& Frame::X() const { return C.frameX.p[ID]; }
+
 //===========================================================================
 //
 // OpenGL static draw functions
@@ -259,7 +259,7 @@ void pullPoses(FrameL& frames, const rai::Array<btCollisionObject*>& actors, con
         }
       }
     } else if(softbody){
-      rai::Mesh &m = f->shape->mesh();
+      rai::Mesh &m = f->shape->set_mesh();
       CHECK_EQ((int)m.V.d0, softbody->m_nodes.size(), "");
       for(int i=0; i<softbody->m_nodes.size(); i++){
         m.V[i] = conv_btVec3_arr(softbody->m_nodes[i].m_x);
@@ -645,7 +645,7 @@ btSoftBody* BulletInterface_self::addSoft(rai::Frame* f) {
   if(opt.verbose>0) LOG(0) <<"adding link anchored at '" <<f->name <<"' as " <<rai::Enum<rai::BodyType>(rai::BT_soft);
 
   //-- create a bullet collision shape
-  rai::Mesh& m = f->shape->mesh();
+  const rai::Mesh& m = f->shape->mesh();
 
   btSoftBody* softbody = btSoftBodyHelpers::CreateRope(softBodyWorldInfo,
                                                   conv_arr_btVec3(m.V[0]),
@@ -715,7 +715,7 @@ btCollisionShape* BulletInterface_self::createCollisionShape(rai::Shape* s) {
 //    } break;
     case rai::ST_mesh: {
 #ifdef BT_USE_DOUBLE_PRECISION
-      arr& V = s->mesh().V;
+      const arr& V = s->mesh().V;
 #else
       floatA V = convert<float>(s->mesh().V);
 #endif
@@ -828,7 +828,7 @@ void BulletBridge::getConfiguration(rai::Configuration& C){
     if(softbody){
       rai::Frame& f = C.addFrame(STRING("soft"<<i))
                       ->setShape(rai::ST_mesh, {});
-      rai::Mesh &m = f.shape->mesh();
+      rai::Mesh &m = f.shape->set_mesh();
       {
         m.V.resize(softbody->m_nodes.size(), 3);
         for(int i=0; i<softbody->m_nodes.size(); i++){
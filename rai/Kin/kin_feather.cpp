@@ -253,7 +253,7 @@ void F_Link::setFeatherstones() {
     case rai::JT_transX: _h.resize(6).setZero(); _h(3)=1.; break;
     case rai::JT_transY: _h.resize(6).setZero(); _h(4)=1.; break;
     case rai::JT_transZ: _h.resize(6).setZero(); _h(5)=1.; break;
-    default: NIY;
+    default: _h.clear(); //multi-dof joints are only handled by the ABA (see updateBodies)
   }
   Featherstone::RBmci(_I, mass, com.p(), inertia);
 
@@ -278,6 +278,7 @@ void FeatherstoneInterface::setGravity(double g) {
   for(rai::Frame* f: C.frames) {
     F_Link& link=tree(f->ID);
     link.force = link.mass * grav;
+    link.updateFeatherstones();
   }
 }
 
@@ -327,6 +328,96 @@ void FeatherstoneInterface::update() {
   }
 
   for(F_Link& link:tree) link.setFeatherstones();
+
+  updateBodies();
+}
+
+/// motion subspace axes for a string of axes: 'x','y','z' rotational, 'X','Y','Z' translational
+static uintA motionAxes(const char* axes) {
+  uintA S(strlen(axes));
+  for(uint k=0; k<S.N; k++) S(k) = (axes[k]>='x' ? axes[k]-'x' : 3+axes[k]-'X');
+  return S;
+}
+
+/// splits each joint into sub-joints with constant motion subspace (revolute, prismatic, or spherical)
+void FeatherstoneInterface::updateBodies() {
+  bodies.clear();
+  intA frameBody(tree.N);
+  frameBody = -1;
+
+  auto addBody = [this](int parent, const rai::Transformation& Q, const char* axes, int qIndex) {
+    F_Body& b = bodies.append();
+    b.parent = parent;
+    b.qIndex = qIndex;
+    b.axes = motionAxes(axes);
+    FrameToMatrix(b.Xup, Q);
+    return int(bodies.N-1);
+  };
+
+  auto addBall = [this, &addBody](int parent, const rai::Quaternion& rot, rai::Joint* j, uint qIndex) {
+    rai::Transformation Q=0;
+    Q.rot = rot;
+    int i = addBody(parent, Q, "xyz", qIndex);
+    F_Body& b = bodies(i);
+    b.quat = true;
+    b.rot[0]=rot.w;  b.rot[1]=rot.x;  b.rot[2]=rot.y;  b.rot[3]=rot.z;
+    b.qNorm = j->scale * length(C.q({qIndex, qIndex+3}));
+    return i;
+  };
+
+  C.ensure_q();
+  for(F_Link& link:tree) {
+    int parent = (link.parent==-1 ? -1 : frameBody(link.parent));
+    const rai::Transformation& Q = link.Q;
+    rai::Joint* j = C.frames(link.ID)->joint;
+    int i;
+    if(link.parent==-1 || !j || j->mimic || !j->active || j->type==rai::JT_rigid || j->type==rai::JT_tau) {
+      i = addBody(parent, Q, "", -1);
+    } else {
+      uint q0 = j->qIndex, first = bodies.N;
+      rai::Transformation Q1=0, Q2=0;
+      switch(j->type) {
+        case rai::JT_hingeX:  i = addBody(parent, Q, "x", q0);  break;
+        case rai::JT_hingeY:  i = addBody(parent, Q, "y", q0);  break;
+        case rai::JT_hingeZ:  i = addBody(parent, Q, "z", q0);  break;
+        case rai::JT_transX:  i = addBody(parent, Q, "X", q0);  break;
+        case rai::JT_transY:  i = addBody(parent, Q, "Y", q0);  break;
+        case rai::JT_transZ:  i = addBody(parent, Q, "Z", q0);  break;
+        case rai::JT_transXY: i = addBody(parent, Q, "XY", q0);  break;
+        case rai::JT_trans3:  i = addBody(parent, Q, "XYZ", q0);  break;
+        case rai::JT_quatBall: i = addBall(parent, Q.rot, j, q0);  break;
+        case rai::JT_universal:
+          Q1.rot.setRadX(j->scale*C.q(q0));
+          Q2.rot.setRadY(j->scale*C.q(q0+1));
+          i = addBody(addBody(parent, Q1, "x", q0), Q2, "y", q0+1);
+          break;
+        case rai::JT_transXYPhi:
+          Q1.pos = Q.pos;  Q2.rot = Q.rot;
+          i = addBody(addBody(parent, Q1, "XY", q0), Q2, "z", q0+2);
+          break;
+        case rai::JT_transYPhi:
+          Q1.pos = Q.pos;  Q2.rot = Q.rot;
+          i = addBody(addBody(parent, Q1, "Y", q0), Q2, "z", q0+1);
+          break;
+        case rai::JT_phiTransXY:
+          Q1.rot = Q.rot;  Q2.pos = Q.rot/Q.pos;
+          i = addBody(addBody(parent, Q1, "z", q0), Q2, "XY", q0+1);
+          break;
+        case rai::JT_XBall:
+          Q1.pos = Q.pos;
+          i = addBall(addBody(parent, Q1, "X", q0), Q.rot, j, q0+1);
+          break;
+        case rai::JT_free:
+          Q1.pos = Q.pos;
+          i = addBall(addBody(parent, Q1, "XYZ", q0), Q.rot, j, q0+3);
+          break;
+        default: NIY;
+      }
+      for(uint k=first; k<bodies.N; k++) bodies(k).scale = j->scale;
+    }
+    bodies(i).link = link.ID;
+    frameBody(link.ID) = i;
+  }
 }
 
 /*
@@ -680,75 +771,214 @@ void Featherstone::fwdDynamics_old(arr& qdd,
 
 //===========================================================================
 
-/* Articulated Body Dynamics - exactly as in my `simulationSoftware notes',
-   following the notation of Featherstone's recent short survey paper */
-void FeatherstoneInterface::fwdDynamics_aba_nD(arr& qdd,
-    const arr& qd,
-    const arr& tau) {
-  int par;
-  uint i, N=tree.N, d_i, n;
-  rai::Array<arr> h(N), qd_i(N), qdd_i(N), tau_i(N), I_h(N), h_I_h(N), u(N);
-  arr Xup(N, 6, 6), v(N, 6), dh_dq(N, 6), IA(N, 6, 6), fA(N, 6), a(N, 6);
-  qdd.resizeAs(tau);
+/// Hamilton product c = a*b of quaternions given as (w,x,y,z)
+static void quatMult(double* c, const double* a, const double* b) {
+  c[0] = a[0]*b[0] - a[1]*b[1] - a[2]*b[2] - a[3]*b[3];
+  c[1] = a[0]*b[1] + a[1]*b[0] + a[2]*b[3] - a[3]*b[2];
+  c[2] = a[0]*b[2] + a[2]*b[0] + a[3]*b[1] - a[1]*b[3];
+  c[3] = a[0]*b[3] + a[3]*b[0] + a[1]*b[2] - a[2]*b[1];
+}
 
-  for(i=0, n=0; i<N; i++) {
-    d_i=tree(i).dof();
-    if(d_i) {
-      qd_i(i) .referToRange(qd, n, n+d_i-1);
-      qdd_i(i).referToRange(qdd, n, n+d_i-1);
-      tau_i(i).referToRange(tau, n, n+d_i-1);
-    } else {
-      qd_i(i) .clear(); qd_i(i). resize(0);
-      qdd_i(i).clear(); qdd_i(i).resize(0);
-      tau_i(i).clear(); tau_i(i).resize(0);
+/// y = X x for a 6x6 matrix X
+static void mult6(double* y, const double* X, const double* x) {
+  for(uint r=0; r<6; r++) {
+    double s=0.;
+    for(uint k=0; k<6; k++) s += X[r*6+k]*x[k];
+    y[r] = s;
+  }
+}
+
+/// y += X^T x for a 6x6 matrix X
+static void addMultT6(double* y, const double* X, const double* x) {
+  for(uint k=0; k<6; k++) for(uint r=0; r<6; r++) y[r] += X[k*6+r]*x[k];
+}
+
+/// A += X^T B X for 6x6 matrices
+static void addCongruence6(double* A, const double* X, const double* B) {
+  double BX[36];
+  for(uint r=0; r<6; r++) for(uint c=0; c<6; c++) {
+      double s=0.;
+      for(uint k=0; k<6; k++) s += B[r*6+k]*X[k*6+c];
+      BX[r*6+c] = s;
     }
-    n += d_i;
-    h(i) = tree(i)._h;
-    h(i).reshape(6, d_i);
-    Xup[i] = tree(i)._Q; //the transformation from the i-th to the j-th
+  for(uint r=0; r<6; r++) for(uint c=0; c<6; c++) {
+      double s=0.;
+      for(uint k=0; k<6; k++) s += X[k*6+r]*BX[k*6+c];
+      A[r*6+c] += s;
+    }
+}
+
+/// y = v x m for spatial motion vectors (angular; linear), same as crossM(v)*m
+static void crossMotion(double* y, const double* v, const double* m) {
+  y[0] = v[1]*m[2] - v[2]*m[1];
+  y[1] = v[2]*m[0] - v[0]*m[2];
+  y[2] = v[0]*m[1] - v[1]*m[0];
+  y[3] = v[1]*m[5] - v[2]*m[4] + v[4]*m[2] - v[5]*m[1];
+  y[4] = v[2]*m[3] - v[0]*m[5] + v[5]*m[0] - v[3]*m[2];
+  y[5] = v[0]*m[4] - v[1]*m[3] + v[3]*m[1] - v[4]*m[0];
+}
+
+/// y = v x* f for a spatial motion vector v and force f (moment; force), same as crossF(v)*f
+static void crossForce(double* y, const double* v, const double* f) {
+  y[0] = v[1]*f[2] - v[2]*f[1] + v[4]*f[5] - v[5]*f[4];
+  y[1] = v[2]*f[0] - v[0]*f[2] + v[5]*f[3] - v[3]*f[5];
+  y[2] = v[0]*f[1] - v[1]*f[0] + v[3]*f[4] - v[4]*f[3];
+  y[3] = v[1]*f[5] - v[2]*f[4];
+  y[4] = v[2]*f[3] - v[0]*f[5];
+  y[5] = v[0]*f[4] - v[1]*f[3];
+}
+
+/// sub-joint velocity: scaled joint velocity, or the body angular velocity w = 2 Im(q^* dq)/|q| for quaternion coordinates
+static void F_jointVelocity(double* dq, const F_Body& b, const arr& qd) {
+  const double* qdp = qd.p+b.qIndex;
+  if(!b.quat) {
+    for(uint k=0; k<b.dof(); k++) dq[k] = b.scale*qdp[k];
+    return;
   }
-  CHECK(n==qd.N && n==qdd.N && n==tau.N, "")
+  double qc[4] = {b.rot[0], -b.rot[1], -b.rot[2], -b.rot[3]}, dq4[4], w[4];
+  for(uint k=0; k<4; k++) dq4[k] = b.scale*qdp[k];
+  quatMult(w, qc, dq4);
+  for(uint k=0; k<3; k++) dq[k] = 2.*w[k+1]/b.qNorm;
+}
 
-  for(i=0; i<N; i++) {
-    par = tree(i).parent;
-    if(par == -1) {
-      v[i] = h(i) * qd_i(i);
-      dh_dq[i] = 0.;
-    } else {
-      v[i] = Xup[i] * v[par] + h(i) * qd_i(i);
-      dh_dq[i] = Featherstone::crossM(v[i]) * h(i) * qd_i(i);
+/// sub-joint force: the transpose of the velocity map applied to the generalized forces
+static void F_jointForce(double* u, const F_Body& b, const arr& tau) {
+  const double* taup = tau.p+b.qIndex;
+  if(!b.quat) {
+    for(uint k=0; k<b.dof(); k++) u[k] = taup[k]/b.scale;
+    return;
+  }
+  double qc[4] = {b.rot[0], -b.rot[1], -b.rot[2], -b.rot[3]}, t[4];
+  quatMult(t, qc, taup);
+  for(uint k=0; k<3; k++) u[k] = .5*b.qNorm*t[k+1]/b.scale;
+}
+
+/** maps the sub-joint acceleration back to joint coordinates; for quaternions q = |q| qn with
+    dq = rho qn + |q|/2 qn*(0,w) this is ddq = qn*(0, rho w + |q|/2 dw) - |q|/4 |w|^2 qn (no radial acceleration) */
+static void F_setJointAcceleration(arr& qdd, const F_Body& b, const arr& qd, const double* dq, const double* ddq) {
+  double* qddp = qdd.p+b.qIndex;
+  if(!b.quat) {
+    for(uint k=0; k<b.dof(); k++) qddp[k] = ddq[k]/b.scale;
+    return;
+  }
+  const double* qdp = qd.p+b.qIndex;
+  double rho = 0.;
+  for(uint k=0; k<4; k++) rho += b.scale*b.rot[k]*qdp[k];
+  double dw[4], a[4];
+  dw[0] = 0.;
+  for(uint k=0; k<3; k++) dw[k+1] = rho*dq[k] + .5*b.qNorm*ddq[k];
+  quatMult(a, b.rot, dw);
+  double ww = dq[0]*dq[0] + dq[1]*dq[1] + dq[2]*dq[2];
+  for(uint k=0; k<4; k++) qddp[k] = (a[k] - .25*b.qNorm*ww*b.rot[k])/b.scale;
+}
+
+/* Articulated Body Algorithm (Featherstone, Rigid Body Dynamics Algorithms, Table 7.1) on the
+   sub-joint bodies of updateBodies(); O(n) and applicable to all joint types. Roots are fixed,
+   gravity enters via the link forces (setGravity). Coordinates of tau joints (which carry no body)
+   are unit-mass integrators, as in equationOfMotion. As the motion subspaces are spanned by unit
+   axes, S^T X and X S are row/column selections */
+void FeatherstoneInterface::fwdDynamics_aba(arr& qdd,
+    const arr& qd,
+    const arr& tau) {
+  uint N=bodies.N;
+  CHECK_EQ(qd.N, tau.N, "");
+  arr v(N, 6), c(N, 6), IA(N, 6, 6), pA(N, 6), a(N, 6), dq(N, 3), U(N, 6, 3), Dinv(N, 3, 3), u(N, 3);
+  double vJ[6], Iv[6], Ia[36], pa[6], W[18], Du[3], ddq[3];
+  v.setZero();
+  c.setZero();
+  IA.setZero();
+  pA.setZero();
+  a.setZero();
+  qdd = tau;
+
+  //fwd: body velocities v, velocity-product accelerations c, and bias forces pA
+  for(uint i=0; i<N; i++) {
+    F_Body& b = bodies(i);
+    uint d = b.dof();
+    double* v_i = &v(i, 0);
+    if(b.parent!=-1) mult6(v_i, b.Xup.p, &v(b.parent, 0));
+    if(d) {
+      F_jointVelocity(&dq(i, 0), b, qd);
+      for(uint k=0; k<6; k++) vJ[k] = 0.;
+      for(uint k=0; k<d; k++) vJ[b.axes(k)] = dq(i, k);
+      for(uint k=0; k<6; k++) v_i[k] += vJ[k];
+      crossMotion(&c(i, 0), v_i, vJ);
+    }
+    if(b.link!=-1) {
+      F_Link& link = tree(b.link);
+      double* pA_i = &pA(i, 0);
+      memmove(&IA(i, 0, 0), link._I.p, 36*sizeof(double));
+      mult6(Iv, link._I.p, v_i);
+      crossForce(pA_i, v_i, Iv);
+      for(uint k=0; k<6; k++) pA_i[k] -= link._f.elem(k);
     }
-    IA[i] = tree(i)._I;
-    fA[i] = Featherstone::crossF(v[i]) * tree(i)._I * v[i] - tree(i)._f;
   }
 
-  for(i=N; i--;) {
-    par = tree(i).parent;
-    I_h(i) = IA[i] * h(i);
-    if(tree(i).dof()) {
-      h_I_h(i) = ~h(i)*I_h(i);
-      u(i) = tau_i(i) - ~I_h(i)*dh_dq[i] - ~h(i)*fA[i];
-    } else {
-      h_I_h(i).clear(); h_I_h(i).resize(0);
-      u(i).clear(); u(i).resize(0);
+  //bwd: articulated-body inertias IA and bias forces pA
+  for(uint i=N; i--;) {
+    F_Body& b = bodies(i);
+    uint d = b.dof();
+    double *U_i = &U(i, 0, 0), *D_i = &Dinv(i, 0, 0), *u_i = &u(i, 0), *c_i = &c(i, 0);
+    memmove(Ia, &IA(i, 0, 0), 36*sizeof(double));
+    memmove(pa, &pA(i, 0), 6*sizeof(double));
+    if(d) {
+      //U = IA S,  Dinv = (S^T IA S)^-1,  u = tau - S^T pA
+      for(uint r=0; r<6; r++) for(uint k=0; k<d; k++) U_i[r*3+k] = Ia[r*6+b.axes(k)];
+      if(d==1) {
+        D_i[0] = 1./U_i[b.axes(0)*3];
+      } else {
+        arr D(d, d);
+        for(uint k=0; k<d; k++) for(uint l=0; l<d; l++) D(k, l) = U_i[b.axes(k)*3+l];
+        D = inverse_SymPosDef(D);
+        for(uint k=0; k<d; k++) for(uint l=0; l<d; l++) D_i[k*3+l] = D(k, l);
+      }
+      F_jointForce(u_i, b, tau);
+      for(uint k=0; k<d; k++) u_i[k] -= pa[b.axes(k)];
+
+      //Ia = IA - U Dinv U^T,  pa = pA + Ia c + U Dinv u
+      for(uint k=0; k<d; k++) {
+        Du[k] = 0.;
+        for(uint l=0; l<d; l++) Du[k] += D_i[k*3+l]*u_i[l];
+        for(uint s=0; s<6; s++) {
+          W[k*6+s] = 0.;
+          for(uint l=0; l<d; l++) W[k*6+s] += D_i[k*3+l]*U_i[s*3+l];
+        }
+      }
+      for(uint r=0; r<6; r++) for(uint s=0; s<6; s++) for(uint k=0; k<d; k++) Ia[r*6+s] -= U_i[r*3+k]*W[k*6+s];
+      for(uint r=0; r<6; r++) {
+        for(uint s=0; s<6; s++) pa[r] += Ia[r*6+s]*c_i[s];
+        for(uint k=0; k<d; k++) pa[r] += U_i[r*3+k]*Du[k];
+      }
     }
-    if(par != -1) {
-      IA[par]() += ~Xup[i] * (IA[i] - I_h(i)*inverse(h_I_h(i))*~I_h(i)) * Xup[i];
-      fA[par]() += ~Xup[i] * (fA[i] + IA[i]*dh_dq[i] + I_h(i)*inverse(h_I_h(i))*u(i));
+    if(b.parent!=-1) {
+      addCongruence6(&IA(b.parent, 0, 0), b.Xup.p, Ia);
+      addMultT6(&pA(b.parent, 0), b.Xup.p, pa);
     }
   }
 
-  for(i=0; i<N; i++) {
-    par=tree(i).parent;
-    if(par == -1) {
-      a[i] = 0; //Xup[i] * grav_accn;
-    } else {
-      a[i]() = Xup[i] * a[par];
+  //fwd: accelerations
+  for(uint i=0; i<N; i++) {
+    F_Body& b = bodies(i);
+    uint d = b.dof();
+    double* a_i = &a(i, 0);
+    if(b.parent!=-1) {
+      mult6(a_i, b.Xup.p, &a(b.parent, 0));
+      for(uint k=0; k<6; k++) a_i[k] += c(i, k);
     }
-    if(tree(i).dof()) {
-      qdd_i(i) = inverse(h_I_h(i))*(u(i) - ~I_h(i)*a[i]);
+    if(d) {
+      //ddq = Dinv (u - U^T a)
+      double *U_i = &U(i, 0, 0), *D_i = &Dinv(i, 0, 0), r[3];
+      for(uint k=0; k<d; k++) {
+        r[k] = u(i, k);
+        for(uint s=0; s<6; s++) r[k] -= U_i[s*3+k]*a_i[s];
+      }
+      for(uint k=0; k<d; k++) {
+        ddq[k] = 0.;
+        for(uint l=0; l<d; l++) ddq[k] += D_i[k*3+l]*r[l];
+      }
+      for(uint k=0; k<d; k++) a_i[b.axes(k)] += ddq[k];
+      F_setJointAcceleration(qdd, b, qd, &dq(i, 0), ddq);
     }
-    a[i] = a[i] + dh_dq[i] + h(i)*qdd_i(i);
   }
 }
 
@@ -929,6 +1159,7 @@ void FeatherstoneInterface::equationOfMotion(arr& H, arr& C,
     par = tree(i).parent;
     Xup[i]() = tree(i)._Q; //the transformation from the i-th to the j-th
     if(par!=-1) {
+      CHECK(iq==-1 || tree(i)._h.N==6, "equationOfMotion only handles 1-dof joints -- use fwdDynamics_aba");
       h[i]() = tree(i)._h;
       if(iq!=-1) {//is not a fixed joint
         vJ = h[i] * qd(iq); //equation (2), vJ = relative vel across joint i
@@ -38,21 +38,41 @@ stdOutPipe(F_Link)
 
 typedef rai::Array<F_Link> F_LinkTree;
 
+/// a body of the articulated-body recursion: multi-dof joints are split into chains of sub-joints
+/// with constant motion subspace (in body coordinates); the intermediate sub-bodies are massless
+struct F_Body {
+  int parent=-1;   ///< parent body (-1 for roots)
+  int link=-1;     ///< tree link whose inertia and force this body carries (-1 for massless sub-bodies)
+  int qIndex=-1;   ///< first coordinate of this sub-joint in q (-1 if fixed)
+  double scale=1.; ///< joint scale: physical coordinates are scale*q
+  bool quat=false; ///< spherical sub-joint in quaternion coordinates (4 coordinates, 3 dofs)
+  double qNorm=1.; ///< for quat: norm of the (scaled) quaternion coordinates
+  double rot[4]={1., 0., 0., 0.}; ///< for quat: the normalized rotation (w,x,y,z)
+  uintA axes;      ///< spatial unit axes spanning the motion subspace (0-2 rotational, 3-5 translational)
+  arr Xup;         ///< 6x6 motion transform parent->body
+
+  uint dof() const { return axes.N; }
+};
+
 struct FeatherstoneInterface {
   rai::Configuration& C;
 
   FrameL sortedFrames;
 
   rai::Array<F_Link> tree;
+  rai::Array<F_Body> bodies;
+
+  RAI_PARAM("Featherstone/", bool, useABA, true) ///< fwdDynamics via the O(n) ABA (otherwise via inverting the mass matrix)
 
   FeatherstoneInterface(rai::Configuration& C):C(C) { sortedFrames = C.calc_topSort(); }
 
   void setGravity(double g=-9.81);
   void update();
+  void updateBodies();
 
   void equationOfMotion(arr& M, arr& F,  const arr& qd);
   void fwdDynamics_MF(arr& qdd, const arr& qd, const arr& u);
-  void fwdDynamics_aba_nD(arr& qdd, const arr& qd, const arr& tau);
+  void fwdDynamics_aba(arr& qdd, const arr& qd, const arr& tau);
   void fwdDynamics_aba_1D(arr& qdd, const arr& qd, const arr& tau);
   void invDynamics(arr& tau, const arr& qd, const arr& qdd);
 };
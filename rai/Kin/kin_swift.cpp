@@ -82,7 +82,7 @@ SwiftInterface::SwiftInterface(const FrameL& frames, double _cutoff, int verbose
           s->createMeshes();
           CHECK(s->mesh().V.d0, "the mesh must have been created earlier -- has size zero!");
         }
-        rai::Mesh* mesh = &s->mesh();
+        const rai::Mesh* mesh = &s->mesh();
 //      if(s->sscCore().V.d0) mesh = &s->sscCore();
 
         CHECK(mesh->V.d0, "no mesh to add to SWIFT, something was wrongly initialized");
@@ -297,22 +297,22 @@ uintA SwiftInterface::pullFromSwift(bool dumpReport) {
     if(num_contacts[i]>0) { //only add one proxy!for(j=0; j<num_contacts[i]; j++, k++) {
       CHECK_EQ(num_contacts[i], 1, "");
       if(proxy.d < 1e-10) {
-        proxy.posA = proxy.a->X.pos;
-        proxy.posB = proxy.b->X.pos;
+        proxy.posA = proxy.a->X().pos;
+        proxy.posB = proxy.b->X().pos;
         proxy.normal = proxy.posA - proxy.posB; //normal always points from b to a
         if(!proxy.normal.isZero) proxy.normal.normalize();
       } else {
         proxy.normal.set(&normals[3*k+0]);
         proxy.normal.normalize();
         //swift returns nearest points in the local frame -> transform them
-        proxy.posA.set(&nearest_pts[6*k+0]);  proxy.posA = proxy.a->X * proxy.posA;
-        proxy.posB.set(&nearest_pts[6*k+3]);  proxy.posB = proxy.b->X * proxy.posB;
+        proxy.posA.set(&nearest_pts[6*k+0]);  proxy.posA = proxy.a->X() * proxy.posA;
+        proxy.posB.set(&nearest_pts[6*k+3]);  proxy.posB = proxy.b->X() * proxy.posB;
       }
       k += num_contacts[i];
     } else if(num_contacts[i]==-1) { //penetrating pair of objects
       proxy.d = -.0;
-      proxy.posA = proxy.a->X.pos;
-      proxy.posB = proxy.b->X.pos;
+      proxy.posA = proxy.a->X().pos;
+      proxy.posB = proxy.b->X().pos;
       proxy.normal = proxy.posA - proxy.posB; //normal always points from b to a
       if(!proxy.normal.isZero) proxy.normal.normalize();
       k++;
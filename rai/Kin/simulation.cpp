@@ -16,6 +16,7 @@
 #include "F_collisions.h"
 #include "../Gui/opengl.h"
 #include "../Algo/SplineCtrlFeed.h"
+#include "../Core/thread.h"
 
 //#define BACK_BRIDGE
 
@@ -24,6 +25,7 @@ namespace rai {
 //===========================================================================
 
 struct Simulation_self {
+  arr u, q; //control and joint state buffers of step (reused to not allocate per step)
   arr qdot;
   arr frameVelocities;
   std::shared_ptr<struct Simulation_DisplayThread> display;
@@ -142,7 +144,8 @@ void Simulation::step(const arr& u_control, double tau, ControlMode u_mode) {
     if(imps.elem(i)->killMe) imps.remove(i);
   }
 
-  arr ucontrol = u_control; //a copy to allow for perturbations
+  arr& ucontrol = self->u;
+  ucontrol = u_control; //a copy to allow for perturbations
 
   //-- imps before control
   for(ptr<SimulationImp>& imp : imps) if(imp->when==SimulationImp::_beforeControl) {
@@ -155,11 +158,14 @@ void Simulation::step(const arr& u_control, double tau, ControlMode u_mode) {
   } else if(u_mode==_position) {
     C.setJointState(ucontrol);
   } else if(u_mode==_velocity) {
-    arr q = C.getJointState();
-    q += tau * ucontrol;
+    arr& q = self->q;
+    q = C.getJointState();
+    CHECK_EQ(ucontrol.N, q.N, "");
+    for(uint i=0; i<q.N; i++) q.p[i] += tau * ucontrol.p[i];
     C.setJointState(q);
   } else if(u_mode==_spline) {
-    arr q = C.getJointState();
+    arr& q = self->q;
+    q = C.getJointState();
     self->ref.getReference(q, NoArr, NoArr, q, NoArr, time);
     C.setJointState(q);
   } else NIY;
@@ -438,6 +444,67 @@ void Simulation::getImageAndDepth(byteA& image, floatA& depth) {
   if(verbose>0) self->updateDisplayData(image, depth);
 }
 
+//===========================================================================
+
+SimulationBatch::SimulationBatch(const Configuration& C, uint N, Simulation::SimulatorEngine engine, int threads) {
+  CHECK(engine==Simulation::_kinematic || engine==Simulation::_bullet, "only engines with independent worlds can be batched");
+  configurations.resize(N);
+  sims.resize(N);
+  for(uint i=0; i<N; i++) {
+    configurations(i) = make_shared<Configuration>(C);
+    sims(i) = make_shared<Simulation>(*configurations(i), engine, 0);
+  }
+  if(engine!=Simulation::_kinematic) threads=1; //see header: only the kinematic engine is thread-safe
+  pool = make_shared<ThreadPool>(threads>0 ? threads : 0);
+}
+
+SimulationBatch::~SimulationBatch() {
+  sims.clear(); //before their configurations
+}
+
+void SimulationBatch::step(const arr& U, double tau, Simulation::ControlMode u_mode) {
+  if(U.N) CHECK_EQ(U.d0, sims.N, "U needs one row of controls per simulation");
+  stepU=&U;  stepTau=tau;  stepMode=u_mode;
+  //the job only captures 'this': std::function stores it without allocating
+  pool->parallelFor(sims.N, [this](uint i, uint) {
+    if(stepU->N) sims.elem(i)->step((*stepU)[i], stepTau, stepMode);
+    else sims.elem(i)->step({}, stepTau, stepMode);
+  });
+  stepU=nullptr;
+}
+
+const arr& SimulationBatch::get_q() {
+  uint n = sims.N ? configurations.first()->getJointStateDimension() : 0;
+  q.resize(sims.N, n);
+  pool->parallelFor(sims.N, [this](uint i, uint) {
+    const arr& qi = sims.elem(i)->get_q();
+    CHECK_EQ(qi.N, q.d1, "simulations have different joint state dimensions");
+    memmove(q.p+i*q.d1, qi.p, qi.N*q.sizeT);
+  });
+  return q;
+}
+
+void SimulationBatch::getImageAndDepth(byteA& _images, floatA& _depths) {
+  images.resize(sims.N);
+  depths.resize(sims.N);
+  for(uint i=0; i<sims.N; i++) sims.elem(i)->getImageAndDepth(images.elem(i), depths.elem(i));
+  if(!sims.N) { _images.clear(); _depths.clear(); return; }
+
+  uint dim[4] = {sims.N, images.first().d0, images.first().d1, images.first().d2};
+  _images.resize(4, dim);
+  _depths.resize(3, dim);
+  for(uint i=0; i<sims.N; i++) {
+    CHECK_EQ(images(i).N*sims.N, _images.N, "simulations render different image sizes");
+    CHECK_EQ(depths(i).N*sims.N, _depths.N, "simulations render different image sizes");
+    memmove(_images.p+i*images(i).N, images(i).p, images(i).N*_images.sizeT);
+    memmove(_depths.p+i*depths(i).N, depths(i).p, depths(i).N*_depths.sizeT);
+  }
+}
+
+void SimulationBatch::addSensor(const char* sensorName, const char* frameAttached, uint width, uint height, double focalLength, double orthoAbsHeight, const arr& zRange) {
+  for(ptr<Simulation>& S:sims) S->addSensor(sensorName, frameAttached, width, height, focalLength, orthoAbsHeight, zRange);
+}
+
 //===========================================================================
 //added-------------------------
 struct MoveBallHereCallback:OpenGL::GLClickCall {
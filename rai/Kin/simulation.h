@@ -11,6 +11,8 @@
 #include "kin.h"
 #include "cameraview.h"
 
+struct ThreadPool;
+
 namespace rai {
 
 struct SimulationState;
@@ -93,4 +95,42 @@ struct Simulation {
 
 };
 
+//===========================================================================
+
+/// N independent simulations, each of its own copy of the same configuration, stepped in lockstep across a worker pool
+/// (e.g. for many randomized trials); outputs are stacked along the first dimension. After the first step, stepping
+/// allocates nothing
+struct SimulationBatch {
+  Array<ptr<Configuration>> configurations;
+  Array<ptr<Simulation>> sims;
+
+  /// only the _kinematic and _bullet engines (one independent world per simulation); threads=0: as many as hardware threads.
+  /// Only _kinematic simulations step in parallel: _bullet worlds are stepped one after the other, as bullet is not established
+  /// as thread-safe across worlds (its collision dispatch has global state)
+  SimulationBatch(const Configuration& C, uint N, Simulation::SimulatorEngine engine, int threads=0);
+  ~SimulationBatch();
+
+  uint N() const { return sims.N; }
+  Simulation& operator()(uint i) { return *sims(i); } ///< the i-th simulation, e.g. to randomize its state
+  Configuration& C(uint i) { return *configurations(i); }
+
+  //-- step all simulations: row i of U (N x n) is the control of simulation i; an empty U sends no control (e.g. for _spline)
+  void step(const arr& U={}, double tau=.01, Simulation::ControlMode u_mode=Simulation::_velocity);
+
+  //-- stacked state and sensor information
+  const arr& get_q(); ///< N x n joint states
+  void getImageAndDepth(byteA& images, floatA& depths); ///< N x H x W x 3 images and N x H x W depths (rendering is serialized: it needs the GL context)
+  void addSensor(const char* sensorName, const char* frameAttached=nullptr, uint width=640, uint height=360, double focalLength=-1., double orthoAbsHeight=-1., const arr& zRange= {}); ///< the same sensor in all simulations
+
+ private:
+  shared_ptr<ThreadPool> pool;
+  //buffers reused across steps
+  arr q;
+  Array<byteA> images;
+  Array<floatA> depths;
+  const arr* stepU=nullptr;
+  double stepTau=0.;
+  Simulation::ControlMode stepMode=Simulation::_none;
+};
+
 }
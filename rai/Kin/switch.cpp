@@ -161,20 +161,20 @@ rai::Frame* rai::KinematicSwitch::apply(FrameL& frames) const {
 
     //initialize to zero, copy, or random
     if(init==SWInit_zero) { //initialize the joint with zero transform
-      to->Q.setZero();
+      to->Q().setZero();
     } else if(init==SWInit_copy) { //set Q to the current relative transform, modulo DOFs
-      to->Q = orgX / to->parent->ensure_X(); //that's important for the initialization of x during the very first komo.setupConfigurations !!
+      to->Q() = orgX / to->parent->ensure_X(); //that's important for the initialization of x during the very first komo.setupConfigurations !!
       //cout <<to->Q <<' ' <<to->Q.rot.normalization() <<endl;
       if(to->joint->dim>0) {
         arr q = to->joint->calcDofsFromConfig();
-        to->Q.setZero();
+        to->Q().setZero();
         to->joint->setDofs(q, 0);
       }
     } if(init==SWInit_random) { //random, modulo DOFs
-      to->Q.setRandom();
+      to->Q().setRandom();
       if(to->joint->dim>0) {
         arr q = to->joint->calcDofsFromConfig();
-        to->Q.setZero();
+        to->Q().setZero();
         to->joint->setDofs(q, 0);
       }
     }
@@ -144,6 +144,13 @@ bool getEqualFactInKB(Graph& KB, Node* fact, bool checkAlsoValue) {
   for(uint p=1; p<fact->parents.N; p++)
     candidates = setSection(candidates, fact->parents(p)->children);
 #else
+  //with a hash index, only facts with the same first symbol are candidates
+  if(KB.hashIndex && fact->parents(0)->key!="ANY") {
+    for(Node* fact1:KB.findNodesWithFirstParent(fact->parents(0))) if(fact1!=fact) {
+        if(factsAreEqual(fact, fact1, checkAlsoValue)) return true;
+      }
+    return false;
+  }
   NodeL& candidates = KB;
 #endif
   //now check only these candidates
@@ -181,6 +188,17 @@ bool getEqualFactInKB(Graph& KB, Node* literal, const NodeL& subst, const Graph*
   NodeL candidates = literal->parents(0)->children;
   NodeL candidates = getLiteralsOfScope(KB);
 #else
+  //with a hash index, only facts with the same (substituted) first symbol are candidates
+  if(KB.hashIndex && literal->parents.N) {
+    Node* first = literal->parents(0);
+    if(&first->container==subst_scope) first = subst(first->index);
+    if(first && first->key!="ANY") {
+      for(Node* fact:KB.findNodesWithFirstParent(first)) if(fact!=literal) {
+          if(factsAreEqual(fact, literal, subst, subst_scope, checkAlsoValue)) return true;
+        }
+      return false;
+    }
+  }
   NodeL& candidates = KB;
 #endif
   for(Node* fact:candidates) if(&fact->container==&KB && fact!=literal) {
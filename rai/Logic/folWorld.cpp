@@ -130,11 +130,9 @@ TreeSearchDomain::TransitionReturn FOL_World::transition(const Handle& action) {
   if(!d->waitDecision) {
     NodeL decisionTuple = {d->rule};
     decisionTuple.append(d->substitution);
-    lastDecisionInState = createNewFact(*state, decisionTuple);
-    lastDecisionInState->key = ("decision");
+    lastDecisionInState = state->newNode<bool>("decision", decisionTuple, true);
   } else {
-    lastDecisionInState = createNewFact(*state, {Wait_keyword});
-    lastDecisionInState->key = ("decision");
+    lastDecisionInState = state->newNode<bool>("decision", {Wait_keyword}, true);
   }
 
   //-- apply effects of decision
@@ -384,7 +382,10 @@ void FOL_World::setState(Graph* s, int setT_step) {
   if(state) {
     CHECK(s->isNodeOfGraph != state->isNodeOfGraph, "you are setting the state to itself");
   }
-  if(!state) state = &KB.newSubgraph({"STATE"}, {s->isNodeOfGraph});
+  if(!state) {
+    state = &KB.newSubgraph({"STATE"}, {s->isNodeOfGraph});
+    state->useHashIndex();
+  }
   state->copy(*s);
   DEBUG(KB.checkConsistency();) {
     //the old state hat a parent: its predecessor; this was copied to the new state
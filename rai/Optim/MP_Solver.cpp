@@ -8,11 +8,14 @@
 #include "opt-ceres.h"
 #include "MathematicalProgram.h"
 #include "constrained.h"
+#include "interiorPoint.h"
+
+#include "../Core/thread.h"
 
 template<> const char* rai::Enum<MP_SolverID>::names []= {
   "gradientDescent", "rprop", "LBFGS", "newton",
   "augmentedLag", "squaredPenalty", "logBarrier", "singleSquaredPenalty",
-  "NLopt", "Ipopt", "Ceres", nullptr
+  "NLopt", "Ipopt", "Ceres", "interiorPoint", nullptr
 };
 
 template<> const char* rai::Enum<NLopt_SolverOption>::names []= {
@@ -29,18 +32,27 @@ template<> const char* rai::Enum<NLopt_SolverOption>::names []= {
     "LD_TNEWTON_PRECOND_RESTART", nullptr };
 
 shared_ptr<SolverReturn> MP_Solver::solve(int resampleInitialization){
-  auto ret = make_shared<SolverReturn>();
-  shared_ptr<OptConstrained> optCon;
-  double time = -rai::cpuTime();
+  if(multiStarts>1) return solveMultiStart();
 
   if(resampleInitialization==1 || !x.N){
     x = P->getInitializationSample();
   }else{
     CHECK(x.N, "x is of zero dimensionality - needs initialization");
   }
+  return solveFrom(P, x, dual);
+}
+
+shared_ptr<SolverReturn> MP_Solver::solveFrom(const shared_ptr<MP_Traced>& P, arr& x, arr& dual, const std::atomic<bool>* cancel){
+  auto ret = make_shared<SolverReturn>();
+  shared_ptr<OptConstrained> optCon;
+  rai::OptOptions opt = this->opt;
+  rai::ArrayArena arena; //keeps the recycled array buffers across all evaluations of this solve (on this thread)
+  double time = -rai::realTime(); //wall time: solves may run concurrently (solveMultiStart), where cpuTime would sum over all threads
+
   if(solverID==MPS_newton){
     Conv_MathematicalProgram_ScalarProblem P1(P);
     OptNewton newton(x, P1, opt);
+    if(opt.newtonCG) newton.hessianFactors = P1.hessianFactors = make_shared<FactoredHessian>();
     newton.run();
     ret->f = newton.fx;
   }
@@ -55,16 +67,19 @@ shared_ptr<SolverReturn> MP_Solver::solve(int resampleInitialization){
   else if(solverID==MPS_augmentedLag){
     opt.set_constrainedMethod(rai::augmentedLag);
     optCon = make_shared<OptConstrained>(x, dual, P, opt);
+    optCon->cancel = cancel;
     optCon->run();
   }
   else if(solverID==MPS_squaredPenalty){
     opt.set_constrainedMethod(rai::squaredPenalty);
     optCon = make_shared<OptConstrained>(x, dual, P, opt);
+    optCon->cancel = cancel;
     optCon->run();
   }
   else if(solverID==MPS_logBarrier){
     opt.set_constrainedMethod(rai::logBarrier);
     optCon = make_shared<OptConstrained>(x, dual, P, opt);
+    optCon->cancel = cancel;
     optCon->run();
   }
   else if(solverID==MPS_NLopt){
@@ -80,6 +95,9 @@ shared_ptr<SolverReturn> MP_Solver::solve(int resampleInitialization){
     CeresInterface nlo(P1);
     x = nlo.solve();
   }
+  else if(solverID==MPS_interiorPoint){
+    OptInteriorPoint(x, dual, P, opt).run();
+  }
   else HALT("solver wrapper not implemented yet for solver ID '" <<rai::Enum<MP_SolverID>(solverID) <<"'");
 
   if(optCon){
@@ -87,14 +105,71 @@ shared_ptr<SolverReturn> MP_Solver::solve(int resampleInitialization){
       ret->eq = optCon->L.get_sumOfHviolations();
       ret->sos = optCon->L.get_cost_sos();
       ret->f = optCon->L.get_cost_f();
+  }else{ //evaluate the returned x (untraced)
+    arr phi;
+    P->P->evaluate(phi, NoArr, x);
+    ret->sos = ret->f = ret->ineq = ret->eq = 0.;
+    for(uint i=0; i<phi.N; i++) {
+      ObjectiveType ot = P->featureTypes.p[i];
+      if(ot==OT_f) ret->f += phi.p[i];
+      if(ot==OT_sos) ret->sos += rai::sqr(phi.p[i]);
+      if((ot==OT_ineq || ot==OT_ineqB) && phi.p[i]>0.) ret->ineq += phi.p[i];
+      if(ot==OT_eq) ret->eq += fabs(phi.p[i]);
+    }
   }
+  ret->feasible = (ret->ineq+ret->eq <= feasibilityTolerance);
 
   //checkJacobianCP(*P, x, 1e-4);
 
-  time += rai::cpuTime();
+  time += rai::realTime();
   ret->x=x;
   ret->dual=dual;
   ret->evals=P->evals;
   ret->time = time;
   return ret;
 }
+
+shared_ptr<SolverReturn> MP_Solver::solveMultiStart(){
+  uint threads = multiStartThreads>0 ? multiStartThreads : std::thread::hardware_concurrency();
+  if(threads>multiStarts) threads=multiStarts;
+  ThreadPool pool(threads ? threads : 1);
+
+  //-- one problem per worker: the original for worker 0, clones for all others
+  rai::Array<shared_ptr<MP_Traced>> problems(pool.size());
+  problems(0) = P;
+  for(uint w=1; w<problems.N; w++) {
+    shared_ptr<MathematicalProgram> Q = P->P->clone();
+    CHECK(Q, "parallel multi-start solving needs a problem that implements MathematicalProgram::clone");
+    problems(w) = make_shared<MP_Traced>(Q);
+  }
+
+  //-- initializations are sampled serially (samplers are not reentrant)
+  arrA x0(multiStarts);
+  for(uint k=0; k<x0.N; k++) x0(k) = (!k && x.N) ? x : P->getInitializationSample();
+
+  rai::Array<shared_ptr<SolverReturn>> rets(multiStarts);
+  std::atomic<bool> cancel(false);
+  pool.parallelFor(multiStarts, [&](uint k, uint worker) {
+    if(cancel.load()) return;
+    MP_Traced& Pw = *problems(worker);
+    uint evals=Pw.evals;
+    arr xk=x0(k), dk;
+    shared_ptr<SolverReturn> r = solveFrom(problems(worker), xk, dk, &cancel);
+    r->evals = Pw.evals-evals;
+    rets(k) = r;
+    if(r->feasible && r->sos+r->f<=multiStartStopCosts) cancel=true;
+  });
+
+  //-- best feasible return, otherwise the least infeasible
+  shared_ptr<SolverReturn> best;
+  for(shared_ptr<SolverReturn>& r:rets) {
+    if(!r) continue; //cancelled before starting
+    if(!best
+       || (r->feasible && !best->feasible)
+       || (r->feasible && best->feasible && r->sos+r->f < best->sos+best->f)
+       || (!r->feasible && !best->feasible && r->ineq+r->eq < best->ineq+best->eq)) best=r;
+  }
+  x = best->x;
+  dual = best->dual;
+  return best;
+}
@@ -4,10 +4,12 @@
 #include "options.h"
 #include "../Core/graph.h"
 
+#include <atomic>
+
 enum MP_SolverID { MPS_none=-1,
                    MPS_gradientDescent, MPS_rprop, MPS_LBFGS, MPS_newton,
                    MPS_augmentedLag, MPS_squaredPenalty, MPS_logBarrier, MPS_singleSquaredPenalty,
-                   MPS_NLopt, MPS_Ipopt, MPS_Ceres
+                   MPS_NLopt, MPS_Ipopt, MPS_Ceres, MPS_interiorPoint
                   };
 
 enum NLopt_SolverOption { _NLopt_LD_SLSQP,
@@ -26,8 +28,8 @@ enum NLopt_SolverOption { _NLopt_LD_SLSQP,
 struct SolverReturn {
   arr x, dual;
   uint evals=0;
-  double time=0.;
-  bool feasible=false;
+  double time=0.;               ///< wall time of the solve
+  bool feasible=false;          ///< set by every solve: ineq+eq <= MP_Solver::feasibilityTolerance (for solvers other than OptConstrained, by evaluating the returned x once more)
   double sos=-1., f=-1., ineq=-1., eq=-1.;
   void write(ostream& os) const{
     os <<"SolverReturn: time: " <<time <<" evals: " <<evals;
@@ -43,6 +45,12 @@ struct MP_Solver : NonCopyable {
   arr x, dual;
   shared_ptr<MP_Traced> P;
   rai::OptOptions opt;
+  double feasibilityTolerance=1e-2; ///< a return is feasible if its summed inequality and equality violations are below (sets SolverReturn::feasible of every solve, and ranks multi-start returns)
+
+  //-- only for multi-start solving
+  uint multiStarts=0;
+  double multiStartStopCosts=0.;
+  int multiStartThreads=0;
 
   MP_Solver& setSolver(MP_SolverID _solverID){ solverID=_solverID; return *this; }
   MP_Solver& setProblem(const shared_ptr<MathematicalProgram>& _P){ CHECK(!P, "problem was already set!"); P = make_shared<MP_Traced>(_P); return *this; }
@@ -50,6 +58,9 @@ struct MP_Solver : NonCopyable {
   MP_Solver& setInitialization(const arr& _x){ x=_x; return *this; }
   MP_Solver& setWarmstart(const arr& _x, const arr& _dual){ x=_x; dual=_dual; return *this; }
   MP_Solver& setTracing(bool trace_x, bool trace_costs, bool trace_phi, bool trace_J){ P->setTracing(trace_x, trace_costs, trace_phi, trace_J); return *this; }
+  /// solve runs K solves (from x, if set, and getInitializationSample()) in parallel, each worker on its own clone of the problem (MathematicalProgram::clone);
+  /// once a solve returns feasible with costs (sos+f) <= stopCosts, all others are cancelled; solve returns the best feasible (or least infeasible) return
+  MP_Solver& setMultiStart(uint K, double stopCosts=std::numeric_limits<double>::infinity(), int threads=0){ multiStarts=K; multiStartStopCosts=stopCosts; multiStartThreads=threads; return *this; }
 
   shared_ptr<SolverReturn> solve(int resampleInitialization=-1); ///< -1: only when not yet set
 
@@ -61,4 +72,8 @@ struct MP_Solver : NonCopyable {
     FILE("z.opt.trace") <<getTrace_costs();
     gnuplot("plot 'z.opt.trace' us 0:1 t 'sos', '' us 0:2 t 'ineq', '' us 0:3 t 'eq'");
   }
+
+ private:
+  shared_ptr<SolverReturn> solveFrom(const shared_ptr<MP_Traced>& P, arr& x, arr& dual, const std::atomic<bool>* cancel=nullptr);
+  shared_ptr<SolverReturn> solveMultiStart();
 };
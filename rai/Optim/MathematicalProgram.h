@@ -64,6 +64,9 @@ public:
   //-- optional: return some info on the problem and the last evaluation, potentially with display
   virtual void report(ostream& os, int verbose){ os <<"NLP of type '" <<rai::niceTypeidName(typeid(*this)) <<"' -- no reporting implemented"; }
 
+  //-- optional: an independent copy of the problem that can be evaluated concurrently (e.g. for parallel multi-start solving) [default: not supported, nullptr]
+  virtual shared_ptr<MathematicalProgram> clone() { return nullptr; }
+
   uint getDimension() const { return dimension; }
   void getBounds(arr& lo, arr& up) const { lo=bounds_lo; up=bounds_up; }
   const ObjectiveTypeA& getFeatureTypes() const { return featureTypes; }
@@ -124,6 +127,7 @@ struct MP_Traced : MathematicalProgram {
   //trivial
   virtual arr  getInitializationSample(const arr& previousOptima= {}) { return P->getInitializationSample(previousOptima); }
   virtual void getFHessian(arr& H, const arr& x) { P->getFHessian(H, x); }
+  virtual shared_ptr<MathematicalProgram> clone() { auto Q=P->clone(); if(!Q) return nullptr; return make_shared<MP_Traced>(Q); } ///< (traces are not copied)
 
   virtual void report(std::ostream &os, int verbose);
 };
@@ -74,6 +74,8 @@ OptConstrained::OptConstrained(arr& _x, arr& _dual, const shared_ptr<Mathematica
     L.useLB=true;
   }
 
+  if(opt.newtonCG) newton.hessianFactors = L.hessianFactors = make_shared<FactoredHessian>();
+
   newton.options.verbose = rai::MAX(opt.verbose-1, 0);
 
   if(opt.verbose>0) cout <<"***** optConstrained: method=" <<MethodName[opt.constrainedMethod] <<" bounds: " <<(opt.boundedNewton?"yes":"no") <<endl;
@@ -197,6 +199,7 @@ bool OptConstrained::step() {
 
   //upate Lagrange parameters
   L.autoUpdate(opt, &newton.fx, newton.gx, newton.Hx);
+  if(newton.hessianFactors) newton.Hx_factors = *newton.hessianFactors; //L was reevaluated at x
 
   if(!!dual) dual=L.lambda;
 
@@ -209,12 +212,25 @@ bool OptConstrained::step() {
 
 uint OptConstrained::run() {
 //  earlyPhase=true;
-  while(!step());
+  while(!step()) if(cancel && cancel->load()) break;
 //  newton.beta *= 1e-3;
 //  step();
   return newton.evals;
 }
 
+void OptConstrained::reinit() {
+  its=0;
+  earlyPhase=false;
+  L.x.clear(); //the problem might have changed even if x did not: enforce re-evaluation
+  if(!!dual) L.lambda = dual;
+  L.mu = L.nu = opt.muInit;
+  L.muLB = opt.muLBInit;
+  newton.its = newton.evals = 0;
+  newton.alpha = newton.options.initStep;
+  newton.beta = newton.options.damping;
+  newton.timeNewton = newton.timeEval = 0.;
+}
+
 OptConstrained::~OptConstrained() {
 }
 
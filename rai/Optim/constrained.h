@@ -11,6 +11,8 @@
 #include "lagrangian.h"
 #include "newton.h"
 
+#include <atomic>
+
 extern const char* MethodName[];
 
 //==============================================================================
@@ -26,12 +28,13 @@ struct OptConstrained {
   int its=0;
   bool earlyPhase=false;
   ostream* logFile=nullptr;
+  const std::atomic<bool>* cancel=nullptr; ///< optional: run() stops after the current outer iteration once this is set (e.g. by other multi-start workers)
 
   OptConstrained(arr& x, arr& dual, const shared_ptr<MathematicalProgram>& P, rai::OptOptions opt=NOOPT, ostream* _logFile=0);
   ~OptConstrained();
   bool step();
   uint run();
-//  void reinit();
+  void reinit(); ///< restart the outer and Newton iterations from the current x and dual (e.g. after the problem changed), keeping all buffers and workspaces
 };
 
 //==============================================================================
@@ -0,0 +1,303 @@
+/*  ------------------------------------------------------------------
+    Copyright (c) 2011-2020 Marc Toussaint
+    email: toussaint@tu-berlin.de
+
+    This code is distributed under the MIT License.
+    Please see <root-path>/LICENSE for details.
+    --------------------------------------------------------------  */
+
+#include "interiorPoint.h"
+
+#include <iomanip>
+
+namespace {
+
+const double tau_min=.99;         //fraction-to-boundary: steps keep at least 1-tau of the slacks and duals
+const double kappaEps=10.;        //mu is decreased once error(mu) <= kappaEps*mu
+const double kappaSigma=1e10;     //duals are kept within [mu/(kappaSigma s), kappaSigma mu/s]
+const double armijo=1e-4;
+const uint maxLineSteps=30;
+const double betaMax=1e8;         //a step that is no descent direction of the merit is recomputed with 10x damping, up to betaMax
+
+/// converts J to a CSRMatrix; RowShifted Jacobians keep their (explicit) zeros, so that the sparsity pattern stays constant
+void makeCSR(arr& J) {
+  if(isRowShifted(J)) {
+    rai::RowShifted& R = J.rowShifted();
+    uint d0=J.d0, d1=J.d1, n=0;
+    intA elems(d0*R.rowSize, 2);
+    arr values(d0*R.rowSize);
+    for(uint i=0; i<d0; i++) for(uint k=0; k<R.rowSize; k++) {
+        uint j = R.rowShift.p[i]+k;
+        if(j>=d1) break;
+        elems.p[2*n]=i;  elems.p[2*n+1]=j;  values.p[n]=R.entry(i, k);
+        n++;
+      }
+    elems.resizeCopy(n, 2);
+    values.resizeCopy(n);
+    J.clear();
+    J.csr().setFromTriplets(d0, d1, elems, values);
+  } else {
+    J.csr();
+  }
+}
+
+/// the largest alpha in (0,1] with v + alpha dv >= (1-tau) v
+double maxStep(const arr& v, const arr& dv, double tau) {
+  double alpha=1.;
+  for(uint k=0; k<v.N; k++) if(dv.p[k]<0.) {
+      double a = -tau*v.p[k]/dv.p[k];
+      if(a<alpha) alpha=a;
+    }
+  return alpha;
+}
+
+}
+
+//==============================================================================
+
+OptInteriorPoint::OptInteriorPoint(arr& _x, arr& _dual, const shared_ptr<MathematicalProgram>& _P, rai::OptOptions _opt)
+  : x(_x), dual(_dual), P(_P), opt(_opt) {
+  uint n = P->getDimension();
+  CHECK_EQ(x.N, n, "");
+
+  for(uint i=0; i<P->featureTypes.N; i++) {
+    ObjectiveType ot = P->featureTypes.p[i];
+    if(ot==OT_f) fIdx.append(i);
+    else if(ot==OT_sos) sosIdx.append(i);
+    else if(ot==OT_ineq || ot==OT_ineqB) ineqIdx.append(i);
+    else if(ot==OT_eq) eqIdx.append(i);
+  }
+  if(P->bounds_lo.N==n && P->bounds_up.N==n) {
+    for(uint i=0; i<n; i++) if(P->bounds_up.p[i]>P->bounds_lo.p[i]) {
+        if(std::isfinite(P->bounds_lo.p[i])) loIdx.append(i);
+        if(std::isfinite(P->bounds_up.p[i])) upIdx.append(i);
+      }
+  }
+
+  mu = opt.muLBInit;
+  evaluate(x);
+
+  //-- slacks, and duals (warm started from the given dual, if of the right size)
+  uint m=phi.N;
+  s = -g;
+  for(double& si:s) if(si<1e-2) si=1e-2;
+  z.resize(s.N);
+  for(uint k=0; k<s.N; k++) z.p[k] = mu/s.p[k];
+  y = zeros(eqIdx.N);
+  if(!!dual && dual.N==m) {
+    for(uint k=0; k<ineqIdx.N; k++) if(dual.p[ineqIdx.p[k]]>z.p[k]) z.p[k] = dual.p[ineqIdx.p[k]];
+    for(uint k=0; k<eqIdx.N; k++) y.p[k] = dual.p[eqIdx.p[k]];
+  }
+}
+
+void OptInteriorPoint::evaluate(const arr& x_eval) {
+  P->evaluate(phi, J, x_eval);
+  evals++;
+  CHECK_EQ(phi.N, P->featureTypes.N, "");
+  makeCSR(J);
+  g.resize(ineqIdx.N+loIdx.N+upIdx.N);
+  uint k=0;
+  for(uint i:ineqIdx) g.p[k++] = phi.p[i];
+  for(uint i:loIdx) g.p[k++] = P->bounds_lo.p[i] - x_eval.p[i];
+  for(uint i:upIdx) g.p[k++] = x_eval.p[i] - P->bounds_up.p[i];
+}
+
+double OptInteriorPoint::merit(double mu) {
+  double F=0., B=0., C=0.;
+  for(uint i:fIdx) F += phi.p[i];
+  for(uint i:sosIdx) F += rai::sqr(phi.p[i]);
+  for(uint k=0; k<s.N; k++) { B -= ::log(s.p[k]);  C += fabs(g.p[k]+s.p[k]); }
+  for(uint i:eqIdx) C += fabs(phi.p[i]);
+  return F + mu*B + nu*C;
+}
+
+double OptInteriorPoint::error(double mu) {
+  uint n=x.N, m=phi.N, nIneq=ineqIdx.N;
+
+  //-- gradient of the Lagrangian: J^T c plus the bound duals
+  arr c = zeros(m);
+  for(uint i:fIdx) c.p[i] = 1.;
+  for(uint i:sosIdx) c.p[i] = 2.*phi.p[i];
+  for(uint k=0; k<nIneq; k++) c.p[ineqIdx.p[k]] = z.p[k];
+  for(uint k=0; k<eqIdx.N; k++) c.p[eqIdx.p[k]] = y.p[k];
+  r_d = J.csr().At_x(c);
+  CHECK_EQ(r_d.N, n, "");
+  for(uint k=0; k<loIdx.N; k++) r_d.p[loIdx.p[k]] -= z.p[nIneq+k];
+  for(uint k=0; k<upIdx.N; k++) r_d.p[upIdx.p[k]] += z.p[nIneq+loIdx.N+k];
+
+  //-- scaled max-norm of all residuals (scaling of the dual and complementarity residuals as in Ipopt)
+  double sMax=100., zSum=sum(z), ySum=sumOfAbs(y);
+  double sd = rai::MAX(sMax, (zSum+ySum)/double(z.N+y.N+1))/sMax;
+  double sc = rai::MAX(sMax, zSum/double(z.N+1))/sMax;
+  double e = absMax(r_d)/sd;
+  for(uint k=0; k<s.N; k++) {
+    e = rai::MAX(e, fabs(g.p[k]+s.p[k]));
+    e = rai::MAX(e, fabs(s.p[k]*z.p[k]-mu)/sc);
+  }
+  for(uint i:eqIdx) e = rai::MAX(e, fabs(phi.p[i]));
+  return e;
+}
+
+bool OptInteriorPoint::step() {
+  uint n=x.N, m=phi.N, nIneq=ineqIdx.N, nLo=loIdx.N, nG=s.N;
+  double tol = opt.stopTolerance;
+
+  //-- converged?
+  double err0 = error(0.);
+  if(err0<=tol) {
+    if(opt.verbose>1) cout <<"--- interiorPoint: converged, error=" <<err0 <<endl;
+    return true;
+  }
+  if(its>=(uint)opt.stopIters || evals>=(uint)opt.stopEvals) {
+    if(opt.verbose>1) cout <<"--- interiorPoint: stopping (its=" <<its <<" evals=" <<evals <<"), error=" <<err0 <<endl;
+    return true;
+  }
+  its++;
+
+  //-- decrease mu (possibly several times), as long as the barrier problem is solved well enough
+  double muMin = tol/(kappaEps+1.);
+  while(mu>muMin && error(mu)<=kappaEps*mu) {
+    mu = rai::MAX(muMin, rai::MIN(opt.muLBDec*mu, pow(mu, 1.5)));
+    nu = 1.;
+  }
+  double deltaEq = rai::MAX(1e-10, 1e-2*mu);
+  error(mu); //sets r_d
+
+  //-- the reduced system: J^T W J (only sos, ineq, and eq rows), plus diagonal terms of the bounds and regularization
+  intA rows(m);
+  arr w = zeros(m);
+  rows = -1;
+  for(uint i:sosIdx) { rows.p[i]=i;  w.p[i]=sqrt(2.); }
+  for(uint k=0; k<nIneq; k++) { uint i=ineqIdx.p[k];  rows.p[i]=i;  w.p[i]=sqrt(z.p[k]/s.p[k]); }
+  for(uint i:eqIdx) { rows.p[i]=i;  w.p[i]=sqrt(1./deltaEq); }
+  arr JW;
+  JW.csr().setScaledRows(J.csr(), rows, w);
+  arr K = JW.csr().At_A();
+
+  arr H;
+  P->getFHessian(H, x);
+  if(H.N) { //merge the Hessian of the f-terms via triplets
+    arr Hc = H;
+    makeCSR(Hc);
+    intA elems = K.csr().getElems();
+    elems.append(Hc.csr().getElems());
+    arr values(K.p, K.N, false);
+    values.append(arr(Hc.p, Hc.N, true));
+    K.clear();
+    K.csr().setFromTriplets(n, n, elems, values); //keeps the (stored) diagonal of J^T W J
+  }
+
+  //-- residuals of the inequalities and their contributions to the right-hand side
+  arr r_g = g+s;
+  arr u(nG); //such that dz = u + (z/s) J_g dx
+  for(uint k=0; k<nG; k++) u.p[k] = (z.p[k]*r_g.p[k] - (s.p[k]*z.p[k]-mu))/s.p[k];
+  arr c = zeros(m);
+  for(uint k=0; k<nIneq; k++) c.p[ineqIdx.p[k]] = u.p[k];
+  for(uint k=0; k<eqIdx.N; k++) c.p[eqIdx.p[k]] = phi.p[eqIdx.p[k]]/deltaEq;
+  arr rhs = J.csr().At_x(c);
+  rhs += r_d;
+  arr diag = zeros(n);
+  for(uint k=0; k<nLo; k++) { uint i=loIdx.p[k];  rhs.p[i] -= u.p[nIneq+k];  diag.p[i] += z.p[nIneq+k]/s.p[nIneq+k]; }
+  for(uint k=0; k<upIdx.N; k++) { uint i=upIdx.p[k], l=nIneq+nLo+k;  rhs.p[i] += u.p[l];  diag.p[i] += z.p[l]/s.p[l]; }
+  rhs *= -1.;
+  for(uint i=0; i<n; i++) *K.csr().find(i, i) += diag.p[i] + beta + 1e-10;
+
+  //-- factor; increase the primal regularization until positive definite (only needed for non-convex f-terms)
+  double delta=0.;
+  while(!cholesky.factor(K)) {
+    double d = delta ? 10.*delta : (deltaX ? rai::MAX(1e-8, deltaX/3.) : 1e-4);
+    CHECK_LE(d, 1e20, "interiorPoint: can't regularize the KKT system");
+    K.csr().addDiag(d-delta);
+    delta = d;
+  }
+  deltaX = delta;
+  arr dx = cholesky.solve(rhs);
+
+  //-- recover the slack and dual steps
+  arr Jdx = J.csr().A_x(dx);
+  arr Jg_dx(nG);
+  for(uint k=0; k<nIneq; k++) Jg_dx.p[k] = Jdx.p[ineqIdx.p[k]];
+  for(uint k=0; k<nLo; k++) Jg_dx.p[nIneq+k] = -dx.p[loIdx.p[k]];
+  for(uint k=0; k<upIdx.N; k++) Jg_dx.p[nIneq+nLo+k] = dx.p[upIdx.p[k]];
+  arr ds = -r_g - Jg_dx;
+  arr dz(nG);
+  for(uint k=0; k<nG; k++) dz.p[k] = u.p[k] + z.p[k]/s.p[k]*Jg_dx.p[k];
+  arr dy(eqIdx.N);
+  for(uint k=0; k<eqIdx.N; k++) { uint i=eqIdx.p[k];  dy.p[k] = (Jdx.p[i]+phi.p[i])/deltaEq; }
+
+  //-- merit function: penalty parameter and directional derivative
+  nu = rai::MAX(nu, rai::MAX(absMax(z+dz), absMax(y+dy))+1.);
+  double D=0., C=0.;
+  for(uint i:fIdx) D += Jdx.p[i];
+  for(uint i:sosIdx) D += 2.*phi.p[i]*Jdx.p[i];
+  for(uint k=0; k<nG; k++) { D -= mu*ds.p[k]/s.p[k];  C += fabs(r_g.p[k]); }
+  D -= nu*C;
+  for(uint i:eqIdx) D += nu*(phi.p[i] ? rai::sign(phi.p[i])*Jdx.p[i] : fabs(Jdx.p[i]));
+
+  //-- not a descent direction of the merit: treat as a failed step and recompute with more damping (once damped strongly,
+  //   the line search below requires a plain decrease of the merit instead)
+  if(D>=0. && beta<betaMax) {
+    beta = beta ? 10.*beta : 1e-2;
+    if(opt.verbose>1) cout <<"interiorPoint it:" <<std::setw(4) <<its <<"  no descent direction (D=" <<D <<"), beta:" <<beta <<endl;
+    return false;
+  }
+
+  //-- fraction-to-boundary step sizes, and backtracking line search on the merit
+  double tau = rai::MAX(tau_min, 1.-mu);
+  double alpha = maxStep(s, ds, tau);
+  double dxMax = absMax(dx);
+  if(opt.maxStep>0. && alpha*dxMax>opt.maxStep) alpha = opt.maxStep/dxMax; //bounded step, as in OptNewton
+  double alphaZ = maxStep(z, dz, tau);
+  double M0 = merit(mu);
+  arr x0=x, s0=s;
+  uint lineSteps=0;
+  for(;;) {
+    x = x0 + alpha*dx;
+    s = s0 + alpha*ds;
+    evaluate(x);
+    double M = merit(mu);
+    if(opt.verbose>2) cout <<"  probing alpha:" <<alpha <<" merit:" <<M <<" (" <<M0 <<" + " <<armijo*alpha*D <<")" <<endl;
+    if(!std::isnan(M) && M<=M0+armijo*alpha*rai::MIN(D, 0.)) break;
+    if(lineSteps>=maxLineSteps) { //give up: take the tiny step, or stay if that is infeasible or (without descent) increases the merit
+      if(std::isnan(M) || (D>=0. && M>M0)) { x=x0;  s=s0;  evaluate(x);  alpha=0.; }
+      break;
+    }
+    alpha *= .5;
+    lineSteps++;
+  }
+
+  //-- adapt the damping: the Gauss-Newton model lacks the curvature of the constraints, which shows in short steps
+  if(lineSteps>1) beta = beta ? 3.*beta : 1e-2;
+  else if(!lineSteps) { beta *= .3;  if(beta<1e-8) beta=0.; }
+
+  //-- accept: slack reset (only decreases the merit), dual steps, and the dual safeguard
+  for(uint k=0; k<nG; k++) if(s.p[k] < -g.p[k]) s.p[k] = -g.p[k];
+  z += alphaZ*dz;
+  y += alpha*dy;
+  for(uint k=0; k<nG; k++) {
+    double lo = mu/(kappaSigma*s.p[k]), up = kappaSigma*mu/s.p[k];
+    if(z.p[k]<lo) z.p[k]=lo;
+    if(z.p[k]>up) z.p[k]=up;
+  }
+
+  if(opt.verbose>1) cout <<"interiorPoint it:" <<std::setw(4) <<its <<"  mu:" <<std::setw(11) <<mu <<"  err:" <<std::setw(11) <<err0
+                        <<"  beta:" <<std::setw(11) <<beta <<"  delta:" <<std::setw(11) <<delta <<"  alpha:" <<std::setw(11) <<alpha <<"  lineSteps:" <<lineSteps <<"  evals:" <<evals <<endl;
+  return false;
+}
+
+uint OptInteriorPoint::run() {
+  while(!step()) {}
+
+  //-- return duals in the convention of the LagrangianProblem
+  if(!!dual) {
+    dual = zeros(phi.N);
+    for(uint k=0; k<ineqIdx.N; k++) dual.p[ineqIdx.p[k]] = z.p[k];
+    for(uint k=0; k<eqIdx.N; k++) dual.p[eqIdx.p[k]] = y.p[k];
+  }
+  if(opt.verbose>0) {
+    arr err = summarizeErrors(phi, P->featureTypes);
+    cout <<"==interiorPoint== it:" <<std::setw(4) <<its <<"  evals:" <<std::setw(4) <<evals <<"  mu:" <<mu
+         <<"  f:" <<err(0) <<"  ineq:" <<err(1) <<"  eq:" <<err(2) <<endl;
+  }
+  return evals;
+}
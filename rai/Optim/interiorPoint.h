@@ -0,0 +1,56 @@
+/*  ------------------------------------------------------------------
+    Copyright (c) 2011-2020 Marc Toussaint
+    email: toussaint@tu-berlin.de
+
+    This code is distributed under the MIT License.
+    Please see <root-path>/LICENSE for details.
+    --------------------------------------------------------------  */
+
+#pragma once
+
+#include "MathematicalProgram.h"
+#include "options.h"
+
+//==============================================================================
+//
+// Solvers
+//
+
+/** A primal-dual interior point method for MathematicalPrograms (f, sos, ineq and eq features, and bounds) that only uses
+ *  sparse linear algebra, for large problems. All inequalities (including the bounds) get slacks s>0 with duals z, the
+ *  equalities get duals y. The Newton system of the perturbed KKT conditions is reduced to the primal system
+ *    (J^T W J + Sigma_bounds + fHessian + delta I) dx = rhs,
+ *  with weights W = 2 for sos, z/s for ineq, and 1/deltaEq for the (proximally regularized) eq features. This is
+ *  assembled as CSRMatrix from the CSR Jacobian and factored with the SparseCholesky, which does the symbolic analysis
+ *  only once for a constant sparsity pattern. The Hessian is Gauss-Newton: the missing curvature of the constraints is
+ *  compensated by a damping beta that adapts to the line search. Steps are fraction-to-boundary safeguarded and
+ *  backtracked on an l1-merit function; the barrier parameter mu is decreased superlinearly whenever the KKT error of
+ *  the current barrier problem is small enough. */
+struct OptInteriorPoint {
+  arr& x;
+  arr& dual;  ///< as the lambda of the LagrangianProblem: one entry per feature (z for ineq, y for eq, 0 else)
+  shared_ptr<MathematicalProgram> P;
+  rai::OptOptions opt;
+
+  arr phi, J;        ///< the last evaluation (J as CSRMatrix)
+  arr g, s, z;       ///< values, slacks, and duals of all inequalities: first the ineq features, then lower, then upper bounds
+  arr y;             ///< duals of the eq features
+  double mu;         ///< barrier parameter
+  double nu=1.;      ///< penalty parameter of the merit function
+  double beta=0.;    ///< damping of the primal system, increased when the line search needs many steps or the step is no descent direction
+  double deltaX=0.;  ///< primal regularization of the last step (to make it positive definite)
+  uint its=0, evals=0;
+  rai::SparseCholesky cholesky;
+
+  OptInteriorPoint(arr& x, arr& dual, const shared_ptr<MathematicalProgram>& P, rai::OptOptions opt=NOOPT);
+  bool step(); ///< one Newton step (preceded by mu updates); returns true when converged or stopped
+  uint run();
+  double error(double mu); ///< the (scaled) max-norm of the KKT residuals of the barrier problem for mu
+
+ private:
+  uintA fIdx, sosIdx, ineqIdx, eqIdx;  //feature indices of each type
+  uintA loIdx, upIdx;                  //the bounded variables
+  arr r_d;                             //gradient of the Lagrangian at the last evaluation
+  void evaluate(const arr& x_eval);
+  double merit(double mu);
+};
@@ -39,18 +39,21 @@ LagrangianProblem::LagrangianProblem(const shared_ptr<MathematicalProgram>& P, c
   if(!!lambdaInit) lambda = lambdaInit;
 
   featureTypes.clear();
-  for(ObjectiveType& t:P->featureTypes) {
-    if(            t==OT_f) featureTypes.append(OT_f);        // direct cost term
-    if(            t==OT_sos) featureTypes.append(OT_sos);    // sumOfSqr term
+  metaIdx.resize(P->featureTypes.N+1);
+  for(uint i=0; i<P->featureTypes.N; i++) {
+    ObjectiveType t = P->featureTypes.p[i];
+    metaIdx.p[i] = featureTypes.N;
+    if(            t==OT_f) { featureTypes.append(OT_f);  idx_f.append(i); }          // direct cost term
+    if(            t==OT_sos) { featureTypes.append(OT_sos);  idx_sos.append(i); }    // sumOfSqr term
     if(useLB    && t==OT_ineq) featureTypes.append(OT_f);     // log barrier
     if(!useLB   && t==OT_ineq) featureTypes.append(OT_sos);   // square g-penalty
-    if(            t==OT_ineq) featureTypes.append(OT_f);     // g-lagrange terms
+    if(            t==OT_ineq) { featureTypes.append(OT_f);  idx_ineq.append(i); }    // g-lagrange terms
     if(            t==OT_ineqB) featureTypes.append(OT_f);    // explicit log barrier
-    if(            t==OT_ineqB) featureTypes.append(OT_f);    // g-lagrange terms
+    if(            t==OT_ineqB) { featureTypes.append(OT_f);  idx_ineqB.append(i); } // g-lagrange terms
     if(            t==OT_eq) featureTypes.append(OT_sos);     // square h-penalty
-    if(            t==OT_eq) featureTypes.append(OT_f);       // h-lagrange terms
+    if(            t==OT_eq) { featureTypes.append(OT_f);  idx_eq.append(i); }        // h-lagrange terms
   }
-
+  metaIdx.p[P->featureTypes.N] = featureTypes.N;
 }
 
 void LagrangianProblem::evaluate(arr& phi, arr& J, const arr& _x) {
@@ -65,54 +68,73 @@ void LagrangianProblem::evaluate(arr& phi, arr& J, const arr& _x) {
   CHECK(x.N, "zero-dim optimization variables!");
   CHECK_EQ(phi_x.N, J_x.d0, "Jacobian size inconsistent");
   CHECK_EQ(phi_x.N, P->featureTypes.N, "termType array size inconsistent");
+  CHECK_EQ(metaIdx.N, phi_x.N+1, "featureTypes of P changed");
 
-  //-- construct unconstrained problem
-  //precompute I_lambda_x
-  boolA I_lambda_x(phi_x.N);
-  if(phi_x.N) I_lambda_x = false;
-  if(!useLB) for(uint i=0; i<phi_x.N; i++){
-    if(P->featureTypes.p[i]==OT_ineq) I_lambda_x.p[i] = (phi_x.p[i]>0. || (lambda.N && lambda.p[i]>0.));
-  }
-
+  //-- construct unconstrained problem: meta feature k is rowFactors(k)*phi_x(rows(k)) (or a log barrier), its Jacobian
+  //   row is rowFactors(k)*J_x[rows(k)]; rows(k)=-1 for inactive terms (zero value and empty row)
   phi.resize(featureTypes.N).setZero();
-  uint nphi=0;
-  for(uint i=0; i<phi_x.N; i++) {
-    ObjectiveType ot = P->featureTypes.p[i];
-    if(            ot==OT_f)   phi.p[nphi++] = phi_x.p[i];                                                  // direct cost term
-    if(            ot==OT_sos) phi.p[nphi++] = phi_x.p[i];                                      // sumOfSqr term
-    if(useLB    && ot==OT_ineq) { if(phi_x.p[i]>0.) phi.p[nphi++] = NAN; else phi.p[nphi++] =  -muLB * ::log(-phi_x.p[i]); }                   //log barrier, check feasibility
-    if(!useLB   && ot==OT_ineq) { if(I_lambda_x.p[i]) phi.p[nphi++] = sqrt(mu)*phi_x.p[i]; else phi.p[nphi++] = 0.; }      //g-penalty
-    if(            ot==OT_ineq) { if(lambda.N && lambda.p[i]>0.) phi.p[nphi++] = lambda.p[i] * phi_x.p[i]; else nphi++; }   //g-lagrange terms
-    if(            ot==OT_ineqB){ if(phi_x.p[i]>0.) phi.p[nphi++] = NAN; else phi.p[nphi++] =  -muLB * ::log(-phi_x.p[i]); }                   //log barrier, check feasibility
-    if(            ot==OT_ineqB){ if(lambda.N && lambda.p[i]>0.) phi.p[nphi++] = lambda.p[i] * phi_x.p[i]; else nphi++; }   //g-lagrange terms
-    if(            ot==OT_eq) phi.p[nphi++] =  sqrt(nu) * phi_x.p[i];            //h-penalty
-    if(            ot==OT_eq) { if(lambda.N) phi.p[nphi++] =  lambda.p[i] * phi_x.p[i]; else nphi++; }           //h-lagrange terms
+  intA rows(phi.N);
+  rows = -1;
+  arr rowFactors = zeros(phi.N);
+  const double* g = phi_x.p;
+  const double* lam = lambda.N ? lambda.p : 0;
+  auto set = [&](uint k, uint i, double fac, double value) { phi.p[k]=value; rows.p[k]=i; rowFactors.p[k]=fac; };
+  for(uint i:idx_f)   set(metaIdx.p[i], i, 1., g[i]);                                   // direct cost term
+  for(uint i:idx_sos) set(metaIdx.p[i], i, 1., g[i]);                                   // sumOfSqr term
+  for(uint i:idx_ineq) {
+    uint k = metaIdx.p[i];
+    if(useLB) set(k, i, -muLB/g[i], g[i]>0. ? NAN : -muLB * ::log(-g[i]));               //log barrier, check feasibility
+    else if(g[i]>0. || (lam && lam[i]>0.)) set(k, i, sqrt(mu), sqrt(mu)*g[i]);           //g-penalty
+    if(lam && lam[i]>0.) set(k+1, i, lam[i], lam[i]*g[i]);                               //g-lagrange terms
   }
-  CHECK_EQ(nphi, phi.N, "");
-
-  if(!!J) { //term Jacobians
-    if(J_x.isSparse()){
-      J.sparse().resize(phi.N, J_x.d1, 0);
-      J_x.sparse().setupRowsCols();
-    }else{
-      J.resize(phi.N, J_x.d1).setZero();
-    }
-    uint nphi=0;
-    for(uint i=0; i<phi_x.N; i++) {
-      ObjectiveType ot = P->featureTypes.p[i];
-#define J_setRow(fac) J.setMatrixBlock(fac J_x.sparse().getSparseRow(i), nphi++, 0)
-      if(            ot==OT_f)   J_setRow();   // direct cost term
-      if(            ot==OT_sos) J_setRow();   // sumOfSqr terms
-      if(useLB    && ot==OT_ineq) J_setRow( (-muLB/phi_x.p[i])* );                    //log barrier, check feasibility
-      if(!useLB   && ot==OT_ineq) { if(I_lambda_x.p[i]) J_setRow( sqrt(mu)* ); else nphi++; } //g-penalty
-      if(            ot==OT_ineq) { if(lambda.N && lambda.p[i]>0.) J_setRow( lambda.p[i]* ); else nphi++; }             //g-lagrange terms
-      if(            ot==OT_ineqB)J_setRow( (-muLB/phi_x.p[i])* );                    //log barrier, check feasibility
-      if(            ot==OT_ineqB){ if(lambda.N && lambda.p[i]>0.) J_setRow( lambda.p[i]* ); else nphi++; }             //g-lagrange terms
-      if(            ot==OT_eq) J_setRow( sqrt(nu)* );                      //h-penalty
-      if(            ot==OT_eq) { if(lambda.N) J_setRow( lambda.p[i]* );  else nphi++; }                                 //h-lagrange terms
-#undef J_setRow
+  for(uint i:idx_ineqB) {
+    uint k = metaIdx.p[i];
+    set(k, i, -muLB/g[i], g[i]>0. ? NAN : -muLB * ::log(-g[i]));                          //log barrier, check feasibility
+    if(lam && lam[i]>0.) set(k+1, i, lam[i], lam[i]*g[i]);                               //g-lagrange terms
+  }
+  for(uint i:idx_eq) {
+    uint k = metaIdx.p[i];
+    set(k, i, sqrt(nu), sqrt(nu)*g[i]);                                                  //h-penalty
+    if(lam) set(k+1, i, lam[i], lam[i]*g[i]);                                            //h-lagrange terms
+  }
+
+  if(!!J) { //term Jacobians: scaled rows of J_x, assembled directly in the format of J_x
+    J.clear();
+    if(isCSRMatrix(J_x)) {
+      J.csr().setScaledRows(J_x.csr(), rows, rowFactors);
+    } else if(isSparseMatrix(J_x)) {
+      const rai::SparseMatrix& S = J_x.sparse();
+      uint n=0;
+      for(uint l=0; l<J_x.N; l++) {
+        uint i = S.elems.p[2*l];
+        for(uint k=metaIdx.p[i]; k<metaIdx.p[i+1]; k++) if(rows.p[k]>=0) n++;
+      }
+      rai::SparseMatrix& T = J.sparse().resize(phi.N, J_x.d1, n);
+      n=0;
+      for(uint l=0; l<J_x.N; l++) {
+        uint i = S.elems.p[2*l], j = S.elems.p[2*l+1];
+        for(uint k=metaIdx.p[i]; k<metaIdx.p[i+1]; k++) if(rows.p[k]>=0) T.entry(k, j, n++) = rowFactors.p[k] * J_x.p[l];
+      }
+    } else if(isRowShifted(J_x)) {
+      const rai::RowShifted& S = J_x.rowShifted();
+      rai::RowShifted& T = J.rowShifted();
+      T.resize(phi.N, J_x.d1, S.rowSize);
+      for(uint k=0; k<phi.N; k++) if(rows.p[k]>=0) {
+          uint i = rows.p[k];
+          T.rowShift.p[k] = S.rowShift.p[i];
+          T.rowLen.p[k] = S.rowLen.p[i];
+          for(uint j=0; j<S.rowSize; j++) J.p[k*S.rowSize+j] = rowFactors.p[k] * J_x.p[i*S.rowSize+j];
+        }
+    } else {
+      CHECK(!isSpecial(J_x), "");
+      uint n=J_x.d1;
+      J.resize(phi.N, n).setZero();
+      for(uint k=0; k<phi.N; k++) if(rows.p[k]>=0) {
+          double fac=rowFactors.p[k], *Jk=J.p+k*n;
+          const double* Ji=J_x.p+rows.p[k]*n;
+          for(uint j=0; j<n; j++) Jk[j] = fac*Ji[j];
+        }
     }
-    CHECK_EQ(nphi, phi.N, "");
   }
 }
 
@@ -142,71 +164,45 @@ double LagrangianProblem::lagrangian(arr& dL, arr& HL, const arr& _x) {
     CHECK_EQ(phi_x.N, J_x.d0, "Jacobian size inconsistent");
   }
   CHECK_EQ(phi_x.N, P->featureTypes.N, "termType array size inconsistent");
+  CHECK_EQ(metaIdx.N, phi_x.N+1, "featureTypes of P changed");
 
-  //-- construct unconstrained problem
-  //precompute I_lambda_x
-  boolA I_lambda_x(phi_x.N);
-  if(phi_x.N) I_lambda_x = false;
-  if(!useLB) for(uint i=0; i<phi_x.N; i++){
-    if(P->featureTypes.p[i]==OT_ineq) I_lambda_x.p[i] = (phi_x.p[i]>0. || (lambda.N && lambda.p[i]>0.));
-  }
-
+  //-- the terms of the unconstrained problem, one kernel per feature type: the value L, and the coefficients of
+  //   the gradient dL = J^T coeff and the (Gauss-Newton) Hessian HL = J^T diag(hcoeff) J
   double L=0.; //L value
-  for(uint i=0; i<phi_x.N; i++) {
-    ObjectiveType ot = P->featureTypes.p[i];
-    if(            ot==OT_f) L += phi_x.p[i];                                      // direct cost term
-    if(            ot==OT_sos) L += rai::sqr(phi_x.p[i]);                          // sumOfSqr term
-    if(useLB    && ot==OT_ineq) { if(phi_x.p[i]>0.) return NAN;  L -= muLB * ::log(-phi_x.p[i]); }  //log barrier, check feasibility
-    if(!useLB   && ot==OT_ineq && I_lambda_x.p[i]) L += gpenalty(phi_x.p[i]);      //g-penalty
-    if(lambda.N && ot==OT_ineq  && lambda.p[i]>0.) L += lambda.p[i] * phi_x.p[i];   //g-lagrange terms
-    if(            ot==OT_ineqB) { if(phi_x.p[i]>0.) return NAN;  L -= muLB * ::log(-phi_x.p[i]); }  //log barrier, check feasibility
-    if(lambda.N && ot==OT_ineqB && lambda.p[i]>0.) L += lambda.p[i] * phi_x.p[i];  //g-lagrange terms
-    if(            ot==OT_eq) L += hpenalty(phi_x.p[i]);                           //h-penalty
-    if(lambda.N && ot==OT_eq) L += lambda.p[i] * phi_x.p[i];                       //h-lagrange terms
+  arr coeff = zeros(phi_x.N), hcoeff = zeros(phi_x.N);
+  double *c = coeff.p, *h = hcoeff.p;
+  const double* g = phi_x.p;
+  const double* lam = lambda.N ? lambda.p : 0;
+  for(uint i:idx_f) { L += g[i];  c[i] = 1.; }                                          // direct cost term
+  for(uint i:idx_sos) { L += g[i]*g[i];  c[i] = 2.*g[i];  h[i] = 2.; }                  // sumOfSqr term
+  for(uint i:idx_ineq) {
+    if(useLB) { if(g[i]>0.) return NAN;  L -= muLB * ::log(-g[i]);  c[i] = -muLB/g[i];  h[i] = muLB/(g[i]*g[i]); }  //log barrier, check feasibility
+    else if(g[i]>0. || (lam && lam[i]>0.)) { L += gpenalty(g[i]);  c[i] = gpenalty_d(g[i]);  h[i] = gpenalty_dd(g[i]); }  //g-penalty
+    if(lam && lam[i]>0.) { L += lam[i]*g[i];  c[i] += lam[i]; }                         //g-lagrange terms
+  }
+  for(uint i:idx_ineqB) {
+    if(g[i]>0.) return NAN;
+    L -= muLB * ::log(-g[i]);  c[i] = -muLB/g[i];  h[i] = muLB/(g[i]*g[i]);             //log barrier, check feasibility
+    if(lam && lam[i]>0.) { L += lam[i]*g[i];  c[i] += lam[i]; }                         //g-lagrange terms
+  }
+  for(uint i:idx_eq) {
+    L += hpenalty(g[i]);  c[i] = hpenalty_d(g[i]);  h[i] = hpenalty_dd(g[i]);          //h-penalty
+    if(lam) { L += lam[i]*g[i];  c[i] += lam[i]; }                                      //h-lagrange terms
   }
 
   if(!!dL) { //L gradient
-    arr coeff=zeros(phi_x.N);
-    for(uint i=0; i<phi_x.N; i++) {
-      ObjectiveType ot = P->featureTypes.p[i];
-      if(            ot==OT_f) coeff.p[i] += 1.;                                            // direct cost term
-      if(            ot==OT_sos) coeff.p[i] += 2.* phi_x.p[i];                              // sumOfSqr terms
-      if(useLB    && ot==OT_ineq) coeff.p[i] -= (muLB/phi_x.p[i]);                          //log barrier, check feasibility
-      if(!useLB   && ot==OT_ineq && I_lambda_x.p[i]) coeff.p[i] += gpenalty_d(phi_x.p[i]);  //g-penalty
-      if(lambda.N && ot==OT_ineq && lambda.p[i]>0.) coeff.p[i] += lambda.p[i];              //g-lagrange terms
-      if(            ot==OT_ineqB) coeff.p[i] -= (muLB/phi_x.p[i]);                         //log barrier, check feasibility
-      if(lambda.N && ot==OT_ineqB && lambda.p[i]>0.) coeff.p[i] += lambda.p[i];             //g-lagrange terms
-      if(            ot==OT_eq) coeff.p[i] += hpenalty_d(phi_x.p[i]);                       //h-penalty
-      if(lambda.N && ot==OT_eq) coeff.p[i] += lambda.p[i];                                  //h-lagrange terms
-    }
     dL = comp_At_x(J_x, coeff);
     dL.reshape(x.N);
   }
 
-  if(!!HL) { //L hessian: Most terms are of the form   "J^T  diag(coeffs)  J"
-    arr coeff=zeros(phi_x.N);
-    for(uint i=0; i<phi_x.N; i++) {
-      ObjectiveType ot = P->featureTypes.p[i];
-      //if(ot==OT_f) { if(fterm!=-1) HALT("There must only be 1 f-term (in the current implementation)");  fterm=i; }
-      if(            ot==OT_sos) coeff.p[i] += 2.;                                            // sumOfSqr terms
-      if(useLB    && ot==OT_ineq) coeff.p[i] += (muLB/rai::sqr(phi_x.p[i]));                  //log barrier, check feasibility
-      if(!useLB   && ot==OT_ineq && I_lambda_x.p[i]) coeff.p[i] += gpenalty_dd(phi_x.p[i]);   //g-penalty
-      if(            ot==OT_ineqB) coeff.p[i] += (muLB/rai::sqr(phi_x.p[i]));                 //log barrier, check feasibility
-      if(            ot==OT_eq) coeff.p[i] += hpenalty_dd(phi_x.p[i]);                        //h-penalty
-    }
-    arr tmp = J_x;
-    if(!isSpecial(tmp)) {
-      for(uint i=0; i<phi_x.N; i++) tmp[i]() *= sqrt(coeff.p[i]);
-    } else if(isSparseMatrix(tmp)){
-      arr sqrtCoeff = sqrt(coeff);
-      tmp.sparse().rowWiseMult(sqrtCoeff);
-    } else if(isRowShifted(tmp)){
-      arr sqrtCoeff = sqrt(coeff);
-      tmp.rowShifted().rowWiseMult(sqrtCoeff);
-    }
-    HL = comp_At_A(tmp); //Gauss-Newton type!
+  if(!!HL && hessianFactors) { //only the factors: J^T diag(hcoeff) J is never assembled
+    hessianFactors->set(J_x, hcoeff, H_x);
+    HL.clear();
+  } else if(!!HL) { //L hessian: Most terms are of the form   "J^T  diag(coeffs)  J"
+    HL = comp_At_A(J_x, hcoeff); //Gauss-Newton type! (weighted directly, without a row-scaled copy of J_x)
 
     if(H_x.N) { //For f-terms, the Hessian must be given explicitly, and is not \propto J^T J
+      if(isCSRMatrix(HL)) HL.sparse();
       HL += H_x;
     }
 
@@ -10,6 +10,7 @@
 
 #include "MathematicalProgram.h"
 #include "options.h"
+#include "newton.h"
 
 //==============================================================================
 //
@@ -34,6 +35,7 @@ struct LagrangianProblem : ScalarFunction, MathematicalProgram {
   arr phi_x, J_x, H_x; ///< features at x
 
   ostream* logFile=nullptr;  ///< file for logging
+  shared_ptr<FactoredHessian> hessianFactors; ///< optional (for matrix-free newtonCG steps): lagrangian() returns HL empty, and fills these instead
 
   LagrangianProblem(const shared_ptr<MathematicalProgram>& P, const rai::OptOptions& opt=NOOPT, arr& lambdaInit=NoArr);
 
@@ -61,5 +63,9 @@ struct LagrangianProblem : ScalarFunction, MathematicalProgram {
   double hpenalty(double h);
   double hpenalty_d(double h);
   double hpenalty_dd(double h);
+
+ private:
+  uintA idx_f, idx_sos, idx_ineq, idx_ineqB, idx_eq; ///< the features of P of each type (the index sets of the term kernels)
+  uintA metaIdx; ///< the meta features of feature i of P are metaIdx(i),...,metaIdx(i+1)-1
 };
 
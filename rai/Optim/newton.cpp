@@ -24,6 +24,197 @@ int optNewton(arr& x, const ScalarFunction& f, rai::OptOptions o) {
   return opt.run();
 }
 
+//===========================================================================
+//
+// inexact Newton steps: preconditioned CG on R Delta = -g that only needs products R*v
+//
+
+namespace {
+
+/// y = R v, for the formats of Newton systems (dense, CSR, or row-shifted -- if symmetric, only its upper triangle is stored)
+void newtonSystemTimes(arr& y, const arr& R, const arr& v) {
+  if(isRowShifted(R)) {
+    rai::RowShifted& rs = *(rai::RowShifted*)R.special;
+    y = rs.A_x(v);
+    if(rs.symmetric) { //add the lower triangle
+      y += rs.At_x(v);
+      for(uint i=0; i<R.d0; i++) y.p[i] -= rs.entry(i, 0)*v.p[i];
+    }
+  } else {
+    y = comp_A_x(R, v);
+  }
+}
+
+/// Jacobi (blockSize=1) or block-Jacobi preconditioner: the inverse of the (block) diagonal of R
+struct NewtonPreconditioner {
+  uint b;
+  arr diag;          //for b=1
+  arrA blocks;       //for b>1: inverses of the diagonal blocks (the last may be smaller)
+
+  /// Jacobi from a given diagonal (e.g. of a FactoredHessian)
+  NewtonPreconditioner(const arr& diagonal) : b(1) {
+    diag.resize(diagonal.N);
+    for(uint i=0; i<diag.N; i++) { double d=diagonal.p[i]; diag.p[i] = d>0. ? 1./d : 1.; }
+  }
+
+  NewtonPreconditioner(const arr& R, uint blockSize) : b(blockSize ? blockSize : 1) {
+    uint n=R.d0;
+    uint nb = (n+b-1)/b;
+    blocks.resize(nb);
+    for(uint k=0; k<nb; k++) { uint m = (k+1)*b<=n ? b : n-k*b;  blocks(k).resize(m, m).setZero(); }
+    auto add = [this](uint i, uint j, double v) { if(i/b==j/b) blocks(i/b)(i%b, j%b) += v; };
+
+    //collect the block diagonal
+    if(!isSpecial(R)) {
+      for(uint i=0; i<n; i++) for(uint j=(i/b)*b; j<n && j/b==i/b; j++) add(i, j, R.p[i*n+j]);
+    } else if(isCSRMatrix(R)) {
+      const rai::CSRMatrix& S = R.csr();
+      for(uint i=0; i<n; i++) for(uint k=S.rowPtr.p[i]; k<S.rowPtr.p[i+1]; k++) add(i, S.colIdx.p[k], R.p[k]);
+    } else if(isRowShifted(R)) {
+      rai::RowShifted& S = *(rai::RowShifted*)R.special;
+      for(uint i=0; i<n; i++) {
+        uint rs = S.rowShift.p[i];
+        if(S.symmetric) CHECK_EQ(rs, i, "symmetric row-shifted matrices need to store the upper triangle");
+        for(uint k=0; k<R.d1 && rs+k<n; k++) {
+          double v = S.entry(i, k);
+          if(!v) continue;
+          add(i, rs+k, v);
+          if(S.symmetric && k) add(rs+k, i, v);
+        }
+      }
+    } else NIY;
+
+    //invert (blocks that are not positive definite fall back to their diagonal; non-positive diagonal entries to 1)
+    if(b==1) {
+      diag.resize(n);
+      for(uint i=0; i<n; i++) { double d=blocks(i).p[0]; diag.p[i] = d>0. ? 1./d : 1.; }
+      blocks.clear();
+      return;
+    }
+    for(arr& B:blocks) {
+      try {
+        B = inverse_SymPosDef(B);
+      } catch(...) {
+        arr D = zeros(B.d0, B.d0);
+        for(uint i=0; i<B.d0; i++) { double d=B(i, i); D(i, i) = d>0. ? 1./d : 1.; }
+        B = D;
+      }
+    }
+  }
+
+  void apply(arr& z, const arr& r) const {
+    if(b==1) { z = diag%r; return; }
+    z.resize(r.N);
+    for(uint k=0; k<blocks.N; k++) {
+      const arr& B = blocks.elem(k);
+      const double* rk = r.p+k*b;
+      for(uint i=0; i<B.d0; i++) {
+        double s=0.;
+        for(uint j=0; j<B.d0; j++) s += B.p[i*B.d0+j]*rk[j];
+        z.p[k*b+i] = s;
+      }
+    }
+  }
+};
+
+/// Steihaug's truncated CG for min_p g^T p + 1/2 p^T R p within |p|_inf <= radius (radius<=0: unconstrained), R given only by
+/// products R_times(y, v): y = R v; returns false if R has negative curvature along the very first direction and there is no radius to step to
+bool steihaugCG(arr& p, uint& iters, const std::function<void(arr& y, const arr& v)>& R_times, const arr& g, const NewtonPreconditioner& M, double radius, double forcing, uint maxIters) {
+  uint n=g.N;
+  p = zeros(n);
+  iters=0;
+  double gNorm = length(g);
+  if(!gNorm) return true;
+  double tol = rai::MIN(forcing, sqrt(gNorm)) * gNorm;
+
+  arr r=g, z, d, Rd;
+  M.apply(z, r);
+  d = -z;
+  double rz = scalarProduct(r, z);
+
+  auto toBoundary = [&]() { //p += tau d, with the largest tau such that |p|_inf <= radius
+    double tau=-1.;
+    for(uint i=0; i<n; i++) if(d.p[i]) {
+        double t = ((d.p[i]>0. ? radius : -radius) - p.p[i]) / d.p[i];
+        if(tau<0. || t<tau) tau=t;
+      }
+    if(tau>0.) p += tau*d;
+  };
+
+  for(; iters<maxIters; iters++) {
+    R_times(Rd, d);
+    double dRd = scalarProduct(d, Rd);
+    if(dRd<=0.) { //negative curvature
+      if(radius>0.) { toBoundary(); return true; }
+      return iters>0;
+    }
+    double a = rz/dRd;
+    if(radius>0. && absMax(p+a*d)>=radius) { toBoundary(); return true; }
+    p += a*d;
+    r += a*Rd;
+    if(length(r)<=tol) return true;
+    M.apply(z, r);
+    double rzNew = scalarProduct(r, z);
+    d *= rzNew/rz;
+    d -= z;
+    rz = rzNew;
+  }
+  return true;
+}
+
+} //namespace
+
+void FactoredHessian::set(const arr& _J, const arr& _coeff, const arr& _F) {
+  J = _J;
+  if(isSparseMatrix(J)) J.csr();
+  coeff = _coeff;
+  F.clear();
+  if(!!_F && _F.N) {
+    F = _F;
+    if(isSparseMatrix(F)) F.csr();
+  }
+}
+
+void FactoredHessian::times(arr& y, const arr& v) const {
+  arr Jv = comp_A_x(J, v);
+  Jv.reshape(coeff.N);
+  for(uint i=0; i<Jv.N; i++) Jv.p[i] *= coeff.p[i];
+  y = comp_At_x(J, Jv);
+  y.reshape(v.N);
+  if(F.N) {
+    arr Fv;
+    newtonSystemTimes(Fv, F, v);
+    y += Fv;
+  }
+}
+
+arr FactoredHessian::diag() const {
+  uint n=J.d1;
+  arr d = zeros(n);
+  const double* c=coeff.p;
+  if(!isSpecial(J)) {
+    for(uint i=0; i<J.d0; i++) if(c[i]) for(uint j=0; j<n; j++) d.p[j] += c[i]*rai::sqr(J.p[i*n+j]);
+  } else if(isCSRMatrix(J)) {
+    const rai::CSRMatrix& S = J.csr();
+    for(uint i=0; i<J.d0; i++) if(c[i]) for(uint k=S.rowPtr.p[i]; k<S.rowPtr.p[i+1]; k++) d.p[S.colIdx.p[k]] += c[i]*rai::sqr(J.p[k]);
+  } else if(isRowShifted(J)) {
+    rai::RowShifted& S = *(rai::RowShifted*)J.special;
+    for(uint i=0; i<J.d0; i++) if(c[i]) for(uint k=0; k<S.rowSize && S.rowShift.p[i]+k<n; k++) d.p[S.rowShift.p[i]+k] += c[i]*rai::sqr(S.entry(i, k));
+  } else NIY;
+  if(F.N) {
+    if(!isSpecial(F)) {
+      for(uint i=0; i<n; i++) d.p[i] += F.p[i*n+i];
+    } else if(isCSRMatrix(F)) {
+      const rai::CSRMatrix& S = F.csr();
+      for(uint i=0; i<n; i++) d.p[i] += S.elem(i, i);
+    } else if(isRowShifted(F)) {
+      rai::RowShifted& S = *(rai::RowShifted*)F.special;
+      for(uint i=0; i<n; i++) if(S.rowShift.p[i]<=i && i<S.rowShift.p[i]+S.rowSize) d.p[i] += S.entry(i, i-S.rowShift.p[i]);
+    } else NIY;
+  }
+  return d;
+}
+
 //===========================================================================
 
 OptNewton::OptNewton(arr& _x, const ScalarFunction& _f, rai::OptOptions _o, ostream* _logFile):
@@ -40,6 +231,7 @@ void OptNewton::reinit(const arr& _x) {
   boundCheck(x, bounds_lo, bounds_up);
   timeEval -= rai::cpuTime();
   fx = f(gx, Hx, x);  evals++;
+  if(hessianFactors) Hx_factors = *hessianFactors;
   timeEval += rai::cpuTime();
 
   //startup verbose
@@ -73,11 +265,12 @@ OptNewton::StopCriterion OptNewton::step() {
   timeNewton -= rai::cpuTime();
 
   //-- check active bounds, and decorrelate Hessian
+  bool factored = hessianFactors && options.newtonCG && !rootFinding; //matrix-free CG steps on Hx_factors; Hx is empty
   arr R=Hx;
+  intA boundActive; //analogy to dual parameters for bounds: -1: lower active; +1: upper active
+  uint nActiveBounds=0;
 #if 1
   {
-    intA boundActive; //analogy to dual parameters for bounds: -1: lower active; +1: upper active
-    uint nActiveBounds=0;
     if(!boundActive.N) boundActive.resize(x.N).setZero();
 #define BOUND_EPS 1e-10
     if(bounds_lo.N && bounds_up.N) {
@@ -88,7 +281,7 @@ OptNewton::StopCriterion OptNewton::step() {
       }
     }
 #undef BOUND_EPS
-    if(nActiveBounds){
+    if(nActiveBounds && !factored){ //(the factored products below mask them instead)
       //zero correlations to bound-active variables
       if(!isSpecial(R)) {
         for(uint i=0;i<x.N;i++) if(boundActive.elem(i)){
@@ -103,6 +296,14 @@ OptNewton::StopCriterion OptNewton::step() {
             s.Z.elem(k) = 0.;
           }
         }
+      } else if(isCSRMatrix(R)) {
+        rai::CSRMatrix& s = R.csr();
+        for(uint i=0; i<R.d0; i++) for(uint k=s.rowPtr(i); k<s.rowPtr(i+1); k++) {
+          uint j = s.colIdx.p[k];
+          if(i!=j && (boundActive.elem(i) || boundActive.elem(j))){
+            R.p[k] = 0.;
+          }
+        }
       } else NIY;
       if(options.verbose>5) cout <<"  boundActive:" <<boundActive;
     }
@@ -116,20 +317,53 @@ OptNewton::StopCriterion OptNewton::step() {
   double diag = 0.;
   if(sigmin<beta) diag = beta-sigmin;
 #endif
-  if(beta) { //Levenberg Marquardt damping
+  if(beta && !factored) { //Levenberg Marquardt damping
     if(!isSpecial(R)) {
       for(uint i=0; i<R.d0; i++) R(i, i) += beta;
     } else if(isRowShifted(R)) {
       for(uint i=0; i<R.d0; i++) R.rowShifted().entry(i, 0) += beta; //(R(i,0) is the diagonal in the packed matrix!!)
     } else if(isSparseMatrix(R)) {
       for(uint i=0; i<R.d0; i++) R.sparse().addEntry(i, i) = beta;
+    } else if(isCSRMatrix(R)) {
+      R.csr().addDiag(beta);
     } else NIY;
   }
   {
     bool inversionFailed=false;
     try {
-      if(!rootFinding) {
-        Delta = lapack_Ainv_b_sym(R, -gx);
+      if(factored) { //products with the damped and bound-decorrelated H = J^T diag(coeff) J + F, never assembled
+        uint k;
+        arr Hdiag = Hx_factors.diag();
+        auto R_times = [&](arr& y, const arr& v) {
+          if(!nActiveBounds) {
+            Hx_factors.times(y, v);
+          } else {
+            arr w=v;
+            for(uint i=0; i<w.N; i++) if(boundActive.p[i]) w.p[i]=0.;
+            Hx_factors.times(y, w);
+            for(uint i=0; i<w.N; i++) if(boundActive.p[i]) y.p[i] = Hdiag.p[i]*v.p[i];
+          }
+          if(beta) y += beta*v;
+        };
+        NewtonPreconditioner M(Hdiag+beta);
+        if(!steihaugCG(Delta, k, R_times, gx, M, options.maxStep, options.newtonCGForcing, options.newtonCGIters>0 ? options.newtonCGIters : x.N)) inversionFailed=true;
+        itsCG += k;
+        if(options.verbose>1) cout <<"  cg:" <<std::setw(4) <<k <<flush;
+      } else if(!rootFinding && options.newtonCG) {
+        if(isSparseMatrix(R)) R.csr();
+        uint k;
+        NewtonPreconditioner M(R, options.newtonCGBlockSize);
+        auto R_times = [&R](arr& y, const arr& v) { newtonSystemTimes(y, R, v); };
+        if(!steihaugCG(Delta, k, R_times, gx, M, options.maxStep, options.newtonCGForcing, options.newtonCGIters>0 ? options.newtonCGIters : x.N)) inversionFailed=true;
+        itsCG += k;
+        if(options.verbose>1) cout <<"  cg:" <<std::setw(4) <<k <<flush;
+      } else if(!rootFinding) {
+        if(options.sparseCholesky && isSparseMatrix(R)) R.csr();
+        if(options.sparseCholesky && isCSRMatrix(R) && cholesky.factor(R)) {
+          Delta = cholesky.solve(-gx);
+        } else { //dense, banded, or not positive definite (-> LDL^T)
+          Delta = lapack_Ainv_b_sym(R, -gx);
+        }
       } else {
         lapack_mldivide(Delta, R, -gx);
       }
@@ -216,6 +450,7 @@ OptNewton::StopCriterion OptNewton::step() {
       fx = fy;
       gx = gy;
       Hx = Hy;
+      if(hessianFactors) Hx_factors = *hessianFactors; //f was last evaluated at y
       if(wolfe) {
         if(alpha>.9 && beta>options.damping) {
           if(options.dampingDec>0.) beta *= options.dampingDec;
@@ -13,6 +13,15 @@
 
 int optNewton(arr& x, const ScalarFunction& f, rai::OptOptions opt=NOOPT);
 
+/// a Hessian in factored form, H = J^T diag(coeff) J + F (F optional), as it arises in sum-of-squares and Lagrangian problems:
+/// inexact (newtonCG) steps only need products H*v, which apply J and J^T without ever assembling J^T diag(coeff) J
+struct FactoredHessian {
+  arr J, coeff, F;
+  void set(const arr& _J, const arr& _coeff, const arr& _F); ///< copies the factors (triplet-sparse ones as CSR, which has fast products)
+  void times(arr& y, const arr& v) const; ///< y = H v
+  arr diag() const;                       ///< the diagonal of H (for the Jacobi preconditioner)
+};
+
 struct OptNewton {
   arr& x;
   ScalarFunction f;
@@ -33,9 +42,13 @@ public:
   arr gx, Hx;
   double alpha, beta;
   int its=0, evals=0, numTinyFSteps=0, numTinyXSteps=0;
+  int itsCG=0; //total CG iterations (with options.newtonCG)
   StopCriterion stopCriterion;
   arr bounds_lo, bounds_up;
   bool rootFinding=false;
   ostream* logFile=nullptr, *simpleLog=nullptr;
   double timeNewton=0., timeEval=0.;
+  rai::SparseCholesky cholesky; //factorization of sparse Hessians, its symbolic analysis is reused while the pattern is constant
+  shared_ptr<FactoredHessian> hessianFactors; //optional, with options.newtonCG: shared with f, which then fills these factors instead of H
+  FactoredHessian Hx_factors; //the factors at x (copied from hessianFactors after each evaluation at an accepted point)
 };
@@ -41,24 +41,26 @@ double Conv_MathematicalProgram_ScalarProblem::scalar(arr& g, arr& H, const arr&
 
   if(!!H) { //hessian: Most terms are of the form   "J^T  diag(coeffs)  J"
     arr coeff=zeros(phi.N);
-    double hasF=false;
+    bool hasF=false;
     for(uint i=0; i<phi.N; i++) {
       if(P->featureTypes.p[i]==OT_sos) coeff.p[i] += 2.;
       else if(P->featureTypes.p[i]==OT_f) hasF=true;
     }
-    arr tmp = J;
-    if(!isSparseMatrix(tmp)) {
-      for(uint i=0; i<phi.N; i++) tmp[i]() *= sqrt(coeff.p[i]);
-    } else {
-      arr sqrtCoeff = sqrt(coeff);
-      tmp.sparse().rowWiseMult(sqrtCoeff);
+
+    //For f-terms, the Hessian must be given explicitly, and is not \propto J^T J; it may also complement the Gauss-Newton terms
+    arr fH;
+    if(hasF) P->getFHessian(fH, x);
+
+    if(hessianFactors) { //only the factors: J^T diag(coeff) J is never assembled
+      hessianFactors->set(J, coeff, fH);
+      H.clear();
+      return f;
     }
-    H = comp_At_A(tmp); //Gauss-Newton type!
 
-    if(hasF) { //For f-terms, the Hessian must be given explicitly, and is not \propto J^T J
-      arr fH;
-      P->getFHessian(fH, x);
-      if(fH.N) H += fH;
+    H = comp_At_A(J, coeff); //Gauss-Newton type!
+    if(fH.N) {
+      if(isCSRMatrix(H)) H.sparse();
+      H += fH;
     }
 
     if(!H.special) H.reshape(x.N, x.N);
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "MathematicalProgram.h"
+#include "newton.h"
 
 //===========================================================================
 //
@@ -41,6 +42,7 @@ struct Conv_ScalarProblem_MathematicalProgram : MathematicalProgram {
 
 struct Conv_MathematicalProgram_ScalarProblem : ScalarFunction {
   std::shared_ptr<MathematicalProgram> P;
+  shared_ptr<FactoredHessian> hessianFactors; ///< optional (for matrix-free newtonCG steps): H is returned empty, and these are filled instead
 
   Conv_MathematicalProgram_ScalarProblem(std::shared_ptr<MathematicalProgram> _P) : P(_P) {
     ScalarFunction::operator=([this](arr& g, arr& H, const arr& x) -> double {
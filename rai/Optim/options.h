@@ -36,6 +36,11 @@ struct OptOptions {
   RAI_PARAM("opt/", int,    nonStrictSteps, 0) //# of non-strict iterations
   RAI_PARAM("opt/", bool,   boundedNewton, true)
   RAI_PARAM("opt/", bool,   allowOverstep, false)
+  RAI_PARAM("opt/", bool,   sparseCholesky, true) //use rai::SparseCholesky for sparse Newton steps
+  RAI_PARAM("opt/", bool,   newtonCG, false) //inexact Newton steps: truncated (Steihaug) preconditioned CG using only products R*v, instead of factoring R; for MP_Solver's newton and constrained solvers, R = J^T diag(c) J (+F) is never assembled: the products apply J and J^T
+  RAI_PARAM("opt/", int,    newtonCGBlockSize, 1) //CG preconditioner: 1: diagonal (Jacobi); >1: block-Jacobi with dense diagonal blocks of this size (only for assembled Hessians: factored ones, see FactoredHessian, use Jacobi)
+  RAI_PARAM("opt/", double, newtonCGForcing, .1) //CG stops when |residual| <= min(newtonCGForcing, sqrt|g|) |g|
+  RAI_PARAM("opt/", int,    newtonCGIters, 0) //max CG iterations per Newton step (0: dimensionality)
   RAI_PARAM("opt/", double, muInit, 1.)
   RAI_PARAM("opt/", double, aulaMuInc, 5.)
   RAI_PARAM("opt/", double, muLBInit, .1)
@@ -46,6 +46,8 @@ double PrimalDualProblem::primalDual(arr& r, arr& R, const arr& x_lambda) {
 
   arr dL, HL;
   L.lagrangian(dL, HL, x);
+  if(isCSRMatrix(HL)) HL.sparse(); //the KKT system below is assembled in the triplet format
+  if(isCSRMatrix(L.J_x)) L.J_x.sparse();
 //  cout <<"x=" <<x <<endl <<"lambda=" <<L.lambda <<endl <<"L=" <<Lval <<endl;
   if(!L.lambda.N) L.lambda = zeros(L.phi_x.N);
 
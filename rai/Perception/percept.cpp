@@ -82,12 +82,12 @@ void PercMesh::syncWith(rai::Configuration& K) {
     f->name <<"perc_" <<id;
     new rai::Shape(*f);
     f->shape->type() = rai::ST_mesh;
-    f->ats->getNew<int>("label") = 0x80+id;
+    f->set_ats().getNew<int>("label") = 0x80+id;
   }
   f->setPose(pose);
-  f->shape->mesh() = mesh;
-  f->shape->mesh().C = ARR(.5, 1., .5);
-  f->ats->getNew<int>("label") = 0x80+id;
+  f->shape->set_mesh() = mesh;
+  f->shape->set_mesh().C = ARR(.5, 1., .5);
+  f->set_ats().getNew<int>("label") = 0x80+id;
 }
 
 double PercMesh::fuse(PerceptPtr& other) {
@@ -143,7 +143,7 @@ void PercPlane::syncWith(rai::Configuration& K) {
   }
   body->setPose(pose);
 
-  body->shape->mesh() = hull;
+  body->shape->set_mesh() = hull;
 }
 
 void PercPlane::glDraw(OpenGL& gl) {
@@ -216,7 +216,7 @@ void PercBox::syncWith(rai::Configuration& K) {
   }
   body->setPose(pose);
   body->shape->size() = size;
-  body->shape->mesh().C = color;
+  body->shape->set_mesh().C = color;
 }
 
 void PercBox::glDraw(OpenGL&) {
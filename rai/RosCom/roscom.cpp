@@ -340,8 +340,8 @@ rai::Configuration conv_MarkerArray2Configuration(const visualization_msgs::Mark
         s->type() = rai::ST_cylinder;
       } else if(marker.type==marker.POINTS) {
         s->type() = rai::ST_mesh;
-        s->mesh().V = conv_points2arr(marker.points);
-        s->mesh().C = conv_colors2arr(marker.colors);
+        s->set_mesh().V = conv_points2arr(marker.points);
+        s->set_mesh().C = conv_colors2arr(marker.colors);
       } else NIY;
     }
     s->size(0) = marker.scale.x;
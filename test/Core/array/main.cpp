@@ -381,6 +381,33 @@ void TEST(MemoryBound){
 
 //===========================================================================
 
+void TEST(ArrayArena){
+  cout <<"\n*** array arena\n";
+  arr kept;
+  uint64_t hits0=rai::ArrayArena::hits();
+  {
+    rai::ArrayArena arena;
+    for(uint k=0;k<100;k++){
+      arr a = rand(10,10), b = a*a; //temporaries only
+      CHECK_EQ(b.d0, 10, "");
+      arr c = b;
+      c.append(a); //realloc within and across size classes
+      c.append(rand(1000));
+      CHECK_ZERO(maxDiff(c({0,99}), b.reshape(100)), 1e-10, "");
+      if(k==50) kept = c; //buffers may outlive the guard
+    }
+  }
+  CHECK(!rai::ArrayArena::active(), "");
+  cout <<"recycled buffers: " <<rai::ArrayArena::hits()-hits0 <<" malloc'ed: " <<rai::ArrayArena::misses() <<endl;
+  CHECK_GE(rai::ArrayArena::hits()-hits0, 500, "steady state should not allocate");
+  CHECK_EQ(rai::ArrayArena::cachedBytes(), 0, "the outermost guard releases the free lists");
+  CHECK_EQ(kept.N, 1200, "");
+  kept.clear();
+  CHECK_EQ(rai::ArrayArena::cachedBytes(), 0, "no caching without a guard");
+}
+
+//===========================================================================
+
 void TEST(BinaryIO){
   cout <<"\n*** acsii and binary IO\n";
   arr a,b; a.resize(1000,100); rndUniform(a,0.,1.,false);
@@ -842,6 +869,163 @@ void TEST(SparseMatrix){
 
 //===========================================================================
 
+void TEST(CSRMatrix){
+  cout <<"\n*** CSRMatrix\n";
+
+  for(uint k=0;k<100;k++){
+    arr A(10,20), x(20), y(10);
+    rndInteger(A,-2,2);
+    for(double& a:A) if(rnd.uni()<.6) a=0.;
+    rndGauss(x);
+    rndGauss(y);
+
+    arr C = A;
+    rai::CSRMatrix& S = C.csr();
+    S.checkConsistency();
+    CHECK_ZERO(maxDiff(unpack(C), A), 1e-10, "");
+    CHECK_ZERO(maxDiff(comp_A_x(C, x), A*x), 1e-10, "");
+    CHECK_ZERO(maxDiff(comp_At_x(C, y), ~A*y), 1e-10, "");
+    CHECK_ZERO(maxDiff(unpack(comp_At(C)), ~A), 1e-10, "");
+    arr H = comp_At_A(C);
+    H.csr().checkConsistency();
+    CHECK_ZERO(maxDiff(unpack(H), ~A*A), 1e-10, "");
+
+    //triplets (with duplicates, in random order) sum up
+    intA elems = S.getElems();
+    arr values(C.N);
+    for(uint i=0;i<C.N;i++) values(i) = C.p[i];
+    uintA perm = randperm(values.N);
+    elems.permuteRows(perm);
+    values.permute(perm);
+    elems.append(elems);
+    values.append(values);
+    arr D;
+    D.csr().setFromTriplets(10, 20, elems, values);
+    D.csr().checkConsistency();
+    CHECK_ZERO(maxDiff(unpack(D), 2.*A), 1e-10, "");
+
+    //conversions to and from SparseMatrix
+    arr E = A;
+    E.sparse();
+    E.csr();
+    CHECK_ZERO(maxDiff(unpack(E), A), 1e-10, "");
+    double* p = E.p;
+    E.sparse(); //does not copy the non-zeros
+    CHECK_EQ(p, E.p, "");
+    CHECK_ZERO(maxDiff(unpack(E), A), 1e-10, "");
+
+    //damping and rows scaling as used by the solvers
+    H.csr().addDiag(1.);
+    CHECK_ZERO(maxDiff(unpack(H), ~A*A+eye(20)), 1e-10, "");
+    S.rowWiseMult(y);
+    CHECK_ZERO(maxDiff(unpack(C), diag(y)*A), 1e-10, "");
+  }
+}
+
+//===========================================================================
+
+void TEST(WeightedAt_A){
+  cout <<"\n*** WeightedAt_A\n";
+
+  //A^T diag(w) A in all matrix formats, directly from A (rows of zero weight are skipped)
+  for(uint k=0;k<100;k++){
+    arr A(30,20), w(30);
+    rndGauss(A);
+    for(double& a:A) if(rnd.uni()<.7) a=0.;
+    rndUniform(w, 0., 2.);
+    for(double& a:w) if(rnd.uni()<.3) a=0.;
+    arr AtWA = ~A*diag(w)*A;
+
+    CHECK_ZERO(maxDiff(comp_At_A(A, w), AtWA), 1e-10, "dense");
+
+    arr C = A;
+    C.csr();
+    arr H = comp_At_A(C, w);
+    H.csr().checkConsistency();
+    CHECK_ZERO(maxDiff(unpack(H), AtWA), 1e-10, "CSRMatrix");
+    CHECK_EQ(H.csr().colIdx, comp_At_A(C).csr().colIdx, "the pattern does not depend on the weights");
+
+    arr S = A;
+    S.sparse();
+    H = comp_At_A(S, w);
+    CHECK(isCSRMatrix(H), "");
+    CHECK_ZERO(maxDiff(unpack(H), AtWA), 1e-10, "SparseMatrix");
+
+    arr R = A;
+    R.rowShifted().reshift();
+    CHECK_ZERO(maxDiff(unpack(comp_At_A(R, w)), AtWA), 1e-10, "RowShifted");
+  }
+}
+
+//===========================================================================
+
+void TEST(SparseCholesky){
+  cout <<"\n*** SparseCholesky\n";
+
+  rai::SparseCholesky chol;
+  for(uint k=0;k<100;k++){
+    //a random sparse positive definite matrix, with a new pattern every 10 trials
+    rnd.seed(k/10);
+    arr J(30,20), b(20);
+    rndGauss(J);
+    for(double& a:J) if(rnd.uni()<.85) a=0.;
+    rnd.seed(100+k); //values change, pattern stays
+    for(double& a:J) if(a) a=rnd.gauss();
+    rndGauss(b);
+    arr A = ~J*J + eye(20);
+
+    arr H = J;
+    H.csr();
+    H = comp_At_A(H);
+    H.csr().addDiag(1.);
+    CHECK(chol.factor(H), "");
+    CHECK_ZERO(maxDiff(chol.solve(b), lapack_Ainv_b_sym(A, b)), 1e-8, "");
+    CHECK_EQ(chol.analyses, k/10+1, "symbolic analysis not reused");
+  }
+
+  //indefinite matrices are rejected
+  arr H = eye(5);
+  H(2,2) = -1.;
+  H.csr();
+  CHECK(!chol.factor(H), "");
+  CHECK(!chol.valid, "a failed factorization must not be used by solve()");
+
+  //KOMO-like block-banded system (T time slices with 30 dofs each, coupled to 2 neighbors), in scrambled order
+  uint T=300, d=30, n=T*d;
+  uintA perm = randperm(n);
+  intA elems;
+  arr values;
+  for(uint t=0;t<T;t++) for(uint s=t;s<T && s<=t+2;s++){
+    for(uint i=0;i<d;i++) for(uint j=0;j<d;j++){
+      uint r=t*d+i, c=s*d+j;
+      if(r>c) continue;
+      double v = (r==c? 10.*d : rnd.uni(-1.,1.));
+      elems.append({(int)perm(r), (int)perm(c)});
+      values.append(v);
+      if(r!=c){ elems.append({(int)perm(c), (int)perm(r)});  values.append(v); }
+    }
+  }
+  elems.reshape(values.N, 2);
+  arr B;
+  B.csr().setFromTriplets(n, n, elems, values);
+  arr b = randn(n);
+  chol.factor(B);
+  double time = -rai::cpuTime();
+  for(uint k=0;k<5;k++) CHECK(chol.factor(B), "");
+  time += rai::cpuTime();
+  arr x = chol.solve(b);
+  CHECK_ZERO(maxDiff(comp_A_x(B, x), b), 1e-8, "");
+  arr S = B;
+  S.sparse();
+  double timeEigen = -rai::cpuTime();
+  arr y = eigen_Ainv_b(S, b);
+  timeEigen += rai::cpuTime();
+  CHECK_ZERO(maxDiff(x, y), 1e-8, "");
+  cout <<"n=" <<n <<" nnz(A)=" <<B.N <<" nnz(L)=" <<chol.Lx.N <<" factor time=" <<time/5. <<"sec (Eigen LDLT with analysis: " <<timeEigen <<"sec)" <<endl;
+}
+
+//===========================================================================
+
 void TEST(SparseVector){
   cout <<"\n*** SparseVector\n";
 
@@ -916,6 +1100,10 @@ void TEST(EigenValues){
 int MAIN(int argc, char **argv){
   rai::initCmdLine(argc, argv);
 
+  testArrayArena();
+  testCSRMatrix();
+  testWeightedAt_A();
+  testSparseCholesky();
   testMemoryBound(); return 0;
 
   testBasics();
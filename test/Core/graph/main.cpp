@@ -132,6 +132,60 @@ void TEST(Random){
 
 //===========================================================================
 
+void TEST(HashIndex){
+  rai::Graph G;
+  G.useHashIndex();
+
+  //the hashed find methods have to agree with a linear search
+  auto equal = [](const rai::NodeL& a, const rai::NodeL& b){
+    if(a.N!=b.N) return false;
+    for(uint i=0;i<a.N;i++) if(a.elem(i)!=b.elem(i)) return false;
+    return true;
+  };
+  auto check = [&G, &equal](){
+    for(uint k=0;k<5;k++){
+      rai::String key = STRING('k' <<k);
+      rai::NodeL all, bools;
+      for(rai::Node *n:G) if(n->key==key){ all.append(n); if(n->isOfType<bool>()) bools.append(n); }
+      CHECK(equal(G.findNodes(key), all), "");
+      CHECK(equal(G.findNodesOfType(typeid(bool), key), bools), "");
+      CHECK_EQ(G.findNode(key), (all.N?all.first():nullptr), "");
+    }
+    for(rai::Node *p:G){
+      rai::NodeL children;
+      for(rai::Node *n:G) if(n->parents.N && n->parents.first()==p) children.append(n);
+      rai::NodeL hashed = G.findNodesWithFirstParent(p);
+      CHECK_EQ(hashed.N, children.N, "");
+      for(rai::Node *n:children) CHECK(hashed.contains(n), "");
+    }
+  };
+
+  for(uint i=0;i<300;i++){
+    switch(rnd(4)){
+      case 0: G.newNode<bool>(STRING('k' <<rnd(5)), rndParents(G), true); break;
+      case 1: G.newNode<double>(STRING('k' <<rnd(5)), rndParents(G), 1.); break;
+      case 2: if(G.N){ rai::Node *n=G.rndElem(); if(!n->numChildren) delete n; } break;
+      case 3: if(G.N){ rai::Node *n=G.rndElem(); if(n->parents.N) n->removeParent(n->parents.first()); else if(G.N>1) n->addParent(G.rndElem()); } break;
+    }
+    if(!(i%10)) check();
+  }
+  check();
+
+  //renaming requires a reset
+  for(rai::Node *n:G) n->key = "renamed";
+  G.resetHashIndex();
+  CHECK_EQ(G.findNodes("renamed").N, G.N, "");
+  CHECK(!G.findNode("k0"), "");
+
+  G.index();
+  rai::Graph H = G;
+  G.clear();
+  check();
+  cout <<"** hash index success" <<endl;
+}
+
+//===========================================================================
+
 void TEST(Dot){
   rai::Graph G;
   G <<FILE(filename?filename:"coffee_shop.fg");
@@ -169,6 +223,7 @@ int MAIN(int argc, char** argv){
   testRandom();
   testRead();
   testInit();
+  testHashIndex();
   testDot();
 
   testManual();
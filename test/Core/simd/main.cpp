@@ -0,0 +1,90 @@
+#include <Core/array.h>
+#include <Core/simd.h>
+
+using namespace rai::simd;
+
+//===========================================================================
+//
+// every instruction set the CPU supports has to agree with the plain loops
+//
+
+template<class T> void checkKernels(uint n, double tol){
+  rai::Array<T> x(n), y(n), z(n), r(n);
+  for(uint i=0;i<n;i++){ x.p[i] = T(rnd.gauss()); y.p[i] = T(1.+rnd.uni()); }
+
+  auto checkEq = [&](const rai::Array<T>& a, const rai::Array<T>& b){
+    for(uint i=0;i<n;i++) CHECK_ZERO(double(a.p[i]-b.p[i]), tol, "kernel mismatch at " <<i <<" (n=" <<n <<')');
+  };
+  auto checkScalar = [&](T a, T b){
+    CHECK_ZERO(double(a-b), tol*(1.+std::fabs(double(b))), "reduction mismatch (n=" <<n <<')');
+  };
+
+  z=x; r=x; add(z.p, y.p, n); scalar::add(r.p, y.p, n); checkEq(z, r);
+  z=x; r=x; sub(z.p, y.p, n); scalar::sub(r.p, y.p, n); checkEq(z, r);
+  z=x; r=x; mul(z.p, y.p, n); scalar::mul(r.p, y.p, n); checkEq(z, r);
+  z=x; r=x; div(z.p, y.p, n); scalar::div(r.p, y.p, n); checkEq(z, r);
+  z=x; r=x; add(z.p, T(.5), n); scalar::add(r.p, T(.5), n); checkEq(z, r);
+  z=x; r=x; sub(z.p, T(.5), n); scalar::sub(r.p, T(.5), n); checkEq(z, r);
+  z=x; r=x; mul(z.p, T(3), n); scalar::mul(r.p, T(3), n); checkEq(z, r);
+  z=x; r=x; div(z.p, T(3), n); scalar::div(r.p, T(3), n); checkEq(z, r);
+  sqrt(z.p, y.p, n); scalar::sqrt(r.p, y.p, n); checkEq(z, r);
+  fabs(z.p, x.p, n); scalar::fabs(r.p, x.p, n); checkEq(z, r);
+
+  checkScalar(sum(x.p, n), scalar::sum(x.p, n));
+  checkScalar(sumOfSqr(x.p, n), scalar::sumOfSqr(x.p, n));
+  checkScalar(dot(x.p, y.p, n), scalar::dot(x.p, y.p, n));
+  CHECK_EQ(absMax(x.p, n), scalar::absMax(x.p, n), "");
+}
+
+void TEST(Kernels){
+  InstructionSet best = bestInstructionSet();
+  cout <<"best instruction set: " <<instructionSetName(best) <<endl;
+  for(int is=IS_scalar; is<=best; is++){
+    setInstructionSet(InstructionSet(is));
+    for(uint n : {0u, 1u, 3u, 7u, 8u, 15u, 16u, 17u, 33u, 100u, 1001u}){
+      checkKernels<double>(n, 1e-10);
+      checkKernels<float>(n, 1e-3);
+    }
+  }
+  setInstructionSet(best);
+
+  //the Array operators use the kernels
+  arr a = rand(1000), b = rand(1000);
+  CHECK_ZERO(scalarProduct(a, b) - scalar::dot(a.p, b.p, a.N), 1e-10, "");
+  CHECK_ZERO(sumOfSqr(a-b) - scalar::sumOfSqr((a-b).p, a.N), 1e-10, "");
+}
+
+//===========================================================================
+//
+// timings of the plain loops vs. the vectorized kernels
+//
+
+void TEST(Benchmark){
+  uint n=1<<16, K=2000;
+  arr x=rand(n), y=rand(n);
+  InstructionSet best = bestInstructionSet();
+  for(int is=IS_scalar; is<=best; is++){
+    setInstructionSet(InstructionSet(is));
+    double s=0.;
+    rai::timerStart();
+    for(uint k=0;k<K;k++){ x += y; x *= .5; }
+    double tOps = rai::timerRead(true);
+    for(uint k=0;k<K;k++){ s += scalarProduct(x, y) + sum(x); }
+    double tRed = rai::timerRead(true);
+    cout <<instructionSetName(InstructionSet(is)) <<": elementwise " <<tOps <<"sec, reductions " <<tRed <<"sec  (" <<s <<')' <<endl;
+  }
+  setInstructionSet(best);
+}
+
+//===========================================================================
+
+int MAIN(int argc, char** argv){
+  rai::initCmdLine(argc, argv);
+
+  rnd.clockSeed();
+
+  testKernels();
+  testBenchmark();
+
+  return 0;
+}
@@ -190,6 +190,33 @@ void TEST(Logging){
   t2.threadClose();
 }
 
+//==============================================================================
+//
+// parallel loops with a thread pool
+//
+
+void TEST(ThreadPool){
+  ThreadPool pool(4);
+  uint n=10000;
+  arr y(n);
+  uintA hits(pool.size());
+  hits.setZero();
+  for(uint k=0;k<3;k++){ //the pool is reused
+    y.setZero();
+    pool.parallelFor(n, [&](uint i, uint worker){ y(i) = double(i); hits(worker)++; });
+    CHECK_EQ(sum(y), .5*n*(n-1), "");
+  }
+  cout <<"iterations per worker: " <<hits <<endl;
+  CHECK_EQ(sum(hits), 3*n, "");
+
+  //exceptions in a loop body are rethrown in the caller
+  bool caught=false;
+  try{
+    pool.parallelFor(n, [&](uint i, uint worker){ if(i==n/2) HALT("intended failure"); });
+  }catch(...){ caught=true; }
+  CHECK(caught, "");
+}
+
 //===========================================================================
 
 int MAIN(int argc,char** argv){
@@ -201,6 +228,7 @@ int MAIN(int argc,char** argv){
   testWay0();
   testWay1();
   testLogging();
+  testThreadPool();
 
   return 0;
 }
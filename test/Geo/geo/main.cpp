@@ -1,5 +1,7 @@
 #include <Geo/geo.h>
+#include <Geo/mesh.h>
 #include <Core/array.h>
+#include <Core/simd.h>
 
 //===========================================================================
 //
@@ -55,11 +57,63 @@ void TEST(QuaternionJacobian){
 
 //===========================================================================
 
+void TEST(Batch){
+  //-- the batch operations against the single-pose operations, vectorized and plain
+  for(auto is:{rai::simd::bestInstructionSet(), rai::simd::IS_scalar}) for(uint n:{0u, 1u, 3u, 4u, 7u, 33u}){
+    rai::simd::setInstructionSet(is);
+    rai::Array<rai::Transformation> A(n), B(n);
+    for(uint i=0;i<n;i++){ A(i).setRandom(); B(i).setRandom(); }
+    rai::Transformation X;
+    X.setRandom();
+    arr pts = randn(n, 3);
+
+    //n x 3 points
+    arr P = pts;
+    rai::batch::transformPoints(P.p, n, X);
+    for(uint i=0;i<n;i++) CHECK_ZERO(maxDiff(P[i], conv_vec2arr(X*rai::Vector(pts[i]))), 1e-12, "");
+
+    //3 x n points
+    arr Q = ~pts;
+    if(n) rai::batch::transformPoints(Q[0].p, Q[1].p, Q[2].p, n, X);
+    if(n) CHECK_ZERO(maxDiff(~Q, P), 1e-12, "");
+
+    //3 x n points, each with its own rotation
+    arr rots = rai::batch::getPoses(A)({3,6});
+    Q = ~pts;
+    if(n) rai::batch::rotatePoints(Q[0].p, Q[1].p, Q[2].p, rots.p, n);
+    for(uint i=0;i<n;i++) CHECK_ZERO(maxDiff(Q.col(i), conv_vec2arr(A(i).rot*rai::Vector(pts[i]))), 1e-12, "");
+
+    //7 x n poses, also in place
+    arr Za = rai::batch::getPoses(A), Zb = rai::batch::getPoses(B), Z(7, n);
+    rai::batch::compose(Z.p, Za.p, Zb.p, n);
+    rai::batch::compose(Za.p, Za.p, Zb.p, n);
+    CHECK_EQ(Z, Za, "");
+    rai::Array<rai::Transformation> C;
+    rai::batch::setPoses(C, Z);
+    for(uint i=0;i<n;i++) CHECK_ZERO(maxDiff(C(i).getArr7d(), (A(i)*B(i)).getArr7d()), 1e-12, "");
+  }
+
+  rai::simd::setInstructionSet(rai::simd::bestInstructionSet());
+
+  //mesh transforms against the former matrix product
+  rai::Mesh M;
+  M.setSSCvx(randn(20, 3), .1);
+  arr V = M.V;
+  rai::Transformation X;
+  X.setRandom();
+  M.transform(X);
+  CHECK_ZERO(maxDiff(M.V, V*~X.rot.getArr() + repmat(~conv_vec2arr(X.pos), V.d0, 1)), 1e-12, "");
+  cout <<"batch geo operations -- SUCCESS" <<endl;
+}
+
+//===========================================================================
+
 int MAIN(int argc,char **argv){
   rai::initCmdLine(argc, argv);
 
   testBasics();
   testQuaternionJacobian();
+  testBatch();
 
   return 0;
 }
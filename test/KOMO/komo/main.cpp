@@ -253,6 +253,214 @@ void TEST(Threading) {
 
 //===========================================================================
 
+void TEST(SecondOrderKinematics){
+  //-- an orientation-heavy IK problem, solved with Gauss-Newton and with the exact feature Hessians
+  rai::Configuration C("arm.g");
+  arr q0 = C.getJointState();
+  for(bool secondOrder:{false, true}){
+    C.setJointState(q0);
+    KOMO komo;
+    komo.opt.secondOrderKinematics = secondOrder;
+    komo.setModel(C, false);
+    komo.setTiming(1., 1, 1., 1);
+    komo.add_qControlObjective({}, 1, 1e-1);
+    komo.addQuaternionNorms({}, 1e1);
+    komo.addObjective({}, FS_positionDiff, {"endeff", "target"}, OT_sos, {1e1});
+    komo.addObjective({}, FS_scalarProductXZ, {"endeff", "stem"}, OT_sos, {1e1}, {.5});
+    komo.addObjective({}, FS_quaternionDiff, {"endeff", "target"}, OT_sos, {1e0});
+    uint count = rai::Configuration::setJointStateCount;
+    komo.optimize();
+    cout <<"second-order kinematics: " <<secondOrder <<" evaluations: " <<rai::Configuration::setJointStateCount-count
+         <<" sos: " <<komo.sos <<endl;
+    CHECK_LE(komo.sos, .2, "");
+  }
+}
+
+//===========================================================================
+
+void TEST(SolverSession){
+  //-- receding horizon: the target moves, each cycle executes the first step, shifts and re-solves
+  rai::Configuration C("arm.g");
+  arr q0 = C.getJointState();
+  arr target0 = C["target"]->getPosition();
+  rai::OptOptions options = rai::OptOptions().set_stopTolerance(1e-3);
+  arr evals(2);
+  for(bool useSession:{false, true}){
+    C.setJointState(q0);
+    C["target"]->setPosition(target0);
+    KOMO komo;
+    komo.opt.solverSession = useSession;
+    komo.runTimesCapacity = 8; //latency percentiles of the last 8 cycles only
+    komo.setModel(C, false);
+    komo.setTiming(1., 10, 1., 2);
+    komo.add_qControlObjective({}, 2, 1.);
+    komo.addQuaternionNorms({}, 1e1);
+    komo.addObjective({1.}, FS_positionDiff, {"endeff", "target"}, OT_eq, {1e1});
+    komo.addObjective({1.}, FS_qItself, {}, OT_eq, {1e1}, {}, 1);
+    komo.optimize(0., options);
+    evals(useSession) = rai::Configuration::setJointStateCount; //(reset by each run)
+    for(uint k=0; k<20; k++){
+      C.setJointState(komo.getConfiguration_qOrg(0));
+      C["target"]->setPosition(target0 + arr{0., .01*k, .005*k});
+      if(useSession) komo.shiftSolution();
+      komo.updateAndShiftPrefix(C);
+      komo.optimize(0., options);
+      evals(useSession) += rai::Configuration::setJointStateCount;
+      CHECK_LE(komo.eq, 1e-2, "");
+    }
+    rai::Graph report = komo.getReport();
+    rai::Graph& latency = report.get<rai::Graph>("latency");
+    CHECK_EQ(latency.get<double>("runs"), 21., "");
+    CHECK_EQ(latency.get<double>("window"), 8., "");
+    cout <<"solver session: " <<useSession <<" evaluations: " <<evals(useSession) <<" eq: " <<komo.eq <<" latency: " <<latency <<endl;
+    if(useSession) CHECK(komo.session, "");
+  }
+  CHECK_LE(evals(1), evals(0), "warm started sessions should not need more evaluations");
+}
+
+//===========================================================================
+
+void TEST(MultiStart){
+  //-- an IK problem with an obstacle, solved from several noisy initializations on cloned KOMOs
+  rai::Configuration C("arm.g");
+  KOMO komo;
+  komo.setModel(C, false);
+  komo.setTiming(1., 1, 1., 1);
+  komo.add_qControlObjective({}, 1, 1e-1);
+  komo.addQuaternionNorms({}, 1e1);
+  komo.addObjective({}, FS_positionDiff, {"endeff", "target"}, OT_eq, {1e1});
+  komo.addObjective({}, FS_distance, {"arm3", "obstacle"}, OT_ineq, {1e1});
+  komo.addObjective({}, FS_distance, {"arm5", "obstacle"}, OT_ineq, {1e1});
+  komo.run_prepare(0.);
+
+  MP_Solver S;
+  S.setProblem(komo.mp_SparseNonFactored()).setOptions(rai::OptOptions().set_stopTolerance(1e-3));
+  S.setMultiStart(8, 1e-1, 4);
+  auto ret = S.solve();
+  cout <<"multi-start: " <<*ret <<endl;
+  CHECK(ret->feasible, "");
+}
+
+//===========================================================================
+
+void TEST(ParallelEvaluation){
+  //-- a multi-step problem with collision features (pairwise distances of all links to the obstacle, in every time
+  //   slice): the objectives evaluated on the worker pool give exactly the serial phi and J, and the same solution
+  rai::Configuration C("arm.g");
+  StringA links = {"arm1", "arm2", "arm3", "arm4", "arm5", "arm6", "arm7"};
+  KOMO komo[2];
+  for(uint k=0; k<2; k++){
+    komo[k].opt.evalThreads = k ? 4 : 0;
+    komo[k].opt.verbose = 0;
+    komo[k].setModel(C, false);
+    komo[k].setTiming(1., 20, 1., 2);
+    komo[k].add_qControlObjective({}, 2, 1.);
+    komo[k].addQuaternionNorms({}, 1e1);
+    komo[k].addObjective({1.}, FS_positionDiff, {"endeff", "target"}, OT_eq, {1e1});
+    for(const rai::String& link:links) komo[k].addObjective({}, FS_distance, {link, "obstacle"}, OT_ineq, {1e1});
+    komo[k].run_prepare(0.);
+  }
+  auto serial = komo[0].mp_SparseNonFactored(), parallel = komo[1].mp_SparseNonFactored();
+  arr x0 = komo[0].x;
+  for(uint i=0; i<10; i++){
+    arr x = x0 + .1*randn(x0.N);
+    arr phi0, J0, phi1, J1;
+    serial->evaluate(phi0, J0, x);
+    parallel->evaluate(phi1, J1, x);
+    CHECK_EQ(phi0, phi1, "parallel phi differs from serial");
+    CHECK_EQ(unpack(J0), unpack(J1), "parallel J differs from serial");
+  }
+
+  rai::OptOptions options = rai::OptOptions().set_stopTolerance(1e-3);
+  for(uint k=0; k<2; k++){ komo[k].set_x(x0); komo[k].optimize(0., options); }
+  cout <<"parallel evaluation: sos: " <<komo[1].sos <<" ineq: " <<komo[1].ineq <<" eq: " <<komo[1].eq <<endl;
+  CHECK_EQ(komo[0].x, komo[1].x, "parallel and serial solutions differ");
+}
+
+//===========================================================================
+
+void TEST(CollisionThreads){
+  //-- a multi-step problem with (FCL) collisions: querying the time slices on several collision workers gives the
+  //   same proxies, the same phi and J, and the same solution as the serial queries
+  rai::Configuration C("arm.g");
+  KOMO komo[2];
+  for(uint k=0; k<2; k++){
+    komo[k].opt.collisionThreads = k ? 4 : 0;
+    komo[k].opt.verbose = 0;
+    komo[k].setModel(C, true);
+    komo[k].setTiming(1., 20, 1., 2);
+    komo[k].add_qControlObjective({}, 2, 1.);
+    komo[k].addQuaternionNorms({}, 1e1);
+    komo[k].addObjective({1.}, FS_positionDiff, {"endeff", "target"}, OT_eq, {1e1});
+    komo[k].addObjective({}, FS_accumulatedCollisions, {}, OT_eq, {1e0});
+    komo[k].run_prepare(0.);
+  }
+  CHECK(komo[1].collisionPool, "");
+  auto serial = komo[0].mp_SparseNonFactored(), parallel = komo[1].mp_SparseNonFactored();
+  arr x0 = komo[0].x;
+  for(uint i=0; i<10; i++){
+    arr x = x0 + .3*randn(x0.N);
+    arr phi0, J0, phi1, J1;
+    serial->evaluate(phi0, J0, x);
+    parallel->evaluate(phi1, J1, x);
+    const rai::Array<rai::Proxy>& P0 = komo[0].pathConfig.proxies, &P1 = komo[1].pathConfig.proxies;
+    CHECK_EQ(P0.N, P1.N, "different number of proxies");
+    for(uint p=0; p<P0.N; p++){
+      CHECK_EQ(P0(p).a->ID, P1(p).a->ID, "");
+      CHECK_EQ(P0(p).b->ID, P1(p).b->ID, "");
+    }
+    CHECK_EQ(phi0, phi1, "parallel collision queries change phi");
+    CHECK_EQ(unpack(J0), unpack(J1), "parallel collision queries change J");
+  }
+
+  rai::OptOptions options = rai::OptOptions().set_stopTolerance(1e-3);
+  for(uint k=0; k<2; k++){ komo[k].set_x(x0); komo[k].optimize(0., options); }
+  cout <<"collision threads: sos: " <<komo[1].sos <<" eq: " <<komo[1].eq <<endl;
+  CHECK_EQ(komo[0].x, komo[1].x, "parallel and serial collision queries give different solutions");
+}
+
+//===========================================================================
+
+void TEST(CollisionCache){
+  //-- the per time slice collision cache: cleared by reset (re-solving gives the same solution), and invalidated by
+  //   contact changes
+  rai::Configuration C("arm.g");
+  KOMO komo;
+  komo.opt.verbose = 0;
+  komo.setModel(C, true);
+  komo.setTiming(1., 10, 1., 2);
+  komo.add_qControlObjective({}, 2, 1.);
+  komo.addQuaternionNorms({}, 1e1);
+  komo.addObjective({1.}, FS_positionDiff, {"endeff", "target"}, OT_eq, {1e1});
+  komo.addObjective({}, FS_accumulatedCollisions, {}, OT_eq, {1e0});
+  rai::OptOptions options = rai::OptOptions().set_stopTolerance(1e-3);
+  komo.run_prepare(0.);
+  arr x0 = komo.x;
+  komo.optimize(0., options);
+  arr x1 = komo.x;
+
+  komo.reset();
+  CHECK(!komo.collisionStatesCache.N && !komo.collisionPairsCache.N, "reset clears the collision cache");
+  komo.set_x(x0);
+  komo.optimize(0., options);
+  cout <<"collision cache: queries: " <<komo.collisionSliceQueries <<" hits: " <<komo.collisionSliceCacheHits <<endl;
+  CHECK_ZERO(maxDiff(komo.x, x1), 1e-10, "re-solving after reset gives a different solution");
+
+  //same state: all slices hit
+  uint hits = komo.collisionSliceCacheHits;
+  komo.set_x(komo.x);
+  CHECK_EQ(komo.collisionSliceCacheHits, hits+komo.T, "");
+
+  //same state, but changed contacts: all slices are queried again
+  hits = komo.collisionSliceCacheHits;
+  for(rai::Frame* f:komo.pathConfig.frames) if(f->name=="obstacle") f->setContact(0);
+  komo.set_x(komo.x);
+  CHECK_EQ(komo.collisionSliceCacheHits, hits, "contact changes invalidate the collision cache");
+  for(const rai::Proxy& p:komo.pathConfig.proxies) CHECK(p.a->name!="obstacle" && p.b->name!="obstacle", "");
+}
+
+//===========================================================================
+
 int main(int argc,char** argv){
   rai::initCmdLine(argc,argv);
 
@@ -263,6 +471,12 @@ int main(int argc,char** argv){
   testThin();
   testPR2();
   testThreading();
+  testSecondOrderKinematics();
+  testSolverSession();
+  testMultiStart();
+  testParallelEvaluation();
+  testCollisionThreads();
+  testCollisionCache();
 
   return 0;
 }
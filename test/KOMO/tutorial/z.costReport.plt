@@ -0,0 +1,8 @@
+set key autotitle columnheader
+set title 'costReport ( plotting sqrt(costs) )'
+plot 'z.costReport' \
+      u (($0+1)/20):1 w l lw 3 lc 1 lt 1 \
+  ,'' u (($0+1)/20):2 w l lw 3 lc 2 lt 1 \
+  ,'' u (($0+1)/20):3 w l \
+  ,'' u (($0+1)/20):4 w l \
+
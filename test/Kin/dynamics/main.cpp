@@ -1,4 +1,6 @@
 #include <Kin/kin.h>
+#include <Kin/kin_feather.h>
+#include <Kin/frame.h>
 #include <Kin/kin_swift.h>
 #include <Kin/kin_ode.h>
 #include <Algo/spline.h>
@@ -95,10 +97,120 @@ void TEST(Dynamics){
 
 // =============================================================================
 
+//a chain of boxes, each attached to its predecessor by a joint of given type (joints listed in 'noLink' carry no box)
+void buildChain(rai::Configuration& C, const rai::Array<rai::JointType>& types, const uintA& noLink={}){
+  rai::Frame *prev = C.addFrame("base");
+  for(uint i=0;i<types.N;i++){
+    rai::Frame *j = C.addFrame(STRING("joint"<<i), prev->name);
+    j->setJoint(types(i));
+    prev = j;
+    if(noLink.contains(i)) continue;
+    rai::Frame *l = C.addFrame(STRING("link"<<i), j->name);
+    l->setRelativePosition({.05, 0., .2});
+    l->setShape(rai::ST_box, {.06, .08, .2});
+    l->setMass(1.);
+    l->inertia->defaultInertiaByShape();
+    l->inertia->com.set(.02, -.01, .1);
+    prev = l;
+  }
+}
+
+//kinetic and potential energy, and mass matrix & gravity forces, computed from the kinematic Jacobians
+double jacobianEnergy(rai::Configuration& C, const arr& qd, arr& M, arr& G){
+  arr y, Jpos, Jang;
+  M = zeros(qd.N, qd.N);
+  G = zeros(qd.N);
+  double E=0.;
+  for(rai::Frame *f:C.frames) if(f->inertia){
+    double m = f->inertia->mass;
+    C.kinematicsPos(y, Jpos, f, f->inertia->com);
+    C.jacobian_angular(Jang, f);
+    arr R = f->ensure_X().rot.getArr();
+    arr I = R * f->inertia->matrix.getArr() * ~R;
+    M += m*(~Jpos*Jpos) + ~Jang*I*Jang;
+    G += m*(~Jpos*arr{0., 0., -9.81});
+    E += 9.81*m*y(2);
+  }
+  return E + .5*scalarProduct(qd, M*qd);
+}
+
+void TEST(ABA){
+  rai::Configuration C;
+  buildChain(C, {rai::JT_free, rai::JT_hingeX, rai::JT_quatBall, rai::JT_transXYPhi, rai::JT_phiTransXY,
+                 rai::JT_XBall, rai::JT_trans3, rai::JT_transXY, rai::JT_hingeY, rai::JT_transZ});
+  uint n = C.getJointStateDimension();
+  arr q = C.getJointState();
+  rndGauss(q, .3, true);
+  C.setJointState(q);
+
+  //at rest, the accelerations must solve M qdd = G
+  arr qdd, M, G;
+  C.fwdDynamics(qdd, zeros(n), zeros(n));
+  jacobianEnergy(C, zeros(n), M, G);
+  double err = maxDiff(M*qdd, G);
+  cout <<"ABA at rest: |M qdd - G| = " <<err <<endl;
+  CHECK_LE(err, 1e-8, "ABA inconsistent with the Jacobian mass matrix");
+
+  //free swing conserves energy
+  arr qd = randn(n);
+  double E0 = jacobianEnergy(C, qd, M, G);
+  for(uint t=0;t<200;t++) C.stepDynamics(qd, zeros(n), .001);
+  double E1 = jacobianEnergy(C, qd, M, G);
+  cout <<"ABA free swing: energy " <<E0 <<" -> " <<E1 <<endl;
+  CHECK_LE(fabs(E1-E0), 1e-4*(1.+fabs(E0)), "ABA does not conserve energy");
+
+  //universal and transYPhi (which have no kinematic Jacobians) equal their decomposition into 1-dof joints
+  rai::Configuration A, B;
+  buildChain(A, {rai::JT_hingeX, rai::JT_universal, rai::JT_transYPhi, rai::JT_hingeY});
+  buildChain(B, {rai::JT_hingeX, rai::JT_hingeX, rai::JT_hingeY, rai::JT_transY, rai::JT_hingeZ, rai::JT_hingeY}, {1, 3});
+  n = A.getJointStateDimension();
+  q = randn(n);
+  qd = randn(n);
+  arr tau = randn(n), qdd_A, qdd_B;
+  A.setJointState(q);
+  B.setJointState(q);
+  A.fwdDynamics(qdd_A, qd, tau);
+  B.fwdDynamics(qdd_B, qd, tau);
+  cout <<"ABA composite joints: difference " <<maxDiff(qdd_A, qdd_B) <<endl;
+  CHECK_LE(maxDiff(qdd_A, qdd_B), 1e-8, "ABA composite joints inconsistent");
+}
+
+// =============================================================================
+
+void TEST(ABABenchmark){
+  for(uint n:{7, 30, 100}){
+    rai::Configuration C;
+    rai::Array<rai::JointType> types(n);
+    for(uint i=0;i<n;i++) types(i) = (i%2 ? rai::JT_hingeY : rai::JT_hingeX);
+    buildChain(C, types);
+    arr q = C.getJointState();
+    rndGauss(q, .3, true);
+    C.setJointState(q);
+    arr qd = randn(n), tau = randn(n), qdd_aba, qdd_mf;
+
+    uint K = 2000/n;
+    C.fs().useABA=true;
+    rai::timerRead(true);
+    for(uint k=0;k<K;k++) C.fwdDynamics(qdd_aba, qd, tau);
+    double t_aba = rai::timerRead(true)/K;
+    C.fs().useABA=false;
+    for(uint k=0;k<K;k++) C.fwdDynamics(qdd_mf, qd, tau);
+    double t_mf = rai::timerRead(true)/K;
+
+    double err = maxDiff(qdd_aba, qdd_mf)/(1.+absMax(qdd_mf));
+    cout <<n <<"-DOF chain: ABA " <<1e6*t_aba <<"us, mass matrix inversion " <<1e6*t_mf <<"us, rel. difference " <<err <<endl;
+    CHECK_LE(err, 1e-6, "ABA and mass matrix inversion disagree");
+  }
+}
+
+// =============================================================================
+
 int MAIN(int argc,char **argv){
   rai::initCmdLine(argc, argv);
 
   testDynamics();
+  testABA();
+  testABABenchmark();
 
   return 0;
 }
@@ -70,6 +70,7 @@ void testFeature() {
   F.append(symbols2feature(FS_poseDiff, {"obj1", "obj2"}, C)) ->setOrder(0);
   F.append(symbols2feature(FS_poseDiff, {"obj1", "obj2"}, C)) ->setOrder(1);
   F.append(symbols2feature(FS_poseDiff, {"obj1", "obj2"}, C)) ->setOrder(2);
+  F.append(symbols2feature(FS_vectorZRel, {"obj1", "obj2"}, C));
   F.append(symbols2feature(FS_insideBox, {"obj1", "obj2"}, C)) ->setOrder(0);
   F.append(make_shared<F_NewtonEuler>()) ->setFrameIDs({"obj1"}, C);
   F.append(make_shared<F_fex_POA>()) ->setFrameIDs({"obj1", "obj2"}, C);
@@ -105,12 +106,158 @@ void testFeature() {
 
 //===========================================================================
 
+/// two chains covering all joint types with analytic Jacobians
+void addTwoChains(rai::Configuration& C){
+  C.addFrame("world");
+  rai::Frame *f = C.addFrame("a1", "world");  f->setRelativePosition({.1,.2,.3});  f->setJoint(rai::JT_hingeX);
+  f = C.addFrame("a2", "a1");  f->setRelativePosition({.3,-.1,.2});  f->setJoint(rai::JT_quatBall);
+  f = C.addFrame("a3", "a2");  f->setRelativePosition({.2,.1,-.1});  f->setJoint(rai::JT_transXYPhi);
+  f = C.addFrame("a4", "a3");  f->setRelativePosition({-.1,.3,.2});  f->setJoint(rai::JT_hingeY);
+  f = C.addFrame("a5", "a4");  f->setRelativePosition({.1,.1,.4});  f->setJoint(rai::JT_transZ);
+  f = C.addFrame("b1", "world");  f->setRelativePosition({-.3,.2,.1});  f->setJoint(rai::JT_free);
+  f = C.addFrame("b2", "b1");  f->setRelativePosition({.2,.1,.3});  f->setJoint(rai::JT_phiTransXY);
+  f = C.addFrame("b3", "b2");  f->setRelativePosition({.1,-.2,.2});  f->setJoint(rai::JT_XBall);
+  f = C.addFrame("b4", "b3");  f->setRelativePosition({.3,.1,.1});  f->setJoint(rai::JT_trans3);
+  f = C.addFrame("b5", "b4");  f->setRelativePosition({.1,.2,.3});  f->setJoint(rai::JT_hingeZ);
+}
+
+void testFeatureHessians() {
+  rai::Configuration C;
+  addTwoChains(C);
+  C.jacMode = rai::Configuration::JM_dense;
+  uint n = C.getJointStateDimension();
+
+  rai::Array<std::shared_ptr<Feature>> F;
+  F.append(symbols2feature(FS_position, {"a5"}, C));
+  F.append(symbols2feature(FS_positionDiff, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_positionRel, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_gazeAt, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_vectorZ, {"b5"}, C));
+  F.append(symbols2feature(FS_vectorZDiff, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_vectorXRel, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_vectorZRel, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_scalarProductXZ, {"a5", "b5"}, C));
+  F.append(make_shared<F_Matrix>()) ->setFrameIDs({"a5"}, C);
+  F.append(make_shared<F_MatrixDiff>()) ->setFrameIDs({"a5", "b5"}, C);
+  F.append(symbols2feature(FS_quaternion, {"b5"}, C));
+  F.append(symbols2feature(FS_quaternionDiff, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_quaternionRel, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_pose, {"a4"}, C));
+  F.append(symbols2feature(FS_poseDiff, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_poseRel, {"a5", "b5"}, C, {2.}, {.1, .2, .3, 1., 0., 0., 0.}));
+
+  rai_Kin_frame_ignoreQuatNormalizationWarning=true;
+
+  for(uint k=0;k<20;k++){
+    arr x = C.getJointState() + .5*(rand(n)-.5);
+
+    for(ptr<Feature>& f: F){
+      FrameL frames = f->getFrames(C);
+      C.setJointState(x);
+      arr y = f->eval(frames);
+      rai::HessianBlock h;
+      CHECK(f->evalHessian(h, frames), "");
+      CHECK_ZERO(maxDiff(h.y, y), 1e-10, "");
+      arr J = zeros(y.N, n);
+      for(uint i=0; i<h.dofs.N; i++) for(uint r=0; r<y.N; r++) J(r, h.dofs(i)) += h.J(r, i);
+      CHECK_ZERO(maxDiff(J, y.J()), 1e-10, "");
+
+      //-- the Hessian of a random weighting of the feature, against finite differences of its Jacobian
+      arr w = randn(y.N);
+      ScalarFunction fw = [&C, &f, &frames, &w, n](arr& g, arr& H, const arr& x) -> double {
+        C.setJointState(x);
+        rai::HessianBlock h;
+        f->evalHessian(h, frames);
+        arr wJ = comp_At_x(h.J, w);
+        g = zeros(n);
+        for(uint i=0; i<h.dofs.N; i++) g(h.dofs(i)) += wJ(i);
+        if(!!H) { H = zeros(n, n);  h.addWeighted(H, w); }
+        return scalarProduct(w, h.y);
+      };
+      cout <<k <<std::setw(30) <<f->shortTag(C) <<' ';
+      CHECK(checkHessian(fw, x, 1e-4), "Hessian of '" <<f->shortTag(C) <<"' is wrong");
+    }
+  }
+}
+
+//===========================================================================
+
+void testKinematicsMemo() {
+  //-- features that repeatedly query the same frames return the same with and without the memo
+  rai::Configuration C;
+  addTwoChains(C);
+  uint n = C.getJointStateDimension();
+
+  rai::Array<std::shared_ptr<Feature>> F;
+  F.append(symbols2feature(FS_position, {"a5"}, C));
+  F.append(symbols2feature(FS_positionDiff, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_positionRel, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_vectorZ, {"b5"}, C));
+  F.append(symbols2feature(FS_scalarProductXZ, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_quaternion, {"b5"}, C));
+  F.append(symbols2feature(FS_quaternionDiff, {"a5", "b5"}, C));
+  F.append(symbols2feature(FS_poseDiff, {"a5", "b5"}, C));
+
+  rai_Kin_frame_ignoreQuatNormalizationWarning=true;
+
+  for(auto jacMode:{rai::Configuration::JM_dense, rai::Configuration::JM_sparse}){
+    C.jacMode = jacMode;
+    for(uint k=0;k<10;k++){
+      arr x = C.getJointState() + .5*(rand(n)-.5);
+      for(bool memo:{false, true, true}){
+        C.useKinematicsMemo = memo;
+        C.setJointState(x);
+        for(ptr<Feature>& f: F){
+          arr y = f->eval(f->getFrames(C));
+          C.useKinematicsMemo = false;
+          arr y0 = f->eval(f->getFrames(C));
+          C.useKinematicsMemo = memo;
+          CHECK_ZERO(maxDiff(y, y0), 1e-10, "");
+          arr J = y.J(), J0 = y0.J();
+          if(isSpecial(J)) { J = unpack(J);  J0 = unpack(J0); }
+          CHECK_ZERO(maxDiff(J, J0), 1e-10, "");
+        }
+      }
+    }
+  }
+  cout <<"kinematics memo hits: " <<C.kinematicsMemoHits <<'/' <<C.kinematicsMemoQueries <<endl;
+  CHECK(C.kinematicsMemoHits>0, "");
+
+  //-- changing the active DOFs (which does not touch the state revision until q is re-indexed) must not hit a stale entry
+  C.useKinematicsMemo = true;
+  arr y, J;
+  C.kinematicsPos(y, J, C["a5"]);
+  C.selectJoints({C["a3"], C["a4"], C["a5"]});
+  C.kinematicsPos(y, J, C["a5"]);
+  CHECK_EQ(J.d1, C.getJointStateDimension(), "stale kinematics memo entry");
+
+  //-- renumbering the frames (sortFrames) must not serve an entry of the frame that had this ID before
+  rai::Configuration C2;
+  rai::Frame *b = C2.addFrame("b");
+  rai::Frame *a = C2.addFrame("a");
+  a->setPosition({1., 0., 0.});
+  b->setParent(a).setRelativePosition({0., 1., 0.}); //the child has the lower ID: sortFrames swaps the IDs
+  C2.useKinematicsMemo = true;
+  arr ya, yb;
+  C2.kinematicsPos(ya, J, C2["a"]);
+  C2.kinematicsPos(yb, J, C2["b"]);
+  C2.sortFrames();
+  C2.kinematicsPos(y, J, C2["a"]);
+  CHECK_ZERO(maxDiff(y, ya), 1e-10, "stale kinematics memo entry after sortFrames");
+  C2.kinematicsPos(y, J, C2["b"]);
+  CHECK_ZERO(maxDiff(y, yb), 1e-10, "stale kinematics memo entry after sortFrames");
+}
+
+//===========================================================================
+
 int MAIN(int argc, char** argv){
   rai::initCmdLine(argc, argv);
 
   rnd.clockSeed();
 
   testFeature();
+  testFeatureHessians();
+  testKinematicsMemo();
 
   return 0;
 }
@@ -119,6 +119,104 @@ void TEST(Kinematics){
   }
 }
 
+//===========================================================================
+
+void TEST(SparseJacobians){
+  //sparse (triplet) and dense Jacobians of the kinematics primitives have to agree
+  for(const char* file:{"arm7.g", "kinematicTests.g"}){
+    rai::Configuration C(file);
+    C.setJointState(.5*rand(C.getJointStateDimension()));
+    rai::Vector rel(.1, .2, .3);
+    for(rai::Frame *f:C.frames){
+      arr y, J, Js;
+      C.jacMode = C.JM_dense;
+      C.kinematicsPos(y, J, f, rel);
+      C.jacMode = C.JM_sparse;
+      C.kinematicsPos(y, Js, f, rel);
+      CHECK(isSparseMatrix(Js), "");
+      CHECK_ZERO(maxDiff(J, Js.sparse().unsparse()), 1e-10, "sparse kinematicsPos of '" <<f->name <<"' differs");
+
+      C.jacMode = C.JM_dense;
+      C.kinematicsQuat(y, J, f);
+      C.jacMode = C.JM_sparse;
+      C.kinematicsQuat(y, Js, f);
+      CHECK_ZERO(maxDiff(J, Js.sparse().unsparse()), 1e-10, "sparse kinematicsQuat of '" <<f->name <<"' differs");
+    }
+  }
+
+  //the number of entries only depends on the chain, not on the size of the configuration
+  rai::Configuration C("arm7.g");
+  rai::Frame *f = C.frames.last();
+  arr y, J;
+  C.jacMode = C.JM_sparse;
+  C.kinematicsPos(y, J, f);
+  uint nnz = J.N;
+  for(uint t=0;t<10;t++) C.addCopies(FrameL(C.frames), C.dofs); //1024 arms
+  C.jacMode = C.JM_sparse;
+  C.kinematicsPos(y, J, f);
+  CHECK_EQ(J.N, nnz, "");
+  CHECK_EQ(J.d1, C.getJointStateDimension(), "");
+
+  rai::timerStart();
+  for(uint k=0;k<10000;k++) C.kinematicsPos(y, J, f);
+  double t_sparse = rai::timerRead(true);
+  C.jacMode = C.JM_dense;
+  arr Jdense;
+  for(uint k=0;k<1000;k++) C.kinematicsPos(y, Jdense, f);
+  double t_dense = 10.*rai::timerRead();
+  cout <<"kinematicsPos on " <<C.getJointStateDimension() <<" dofs: sparse " <<t_sparse/1e-2 <<"us, dense " <<t_dense/1e-2 <<"us" <<endl;
+
+  cout <<"** sparse Jacobians success" <<endl;
+}
+
+//===========================================================================
+
+void TEST(BatchForwardKinematics){
+  for(const char* file:{"arm7.g", "kinematicTests.g"}){
+    rai::Configuration K(file);
+    uint n=K.getJointStateDimension();
+    uintA frames = {0, K.frames.N/2, K.frames.N-1};
+    arr Q = randn(20, n);
+    Q *= .5;
+    for(uint s=0;s<Q.d0;s++) for(rai::Frame *f:K.frames) if(f->joint && f->joint->dim==4 && !f->joint->mimic){ //normalized quaternion dofs
+      arr q = Q[s]({f->joint->qIndex, f->joint->qIndex+3});
+      q /= length(q);
+      Q[s]({f->joint->qIndex, f->joint->qIndex+3}) = q;
+    }
+
+    arr J, J2;
+    arr X = K.batchForwardKinematics(Q, frames, J, 0);
+    arr X2 = K.batchForwardKinematics(Q, frames, J2, 4);
+    CHECK_EQ(X, X2, "threaded result differs");
+    CHECK_EQ(J, J2, "threaded Jacobians differ");
+
+    //compare with setting each joint state
+    K.jacMode = rai::Configuration::JM_dense;
+    for(uint s=0;s<Q.d0;s++){
+      K.setJointState(Q[s]);
+      CHECK_ZERO(maxDiff(X[s], K.getFrameState(frames)), 1e-10, "");
+      for(uint k=0;k<frames.N;k++){
+        arr y, Jpos, Jquat;
+        K.kinematicsPos(y, Jpos, K.frames(frames(k)));
+        K.kinematicsQuat(y, Jquat, K.frames(frames(k)));
+        CHECK_ZERO(maxDiff(J[s][k], (Jpos, Jquat).reshape(7, n)), 1e-10, "");
+      }
+    }
+  }
+
+  //throughput on a 7-dof arm
+  rai::Configuration K("arm7.g");
+  arr Q = randn(100000, K.getJointStateDimension());
+  uintA frames = {K["endeff"]->ID};
+  double time = -rai::realTime(); //wall clock, as cpuTime sums over all threads
+  arr X = K.batchForwardKinematics(Q, frames);
+  time += rai::realTime();
+  double timeLoop = -rai::realTime();
+  for(uint s=0;s<1000;s++){ K.setJointState(Q[s]); K.getFrameState(frames); }
+  timeLoop += rai::realTime();
+  cout <<"batch FK: " <<Q.d0/time <<" queries/sec (setJointState loop: " <<1000./timeLoop <<" queries/sec)" <<endl;
+}
+
 //===========================================================================
 //
 // Graph export test
@@ -200,6 +298,287 @@ void TEST(Copy){
   cout <<"** copy operator success" <<endl;
 }
 
+//===========================================================================
+//
+// copies share meshes and attributes until one side modifies them
+//
+
+void TEST(CopyOnWrite){
+  rai::Configuration C;
+  rai::Frame *obj = C.addFrame("obj");
+  obj->setShape(rai::ST_mesh, {});
+  obj->getShape().set_mesh().setSphere(5);
+  obj->addAttribute("friction", .5);
+  rai::Frame *box = C.addFrame("box", "obj");
+  box->setShape(rai::ST_box, {.1, .2, .3});
+  arr color = obj->shape->mesh().C, boxV = box->shape->mesh().V;
+
+  //a KOMO-like path configuration: all copies share the payloads
+  rai::Configuration path;
+  rai::timerRead(true);
+  for(uint t=0;t<100;t++) path.addCopies(C.frames, C.dofs);
+  double time = rai::timerRead(true);
+  cout <<"100 copies of a " <<obj->shape->mesh().V.d0 <<"-vertex mesh: " <<time <<"sec" <<endl;
+  CHECK_EQ(obj->shape->_mesh.use_count(), 101, "copies don't share the mesh");
+  CHECK_EQ(path.frames.elem(0)->ats, obj->ats, "copies don't share the attributes");
+
+  //modifications detach the modified copy only
+  rai::Configuration C2(C);
+  C2["obj"]->setColor({1., 0., 0.});
+  C2["obj"]->addAttribute("mass", 2.);
+  C2["box"]->setShape(rai::ST_box, {.3, .3, .3});
+  CHECK(C2["obj"]->shape->_mesh != obj->shape->_mesh, "setColor did not detach the mesh");
+  CHECK_ZERO(maxDiff(obj->shape->mesh().C, color), 1e-10, "setColor on a copy changed the original");
+  CHECK(!obj->ats->getNode("mass"), "addAttribute on a copy changed the original");
+  CHECK(C2["obj"]->ats->getNode("mass") && C2["obj"]->ats->getNode("friction"), "");
+  rai::Configuration C4(C);
+  C4["obj"]->set_ats().getNew<int>("label") = 3;
+  CHECK(!obj->ats->getNode("label"), "set_ats on a copy changed the original");
+  CHECK_EQ(C4["obj"]->ats->get<int>("label"), 3, "");
+  CHECK_ZERO(maxDiff(box->shape->mesh().V, boxV), 1e-10, "setShape on a copy changed the original");
+  CHECK_EQ(path.frames.elem(0)->shape->_mesh, obj->shape->_mesh, "other copies must still share");
+
+  //derived mesh data is computed on a detached mesh, never on the shared one
+  rai::Configuration C3(C);
+  rai::computeMeshNormals(C3.frames);
+  CHECK(C3["obj"]->shape->_mesh != obj->shape->_mesh, "computeMeshNormals did not detach the mesh");
+  CHECK_EQ(path.frames.elem(0)->shape->_mesh, obj->shape->_mesh, "");
+  cout <<"** copy-on-write success" <<endl;
+}
+
+//===========================================================================
+
+void TEST(FrameNames){
+  rai::Configuration C("kinematicTests.g");
+  uint n=C.frames.N;
+
+  //the hashed lookup has to agree with a linear search for the first frame of that name
+  auto check = [&C](){
+    for(rai::Frame *a:C.frames){
+      rai::Frame *first=0;
+      for(rai::Frame *b:C.frames) if(b->name==a->name){ first=b; break; }
+      CHECK_EQ(C.getFrame(a->name), first, "lookup of '" <<a->name <<"' failed");
+    }
+  };
+  check();
+
+  //-- copies (same names appended)
+  C.addCopies(FrameL(C.frames), C.dofs);
+  CHECK_EQ(C.frames.N, 2*n, "");
+  check();
+
+  //-- appended frames
+  rai::Frame *f = C.addFrame("newFrame", C.frames.first()->name);
+  CHECK_EQ(C["newFrame"], f, "");
+
+  //-- deletion and sorting
+  delete C.frames.elem(0);
+  check();
+  C.sortFrames();
+  check();
+
+  //-- renaming (setName keeps the index valid)
+  C.prefixNames();
+  CHECK(!C.getFrame("newFrame", false), "");
+  check();
+  f->setName("renamed");
+  CHECK_EQ(C["renamed"], f, "");
+  check();
+
+  //-- the first of two frames of the same name is renamed: the second takes over
+  rai::Frame *a=C.frames(1), *b=C.frames(2);
+  a->setName("twin");
+  b->setName("twin");
+  CHECK_EQ(C["twin"], a, "");
+  a->setName("single");
+  CHECK_EQ(C["twin"], b, "");
+  CHECK_EQ(C["single"], a, "");
+  check();
+
+  //-- a subtree renamed with a prefix is found under its new names
+  rai::Frame *r=C.frames(3);
+  rai::String name=r->name;
+  r->prefixSubtree("p_");
+  CHECK_EQ(C.getFrame(STRING("p_" <<name)), r, "");
+  check();
+
+  //-- a frame renamed directly is not returned for its old name (the hit is checked), but found under its new one (a miss rebuilds)
+  b->name = "direct";
+  CHECK(!C.getFrame("twin", false), "stale name index entry");
+  CHECK_EQ(C["direct"], b, "");
+  b->name = "direct2";
+  CHECK_EQ(C["direct2"], b, "");
+  check();
+
+  cout <<"** frame name lookup success" <<endl;
+}
+
+//===========================================================================
+
+void TEST(FramePoses){
+  rai::Configuration C("kinematicTests.g");
+  C.setJointState(rand(C.getJointStateDimension()));
+
+  //the pose arrays have to follow the frames through insertion, deletion and sorting
+  arr X = C.getFrameState();
+  FrameL F = C.frames;
+  auto check = [&C, &X, &F](){
+    CHECK_EQ(C.frameX.N, C.frames.N, "");
+    CHECK_EQ(C.frameQ.N, C.frames.N, "");
+    arr Y = C.getFrameState();
+    for(uint i=0;i<F.N;i++) if(F(i)){
+      CHECK_EQ(C.frames(F(i)->ID), F(i), "");
+      CHECK_ZERO(maxDiff(Y[F(i)->ID], X[i]), 1e-10, "pose of '" <<F(i)->name <<"' changed");
+    }
+  };
+  check();
+
+  new rai::Frame(C.frames.first());
+  check();
+
+  uint i=F.N/2;
+  delete F(i);
+  F(i) = 0;
+  check();
+
+  C.sortFrames();
+  check();
+
+  //setting the joint state moves the frames, resetting it has to restore their poses
+  arr q = C.getJointState();
+  C.setJointState(q+.1);
+  C.setJointState(q);
+  check();
+
+  cout <<"** frame pose arrays success" <<endl;
+}
+
+//===========================================================================
+//
+// forward kinematics pass test
+//
+
+void TEST(FwdPass){
+  //several copies of the same tree: a configuration with several independent root subtrees, like KOMO's path configuration
+  rai::Configuration K("kinematicTests.g");
+  rai::Configuration C;
+  for(uint t=0;t<4;t++) C.addConfiguration(K);
+  C.ensure_X();
+  uint n=C.getJointStateDimension();
+
+  //reference: the poses recursively composed from the root, independent of the pass and the dirty flags
+  std::function<rai::Transformation(rai::Frame*)> fwd = [&fwd](rai::Frame *f){
+    if(!f->parent) return f->get_X();
+    return fwd(f->parent) * f->get_Q();
+  };
+  //pose distance, invariant to the sign of the quaternion
+  auto sqrDiff = [](const rai::Transformation& A, const rai::Transformation& B){ return sqrDistance(A.pos, B.pos) + A.rot.sqrDiff(B.rot); };
+  auto check = [&C, &fwd, &sqrDiff](){
+    for(rai::Frame *f:C.frames) CHECK_ZERO(sqrDiff(f->ensure_X(), fwd(f)), 1e-20, "frame '" <<f->name <<"'");
+  };
+
+  for(uint fkThreads:{0, 4}){
+    C.fkThreads = fkThreads;
+    for(uint k=0;k<10;k++){
+      C.setJointState(.5*randn(n));
+      CHECK(C._state_X_pending, "setting the joint state only flags the joints' frames dirty");
+      check();
+      CHECK(!C._state_X_pending, "");
+
+      //setting a pose explicitly moves the branch below
+      rai::Frame *f = C.frames.elem(rnd(C.frames.N));
+      rai::Transformation X;
+      X.setRandom();
+      f->setPose(X);
+      check();
+      CHECK_ZERO(sqrDiff(f->ensure_X(), X), 1e-20, "");
+
+      //the same for a whole set of frames at once
+      FrameL F = {C.frames.elem(rnd(C.frames.N)), C.frames.elem(rnd(C.frames.N))};
+      if(F(0)==F(1)) F.resizeCopy(1);
+      arr Y = randn(F.N, 7);
+      C.setFrameState(Y, F);
+      for(uint i=0;i<F.N;i++){ X.set(Y[i]);  X.rot.normalize();  CHECK_ZERO(sqrDiff(F(i)->ensure_X(), X), 1e-20, ""); }
+      check();
+
+      //one frame at a time while a pass is pending: each write composes only its parent's chain, no fwd pass in between
+      C.setJointState(.5*randn(n));
+      F = {C.frames.elem(rnd(C.frames.N)), C.frames.elem(rnd(C.frames.N)), C.frames.elem(rnd(C.frames.N))};
+      rai::Array<rai::Transformation> Xs(F.N);
+      for(uint i=0;i<F.N;i++){ Xs(i).setRandom();  F(i)->set_X() = Xs(i); }
+      CHECK(C._state_X_pending, "single frame writes must not run the fwd pass");
+      for(uint i=0;i<F.N;i++){ //a pose holds unless a later write hit the same frame or an ancestor (which moves the branch along)
+        bool moved=false;
+        for(uint j=i+1;j<F.N;j++) for(rai::Frame *a=F(i); a; a=a->parent) if(a==F(j)) moved=true;
+        if(!moved) CHECK_ZERO(sqrDiff(F(i)->ensure_X(), Xs(i)), 1e-20, "frame '" <<F(i)->name <<"'");
+      }
+      check();
+    }
+  }
+
+  //concurrent readers of a pending pass see the same poses as a serial read
+  C.fkThreads=0;
+  {
+    arr q = .5*randn(n);
+    C.setJointState(q);
+    arr X0 = C.getFrameState();
+    C.setJointState(q+.1);
+    C.setJointState(q);
+    ThreadPool pool(4);
+    arr X1(C.frames.N, 7);
+    pool.parallelFor(C.frames.N, [&C, &X1](uint i, uint){ X1[i] = C.frames.elem(i)->get_X().getArr7d(); });
+    CHECK_ZERO(maxDiff(X0, X1), 1e-10, "concurrent get_X differs");
+  }
+
+  //the serial and the parallel pass agree exactly
+  arr q = .5*randn(n);
+  C.fkThreads=0;
+  C.setJointState(q);
+  arr X = C.getFrameState();
+  C.fkThreads=4;
+  C.setJointState(q+.1);
+  C.setJointState(q);
+  CHECK_EQ(X, C.getFrameState(), "parallel pass differs");
+
+  //timing on a deep chain: only the branch below the changed joint is recomputed, in one pass
+  rai::Configuration D;
+  rai::Frame *f = D.addFrame("base");
+  for(uint i=0;i<1000;i++){
+    f = new rai::Frame(f);
+    f->set_Q()->setText("<t(0 0 .01) d(1 0 0 1)>");
+    new rai::Joint(*f, rai::JT_hingeX);
+  }
+  n = D.getJointStateDimension();
+  double time = -rai::cpuTime();
+  for(uint k=0;k<1000;k++){
+    arr q = D.getJointState();
+    q(k%n) += .01;
+    D.setJointState(q);
+    D.frames.last()->ensure_X();
+  }
+  time += rai::cpuTime();
+  cout <<"fwd pass on a 1000-link chain: " <<time <<"ms per setJointState+ensure_X" <<endl;
+
+  //writing the poses of many shallow branches one frame at a time (like pulling the states from a physics engine) stays linear
+  rai::Configuration B;
+  for(uint i=0;i<2000;i++){
+    rai::Frame *b = B.addFrame(STRING("base" <<i));
+    new rai::Frame(b);
+  }
+  time = -rai::cpuTime();
+  for(rai::Frame *b:B.frames) if(b->parent){
+    rai::Transformation X;
+    X.setRandom();
+    b->set_X() = X;
+  }
+  CHECK(B._state_X_pending, "");
+  B.ensure_X();
+  time += rai::cpuTime();
+  cout <<"single frame pose writes on 2000 branches: " <<time <<"sec" <<endl;
+
+  cout <<"** fwd pass success" <<endl;
+}
+
 //===========================================================================
 //
 // Kinematic speed test
@@ -647,12 +1026,18 @@ int MAIN(int argc,char **argv){
 
   testLoadSave();
   testCopy();
+  testCopyOnWrite();
+  testFrameNames();
+  testFramePoses();
+  testFwdPass();
   testGraph();
   testPlayStateSequence();
   testViewerUpdate();
   testKinematics();
   testQuaternionKinematics();
+  testSparseJacobians();
   testKinematicSpeed();
+  testBatchForwardKinematics();
   testFollowRedundantSequence();
   testInverseKinematics();
   //testDynamics();
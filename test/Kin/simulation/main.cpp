@@ -296,6 +296,64 @@ void testCompound(){
 
 //===========================================================================
 
+void testBatch(){
+  //a 7-link arm
+  rai::Configuration C;
+  C.addFrame("base");
+  for(uint i=0;i<7;i++){
+    rai::Frame *f = C.addFrame(STRING("link" <<i), i ? STRING("link" <<i-1) : "base");
+    f->setRelativePosition({0., 0., .2});
+    f->setJoint(i%2 ? rai::JT_hingeY : rai::JT_hingeZ);
+    f->setShape(rai::ST_capsule, {.2, .03});
+  }
+  uint N=32, T=100, n=C.getJointStateDimension();
+  double tau=.01;
+
+  rai::SimulationBatch B(C, N, rai::Simulation::_kinematic, 4);
+  for(uint i=0;i<N;i++) B.C(i).setJointState(.5*randn(n)); //randomized initial states
+  arr q0 = B.get_q();
+  CHECK_EQ(q0.d0, N, "");
+  CHECK_EQ(q0.d1, n, "");
+
+  arr U = randn(N, n);
+  for(uint t=0;t<T;t++) B.step(U, tau, rai::Simulation::_velocity);
+
+  //each simulation is the same as stepping it alone
+  auto checkSerial = [&](rai::SimulationBatch& B, rai::Simulation::SimulatorEngine engine, const arr& q0, uint T){
+    for(uint i=0;i<N;i++){
+      rai::Configuration Ci(C);
+      Ci.setJointState(q0[i]);
+      rai::Simulation S(Ci, engine, 0);
+      for(uint t=0;t<T;t++) S.step(U[i], tau, S._velocity);
+      CHECK_EQ(B.get_q()[i], S.get_q(), "simulation " <<i <<" differs from stepping it alone");
+    }
+  };
+  checkSerial(B, rai::Simulation::_kinematic, q0, T);
+
+#ifdef RAI_BULLET
+  {
+    rai::SimulationBatch B(C, N, rai::Simulation::_bullet, 4);
+    arr q0 = B.get_q();
+    for(uint t=0;t<T;t++) B.step(U, tau, rai::Simulation::_velocity);
+    checkSerial(B, rai::Simulation::_bullet, q0, T);
+  }
+#endif
+
+  //throughput: one worker vs the full pool -- both end in the same states
+  arr q1;
+  for(int threads:{1, 0}){
+    rai::SimulationBatch B(C, N, rai::Simulation::_kinematic, threads);
+    double time = -rai::realTime();
+    for(uint t=0;t<1000;t++){ B.step(U, tau, rai::Simulation::_velocity); B.get_q(); }
+    time += rai::realTime();
+    cout <<"batch of " <<N <<" simulations, " <<(threads?"1 thread":"all threads") <<": " <<1000.*N/time <<" simulation steps/sec" <<endl;
+    if(threads==1) q1 = B.get_q();
+    else CHECK_EQ(B.get_q(), q1, "the threaded batch differs from the serial one");
+  }
+}
+
+//===========================================================================
+
 int main(int argc,char **argv){
   rai::initCmdLine(argc, argv);
 
@@ -306,6 +364,7 @@ int main(int argc,char **argv){
   testOpenClose();
   testGrasp();
   testCompound();
+  testBatch();
 
   return 0;
 }
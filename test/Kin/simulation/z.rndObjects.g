@@ -0,0 +1,31 @@
+obj0 	{  X:[-0.824939, 0.517597, 1.25303, 0.511492, 0.409407, -0.742116, -0.141515], shape:ssBox, size:[0.624281, 0.126042, 0.0880907, 0.01], mass:0.2 }
+obj1 	{  X:[-0.479056, 0.324197, 2.73194, -0.747437, -0.347638, -0.412274, 0.387963], shape:ssBox, size:[0.310962, 0.203585, 0.0566433, 0.01], mass:0.2 }
+obj2 	{  X:[0.375486, 0.537624, 2.51443, -0.132666, 0.452388, 0.217682, 0.854611], shape:ssBox, size:[0.390412, 0.157093, 0.0583518, 0.01], mass:0.2 }
+obj3 	{  X:[-0.55893, 0.748128, 1.32801, -0.162629, 0.333663, 0.808397, -0.456853], shape:ssBox, size:[0.661823, 0.396453, 0.0838944, 0.01], mass:0.2 }
+obj4 	{  X:[-0.625905, 0.226012, 2.88833, -0.0927998, 0.968308, 0.222874, 0.0639844], shape:ssBox, size:[0.575855, 0.145432, 0.111643, 0.01], mass:0.2 }
+obj5 	{  X:[-0.427686, 0.64014, 1.90729, 0.599654, -0.609303, 0.270546, 0.442685], shape:ssBox, size:[0.445215, 0.229801, 0.0863324, 0.01], mass:0.2 }
+obj6 	{  X:[0.388888, 0.280205, 2.8542, -0.428511, 0.871551, 0.206611, -0.118695], shape:ssBox, size:[0.562968, 0.326565, 0.140671, 0.01], mass:0.2 }
+obj7 	{  X:[0.0887547, 0.205014, 1.87365, -0.908163, -0.074915, 0.324438, -0.253707], shape:ssBox, size:[0.379536, 0.172787, 0.186182, 0.01], mass:0.2 }
+obj8 	{  X:[-0.92406, 0.203447, 2.36564, -0.474826, -0.254811, 0.649081, -0.536941], shape:ssBox, size:[0.273108, 0.256103, 0.11249, 0.01], mass:0.2 }
+obj9 	{  X:[-0.765733, 0.293233, 2.29633, 0.031119, 0.710716, 0.460332, -0.531045], shape:ssBox, size:[0.323554, 0.262654, 0.167838, 0.01], mass:0.2 }
+obj10 	{  X:[0.7397, 0.421562, 2.01071, 0.278686, -0.78608, -0.382746, -0.39739], shape:ssBox, size:[0.256605, 0.339072, 0.187131, 0.01], mass:0.2 }
+obj11 	{  X:[-0.877915, 0.30671, 1.59916, -0.276915, -0.417177, 0.712236, 0.491937], shape:ssBox, size:[0.407529, 0.294207, 0.153518, 0.01], mass:0.2 }
+obj12 	{  X:[-0.516599, 0.791002, 2.54827, 0.477767, 0.307955, 0.213621, 0.794524], shape:ssBox, size:[0.706739, 0.27152, 0.166345, 0.01], mass:0.2 }
+obj13 	{  X:[-0.199083, 0.730551, 2.08676, 0.507492, 0.695394, -0.373495, 0.345515], shape:ssBox, size:[0.303433, 0.124742, 0.0914272, 0.01], mass:0.2 }
+obj14 	{  X:[-0.460063, 0.534312, 2.69272, 0.529029, 0.10267, -0.841693, -0.0337495], shape:ssBox, size:[0.260967, 0.150978, 0.0536337, 0.01], mass:0.2 }
+obj15 	{  X:[0.0644903, 0.763334, 1.36737, -0.860713, 0.0963055, 0.236411, 0.440464], shape:ssBox, size:[0.581285, 0.175929, 0.0564765, 0.01], mass:0.2 }
+obj16 	{  X:[-0.419559, 0.780782, 2.49923, -0.80991, 0.431455, -0.17094, 0.358708], shape:ssBox, size:[0.489767, 0.188102, 0.0717372, 0.01], mass:0.2 }
+obj17 	{  X:[0.105469, 0.343688, 2.16412, -0.759996, 0.0377721, 0.359543, -0.5401], shape:ssBox, size:[0.200975, 0.164414, 0.0998077, 0.01], mass:0.2 }
+obj18 	{  X:[-0.202128, 0.623884, 1.58679, -0.358344, 0.142214, -0.900373, -0.201725], shape:ssBox, size:[0.462958, 0.213019, 0.1146, 0.01], mass:0.2 }
+obj19 	{  X:[-0.983022, 0.241348, 1.50833, -0.645165, 0.7618, -0.0402483, 0.042465], shape:ssBox, size:[0.519978, 0.286172, 0.0550522, 0.01], mass:0.2 }
+obj20 	{  X:[0.120784, 0.735535, 2.19836, -0.259968, 0.548374, -0.659076, -0.444209], shape:ssBox, size:[0.584444, 0.333614, 0.0936434, 0.01], mass:0.2 }
+obj21 	{  X:[-0.0822778, 0.315816, 1.77015, 0.83921, -0.474838, 0.201804, -0.171847], shape:ssBox, size:[0.517155, 0.352411, 0.122071, 0.01], mass:0.2 }
+obj22 	{  X:[0.469187, 0.572373, 1.83576, 0.143375, 0.154579, 0.703932, -0.678254], shape:ssBox, size:[0.761019, 0.159863, 0.0676421, 0.01], mass:0.2 }
+obj23 	{  X:[-0.253365, 0.790785, 2.4307, 0.163745, -0.791377, 0.401227, 0.431193], shape:ssBox, size:[0.465047, 0.358734, 0.0561174, 0.01], mass:0.2 }
+obj24 	{  X:[-0.037817, 0.457334, 1.22487, 0.0575713, -0.93382, 0.341742, -0.088756], shape:ssBox, size:[0.417377, 0.227472, 0.0897165, 0.01], mass:0.2 }
+obj25 	{  X:[0.917889, 0.218904, 1.57401, -0.872274, 0.0329756, 0.320666, 0.367727], shape:ssBox, size:[0.526555, 0.175071, 0.186107, 0.01], mass:0.2 }
+obj26 	{  X:[0.536611, 0.284386, 2.17044, -0.581387, 0.778018, -0.0164519, 0.237499], shape:ssBox, size:[0.758919, 0.161058, 0.167272, 0.01], mass:0.2 }
+obj27 	{  X:[-0.302025, 0.494979, 1.69844, -0.46725, 0.406374, -0.461797, 0.635045], shape:ssBox, size:[0.656729, 0.31474, 0.0971469, 0.01], mass:0.2 }
+obj28 	{  X:[-0.0829353, 0.766771, 1.71996, -0.188968, 0.432551, 0.721336, -0.506819], shape:ssBox, size:[0.307823, 0.102718, 0.141831, 0.01], mass:0.2 }
+obj29 	{  X:[0.405766, 0.487003, 1.57147, -0.477083, 0.150828, 0.0514298, 0.86429], shape:ssBox, size:[0.543312, 0.165683, 0.144786, 0.01], mass:0.2 }
+
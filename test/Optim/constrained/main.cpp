@@ -2,6 +2,8 @@
 #include <Optim/benchmarks.h>
 #include "problems.h"
 #include <Optim/constrained.h>
+#include <Optim/MP_Solver.h>
+#include <Optim/interiorPoint.h>
 
 //lecture.cpp:
 void lectureDemo(const shared_ptr<MathematicalProgram>& P, const arr& x_start=NoArr, uint iters=20);
@@ -85,6 +87,195 @@ void TEST(MathematicalProgram){
 
 //==============================================================================
 
+/// a sos cost with many local optima (sinusoids) within a circle constraint
+struct MP_SinusesInCircle : MathematicalProgram {
+  MP_SinusesInCircle() {
+    dimension=2;
+    featureTypes = { OT_sos, OT_sos, OT_sos, OT_sos, OT_ineq };
+    bounds_lo = consts(-2., 2);
+    bounds_up = consts(2., 2);
+  }
+  virtual void evaluate(arr& phi, arr& J, const arr& x) {
+    double a=5.;
+    phi = { sin(a*x(0)), sin(a*x(1)), .3*(x(0)-1.), .3*(x(1)-1.), sumOfSqr(x)-1. };
+    if(!!J) {
+      J = zeros(5, 2);
+      J(0, 0) = a*cos(a*x(0));
+      J(1, 1) = a*cos(a*x(1));
+      J(2, 0) = J(3, 1) = .3;
+      J[4] = 2.*x;
+    }
+  }
+  virtual shared_ptr<MathematicalProgram> clone() { return make_shared<MP_SinusesInCircle>(); }
+};
+
+void TEST(MultiStart){
+  rai::OptOptions opt;
+  opt.set_verbose(0).set_stopTolerance(1e-4);
+  arr x0 = {-1.3, .5};
+
+  //-- a single solve from x0
+  MP_Solver S1;
+  S1.setProblem(make_shared<MP_SinusesInCircle>()).setOptions(opt).setInitialization(x0);
+  auto single = S1.solve();
+  cout <<"single start: " <<*single <<" x: " <<single->x <<endl;
+
+  //-- 16 starts (the first from x0) on 4 workers, none cancelled: the best can't be worse
+  MP_Solver S2;
+  S2.setProblem(make_shared<MP_SinusesInCircle>()).setOptions(opt).setInitialization(x0);
+  S2.setMultiStart(16, -1e10, 4);
+  auto best = S2.solve();
+  cout <<"best of 16: " <<*best <<" x: " <<best->x <<endl;
+  CHECK(best->feasible, "");
+  CHECK_LE(best->sos, single->sos+1e-6, "");
+
+  //-- stop at the first feasible return within the cost tolerance
+  MP_Solver S3;
+  S3.setProblem(make_shared<MP_SinusesInCircle>()).setOptions(opt);
+  S3.setMultiStart(16, best->sos+1e-3, 4);
+  auto first = S3.solve();
+  cout <<"first within tolerance: " <<*first <<" x: " <<first->x <<endl;
+  CHECK(first->feasible, "");
+  CHECK_EQ(S3.x, first->x, "");
+}
+
+//==============================================================================
+
+/// a long chain x_0,..,x_{n-1}: smoothness and tracking (sos) of a sinusoid that violates |x_i|<=1 (ineq), fixed ends (eq), and bounds;
+/// the Jacobian is a SparseMatrix
+struct MP_SparseChain : MathematicalProgram {
+  MP_SparseChain(uint n) {
+    dimension=n;
+    featureTypes = consts(OT_sos, 2*n-1);
+    featureTypes.append(consts(OT_ineq, n));
+    featureTypes.append(consts(OT_eq, 2));
+    bounds_lo = consts(-2., n);
+    bounds_up = consts(2., n);
+  }
+  virtual void evaluate(arr& phi, arr& J, const arr& x) {
+    uint n=dimension, m=featureTypes.N, i, k=0;
+    phi.resize(m);
+    if(!!J) J.sparse().resize(m, n, 4*n);
+    for(i=0; i<n-1; i++) {
+      phi(i) = double(n)*(x(i+1)-x(i))/100.;
+      if(!!J) { J.sparse().entry(i, i+1, k++) = double(n)/100.;  J.sparse().entry(i, i, k++) = -double(n)/100.; }
+    }
+    for(i=0; i<n; i++) {
+      phi(n-1+i) = x(i) - 2.*sin(RAI_2PI*i/n);
+      if(!!J) J.sparse().entry(n-1+i, i, k++) = 1.;
+    }
+    for(i=0; i<n; i++) {
+      phi(2*n-1+i) = x(i)*x(i)-1.;
+      if(!!J) J.sparse().entry(2*n-1+i, i, k++) = 2.*x(i);
+    }
+    phi(3*n-1) = x(0);
+    phi(3*n) = x(n-1);
+    if(!!J) { J.sparse().entry(3*n-1, 0, k++) = 1.;  J.sparse().entry(3*n, n-1, k++) = 1.; }
+    CHECK_EQ(k, 4*n, "");
+  }
+};
+
+void TEST(InteriorPoint){
+  rai::OptOptions opt;
+  opt.set_verbose(0).set_stopTolerance(1e-5);
+
+  //-- small benchmarks: same solution as the augmented Lagrangian
+  for(const shared_ptr<MathematicalProgram>& P : {shared_ptr<MathematicalProgram>(make_shared<MP_HalfCircle>()),
+                                                  shared_ptr<MathematicalProgram>(make_shared<MP_CircleLine>()),
+                                                  shared_ptr<MathematicalProgram>(make_shared<MP_SinusesInCircle>())}){
+    arr x0 = {.1, .1};
+    MP_Solver S1, S2;
+    S1.setProblem(P).setOptions(opt).setInitialization(x0).setSolver(MPS_interiorPoint);
+    S2.setProblem(P).setOptions(opt).setInitialization(x0).setSolver(MPS_augmentedLag);
+    auto ip = S1.solve(), aula = S2.solve();
+    cout <<"interiorPoint: " <<*ip <<" x: " <<ip->x <<"\naugmentedLag:  " <<*aula <<" x: " <<aula->x <<endl;
+    CHECK(ip->feasible, "");
+    CHECK_ZERO(maxDiff(ip->x, aula->x), 1e-3, "");
+  }
+
+  //-- a large sparse problem
+  uint n=100000;
+  auto P = make_shared<MP_SparseChain>(n);
+  arr x = zeros(n), dual;
+  double time = -rai::cpuTime();
+  OptInteriorPoint ip(x, dual, P, opt);
+  ip.run();
+  time += rai::cpuTime();
+  arr err = summarizeErrors(ip.phi, P->featureTypes);
+  cout <<"sparse chain n=" <<n <<": its: " <<ip.its <<" evals: " <<ip.evals <<" time: " <<time <<" errors: " <<err
+       <<" cholesky analyses: " <<ip.cholesky.analyses <<" factorizations: " <<ip.cholesky.factorizations <<endl;
+  CHECK_LE(ip.error(0.), opt.stopTolerance, "");
+  CHECK_LE(err(1)+err(2), 1e-3, "");
+  CHECK_EQ(ip.cholesky.analyses, 1, "the sparsity pattern is constant");
+  CHECK_LE(max(x), 1.+1e-3, "");
+  for(uint i=0; i<dual.N; i++) if(P->featureTypes(i)==OT_ineq) { //nonnegative and complementary
+      CHECK_GE(dual(i), 0., "");
+      if(ip.phi(i)<-1e-2) CHECK_LE(dual(i), 1e-2, "");
+    }
+}
+
+//==============================================================================
+
+/// the same problem, but with the Jacobian returned as dense (0), SparseMatrix (1), CSRMatrix (2), or RowShifted (3)
+struct MP_JacobianFormat : MathematicalProgram {
+  shared_ptr<MathematicalProgram> P;
+  int format;
+  MP_JacobianFormat(const shared_ptr<MathematicalProgram>& P, int format) : P(P), format(format) { copySignature(*P); }
+  virtual void evaluate(arr& phi, arr& J, const arr& x) {
+    P->evaluate(phi, J, x);
+    if(!J) return;
+    if(isSpecial(J)) J = unpack(J);
+    if(format==1) J.sparse();
+    if(format==2) J.csr();
+    if(format==3) J.rowShifted().reshift();
+  }
+};
+
+void TEST(LagrangianFormats){
+  //-- the Lagrangian terms and meta features are the same for all Jacobian formats, and consistent with each other
+  uint n=20;
+  auto P = make_shared<MP_SparseChain>(n);
+  for(uint k=0; k<20; k++) {
+    rai::OptOptions opt;
+    bool useLB = k%2;
+    if(useLB) opt.set_constrainedMethod(rai::logBarrier);
+    arr x = rand(n);
+    if(useLB) x = -.9 + 1.8*x; else x = -2. + 4.*x; //strictly feasible for the log barrier
+    arr lambda = rand(P->featureTypes.N);
+    for(double& l:lambda) if(rnd.uni()<.5) l=0.;
+
+    arr L0, dL0, HL0, phi0, J0;
+    for(int format=0; format<4; format++) {
+      LagrangianProblem L(make_shared<MP_JacobianFormat>(P, format), opt, lambda);
+      L.mu = L.nu = 2.;
+      L.muLB = useLB ? .1 : 0.;
+      arr dL, HL, phi, J;
+      double l = L.lagrangian(dL, HL, x);
+      L.evaluate(phi, J, x);
+      if(!format) {
+        L0 = {l};  dL0 = dL;  HL0 = HL;  phi0 = phi;  J0 = J;
+        CHECK(checkGradient(L, x, 1e-4), "");
+        if(!useLB) { //the meta features of evaluate() define the same L and Gauss-Newton Hessian
+          Conv_MathematicalProgram_ScalarProblem F(shared_ptr<MathematicalProgram>(&L, [](MathematicalProgram*){}));
+          arr g, H;
+          double f = F.scalar(g, H, x);
+          CHECK_ZERO(f-l, 1e-10, "");
+          CHECK_ZERO(maxDiff(g, dL), 1e-10, "");
+          CHECK_ZERO(maxDiff(H, HL), 1e-10, "");
+        }
+      } else {
+        CHECK_ZERO(l-L0.scalar(), 1e-10, "format " <<format);
+        CHECK_ZERO(maxDiff(dL, dL0), 1e-10, "format " <<format);
+        CHECK_ZERO(maxDiff(unpack(HL), HL0), 1e-10, "format " <<format);
+        CHECK_ZERO(maxDiff(phi, phi0), 1e-10, "format " <<format);
+        CHECK_ZERO(maxDiff(unpack(J), J0), 1e-10, "format " <<format);
+      }
+    }
+  }
+}
+
+//==============================================================================
+
 int main(int argc,char** argv){
   rai::initCmdLine(argc,argv);
 
@@ -94,6 +285,10 @@ int main(int argc,char** argv){
 //  RandomLPFunction F;
 //  SimpleConstraintFunction F;
   lectureDemo(F.ptr(), {.2,.2});
+
+  testMultiStart();
+  testInteriorPoint();
+  testLagrangianFormats();
 //  testConstraint2(F);
 
 //  testCoveringSphere();
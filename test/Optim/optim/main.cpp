@@ -44,6 +44,147 @@ void TEST(Solver) {
 
 //===========================================================================
 
+/// a banded nonlinear least-squares problem, like a KOMO path: smoothness between neighbors plus a nonlinear
+/// target term per variable; Gauss-Newton Hessian, dense or sparse
+ScalarFunction chainProblem(uint n, bool sparse){
+  arr t = randn(n);
+  return [n, t, sparse](arr& g, arr& H, const arr& x) -> double {
+    double f=0.;
+    if(!!g) g = zeros(n);
+    if(!!H){
+      if(sparse){ H.clear(); H.sparse().resize(n, n, 0); }
+      else H = zeros(n, n);
+    }
+    auto addH = [&H, sparse](uint i, uint j, double v){ if(sparse) H.sparse().addEntry(i, j) = v; else H(i, j) += v; };
+    for(uint i=0;i<n;i++){
+      double r = sin(x(i)) + x(i) - t(i), dr = cos(x(i)) + 1.;
+      f += r*r;
+      if(!!g) g(i) += 2.*r*dr;
+      if(!!H) addH(i, i, 2.*dr*dr);
+      if(i+1<n){
+        double s = 10.*(x(i+1)-x(i));
+        f += s*s;
+        if(!!g){ g(i) -= 20.*s;  g(i+1) += 20.*s; }
+        if(!!H){ addH(i, i, 200.);  addH(i+1, i+1, 200.);  addH(i, i+1, -200.);  addH(i+1, i, -200.); }
+      }
+    }
+    return f;
+  };
+}
+
+void TEST(NewtonCG) {
+  uint n=1000;
+  for(bool sparse:{true, false}){
+    rnd.seed(0);
+    ScalarFunction f = chainProblem(n, sparse);
+    arr x0 = .5*rand(n)-.25, lo = -.5*ones(n), up = .5*ones(n); //some bounds are active at the optimum
+
+    //the same bounded problem with factored Newton steps, and CG steps with diagonal and block-Jacobi preconditioner
+    double fOpt=0.;
+    for(int blockSize:{0, 1, 10}){
+      rai::OptOptions opt;
+      opt.verbose=0;
+      opt.stopTolerance=1e-6;
+      opt.maxStep=1.;
+      opt.damping=1e-2;
+      opt.newtonCG = blockSize>0;
+      opt.newtonCGBlockSize = blockSize;
+      opt.newtonCGForcing = 1e-3;
+      arr x = x0;
+      OptNewton newton(x, f, opt);
+      newton.setBounds(lo, up);
+      double time = -rai::cpuTime();
+      newton.run();
+      time += rai::cpuTime();
+      CHECK(boundCheck(x, lo, up), "");
+      cout <<(sparse?"sparse":"dense") <<(blockSize ? STRING(" Newton-CG, block size " <<blockSize) : STRING(" Newton")) <<": f=" <<newton.fx
+          <<" its=" <<newton.its <<" cg its=" <<newton.itsCG <<" time=" <<time <<"sec" <<endl;
+      if(!blockSize) fOpt=newton.fx;
+      else CHECK_ZERO(newton.fx-fOpt, 1e-4*(1.+fOpt), "Newton-CG converged elsewhere");
+    }
+  }
+}
+
+//===========================================================================
+
+/// the chain problem as a MathematicalProgram with a triplet-sparse Jacobian: sos residuals, an f-term with explicit Hessian,
+/// and optionally an equality constraint
+struct ChainProgram : MathematicalProgram {
+  arr t;
+  ChainProgram(uint n, bool constrained) {
+    dimension = n;
+    t = randn(n);
+    featureTypes.resize(2*n+constrained);
+    for(uint i=0;i<featureTypes.N;i++) featureTypes(i) = OT_sos;
+    featureTypes(2*n-1) = OT_f;
+    if(constrained) featureTypes(2*n) = OT_eq;
+  }
+  void evaluate(arr& phi, arr& J, const arr& x){
+    uint n=dimension;
+    phi = zeros(featureTypes.N);
+    if(!!J){ J.clear(); J.sparse().resize(phi.N, n, 0); }
+    for(uint i=0;i<n;i++){
+      phi(i) = sin(x(i)) + x(i) - t(i);
+      if(!!J) J.sparse().addEntry(i, i) = cos(x(i)) + 1.;
+      if(i+1<n){
+        phi(n+i) = 10.*(x(i+1)-x(i));
+        if(!!J){ J.sparse().addEntry(n+i, i) = -10.;  J.sparse().addEntry(n+i, i+1) = 10.; }
+      }
+      phi(2*n-1) += .1*rai::sqr(rai::sqr(x(i)));
+      if(!!J) J.sparse().addEntry(2*n-1, i) = .4*x(i)*x(i)*x(i);
+      if(phi.N>2*n){
+        phi(2*n) += x(i);
+        if(!!J) J.sparse().addEntry(2*n, i) = 1.;
+      }
+    }
+  }
+  void getFHessian(arr& H, const arr& x){
+    H.clear();
+    H.sparse().resize(dimension, dimension, 0);
+    for(uint i=0;i<dimension;i++) H.sparse().addEntry(i, i) = 1.2*x(i)*x(i);
+  }
+};
+
+void TEST(FactoredNewtonCG) {
+  //the factored products agree with the assembled Hessian J^T diag(coeff) J + F
+  rnd.seed(0);
+  ChainProgram P(50, false);
+  arr x = randn(50), phi, J, F;
+  P.evaluate(phi, J, x);
+  P.getFHessian(F, x);
+  arr coeff = rand(phi.N);
+  FactoredHessian Hf;
+  Hf.set(J, coeff, F);
+  arr H = comp_At_A(J, coeff);
+  H = H.sparse().unsparse() + F.sparse().unsparse();
+  arr v = randn(50), Hv;
+  Hf.times(Hv, v);
+  CHECK_ZERO(maxDiff(Hv, H*v), 1e-10, "");
+  CHECK_ZERO(maxDiff(Hf.diag(), getDiag(H)), 1e-10, "");
+
+  //MP_Solver's newton and the constrained solvers with CG steps on the factors find the same optimum as with assembled Hessians
+  for(MP_SolverID sid:{MPS_newton, MPS_augmentedLag}){
+    rnd.seed(0);
+    auto P = make_shared<ChainProgram>(200, sid==MPS_augmentedLag);
+    arr x0 = .5*rand(200)-.25;
+    arr xOpt;
+    for(bool cg:{false, true}){
+      MP_Solver S;
+      S.setProblem(P).setSolver(sid).setInitialization(x0);
+      S.opt.verbose=0;
+      S.opt.stopTolerance=1e-6;
+      S.opt.newtonCG=cg;
+      S.opt.newtonCGForcing=1e-3;
+      auto ret = S.solve();
+      cout <<(sid==MPS_newton?"newton":"augmentedLag") <<(cg?" factored Newton-CG: ":": ") <<*ret <<endl;
+      if(!cg) xOpt = ret->x;
+      else CHECK_ZERO(maxDiff(ret->x, xOpt), 1e-3, "factored Newton-CG converged elsewhere");
+    }
+  }
+}
+
+//===========================================================================
+
 int MAIN(int argc,char** argv){
   rai::initCmdLine(argc,argv);
 
@@ -51,6 +192,8 @@ int MAIN(int argc,char** argv){
 
   testDisplay();
   testSolver();
+  testNewtonCG();
+  testFactoredNewtonCG();
 
   return 0;
 }